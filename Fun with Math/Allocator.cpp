@@ -0,0 +1,221 @@
+#include "stdafx.h"
+#include "Allocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace la {
+	namespace {
+		// Blocks from 2^minBits up to 2^maxBits bytes are pooled in subClasses
+		// classes per power of two. Rounding larger ones up that far would cost
+		// more memory than reusing them saves.
+		const size_t minBits = 6;
+		const size_t maxBits = 20;
+		const size_t subClasses = 4;
+		const size_t classCount = (maxBits - minBits) * subClasses + 1;
+		// Every thread caches at most this many bytes of free blocks, and at most
+		// this many blocks of each class
+		const size_t maxCachedBytes = size_t(1) << 25;
+		const size_t maxCachedBlocks = 16;
+		// Larger blocks are rounded up to whole pages and cached in a short list.
+		// A cached block serves requests up to 1/largeSlack smaller than it.
+		const size_t pageBytes = 4096;
+		const size_t maxLargeBlocks = 4;
+		const size_t largeSlack = 8;
+
+		std::atomic<size_t> g_requests{ 0 };
+		std::atomic<size_t> g_releases{ 0 };
+		std::atomic<size_t> g_systemAllocations{ 0 };
+		std::atomic<size_t> g_systemBytes{ 0 };
+
+		// Smallest class whose blocks hold the given amount of bytes, classCount
+		// if there is none. Class 0 holds 2^minBits bytes, the classes above
+		// split every interval (2^k, 2^(k+1)] into subClasses equal steps.
+		size_t size_class(size_t bytes) noexcept {
+			if (bytes <= (size_t(1) << minBits)) { return 0; }
+			if (bytes > (size_t(1) << maxBits)) { return classCount; }
+
+			size_t k = minBits;
+			while ((size_t(2) << k) < bytes) { k++; }
+			size_t step = (size_t(1) << k) / subClasses;
+			size_t sub = (bytes - (size_t(1) << k) + step - 1) / step;
+			return 1 + (k - minBits) * subClasses + (sub - 1);
+		}
+
+		// Size of the blocks of a class
+		size_t class_bytes(size_t c) noexcept {
+			if (c == 0) { return size_t(1) << minBits; }
+			size_t k = minBits + (c - 1) / subClasses;
+			size_t sub = (c - 1) % subClasses + 1;
+			return (size_t(1) << k) + sub * ((size_t(1) << k) / subClasses);
+		}
+
+		void* system_allocate(size_t bytes) {
+			void *p = ::operator new(bytes, std::align_val_t(storage_alignment));
+			g_systemAllocations.fetch_add(1, std::memory_order_relaxed);
+			g_systemBytes.fetch_add(bytes, std::memory_order_relaxed);
+			return p;
+		}
+
+		void system_deallocate(void *p) noexcept {
+			::operator delete(p, std::align_val_t(storage_alignment));
+		}
+
+		// Large blocks start with a header of storage_alignment bytes holding
+		// their size, the storage handed out follows it
+		struct large_block {
+			void *base = nullptr;
+			size_t bytes = 0;
+		};
+
+		// Free blocks of one thread by size class
+		struct pool {
+			std::vector<void *> blocks[classCount];
+			large_block large[maxLargeBlocks];
+			size_t largeCount = 0;
+			size_t cached = 0;
+
+			~pool();
+			void release() noexcept;
+		};
+
+		thread_local pool t_pool;
+		// Set once the pool of the thread is destroyed, storage freed afterwards
+		// by destructors of static objects goes to the system directly
+		thread_local bool t_poolDestroyed = false;
+
+		pool::~pool() {
+			release();
+			t_poolDestroyed = true;
+		}
+
+		void pool::release() noexcept {
+			for (auto &list : blocks) {
+				for (void *p : list) { system_deallocate(p); }
+				list.clear();
+			}
+			for (size_t i = 0; i < largeCount; i++) {
+				system_deallocate(large[i].base);
+			}
+			largeCount = 0;
+			cached = 0;
+		}
+
+		// Reuse a cached large block of at least the rounded size, else take a
+		// new one from the system
+		void* large_allocate(size_t bytes) {
+			if (bytes > std::numeric_limits<size_t>::max() - pageBytes - storage_alignment) {
+				throw std::bad_alloc();
+			}
+			size_t rounded = (bytes + pageBytes - 1) / pageBytes * pageBytes;
+			if (!t_poolDestroyed) {
+				pool &p = t_pool;
+				for (size_t i = 0; i < p.largeCount; i++) {
+					large_block block = p.large[i];
+					if (block.bytes >= rounded && block.bytes - rounded <= rounded / largeSlack) {
+						std::copy(p.large + i + 1, p.large + p.largeCount, p.large + i);
+						p.largeCount--;
+						p.cached -= block.bytes;
+						return static_cast<char *>(block.base) + storage_alignment;
+					}
+				}
+			}
+
+			void *base = system_allocate(rounded + storage_alignment);
+			*static_cast<size_t *>(base) = rounded;
+			return static_cast<char *>(base) + storage_alignment;
+		}
+
+		// Cache a large block, the oldest cached ones make room for it. Blocks
+		// the small classes hold are not evicted.
+		void large_deallocate(void *p) noexcept {
+			large_block block;
+			block.base = static_cast<char *>(p) - storage_alignment;
+			block.bytes = *static_cast<size_t *>(block.base);
+			if (t_poolDestroyed || block.bytes > maxCachedBytes) {
+				system_deallocate(block.base);
+				return;
+			}
+
+			pool &cache = t_pool;
+			while (cache.largeCount > 0 &&
+				(cache.largeCount == maxLargeBlocks || cache.cached + block.bytes > maxCachedBytes)) {
+				system_deallocate(cache.large[0].base);
+				cache.cached -= cache.large[0].bytes;
+				std::copy(cache.large + 1, cache.large + cache.largeCount, cache.large);
+				cache.largeCount--;
+			}
+			if (cache.cached + block.bytes > maxCachedBytes) {
+				system_deallocate(block.base);
+				return;
+			}
+
+			cache.large[cache.largeCount++] = block;
+			cache.cached += block.bytes;
+		}
+	}
+
+	allocation_counters allocation_statistics() noexcept {
+		allocation_counters counters;
+		counters.requests = g_requests.load(std::memory_order_relaxed);
+		counters.releases = g_releases.load(std::memory_order_relaxed);
+		counters.systemAllocations = g_systemAllocations.load(std::memory_order_relaxed);
+		counters.systemBytes = g_systemBytes.load(std::memory_order_relaxed);
+		return counters;
+	}
+
+	void reset_allocation_statistics() noexcept {
+		g_requests = 0;
+		g_releases = 0;
+		g_systemAllocations = 0;
+		g_systemBytes = 0;
+	}
+
+	void* pool_allocate(size_t bytes) {
+		g_requests.fetch_add(1, std::memory_order_relaxed);
+
+		size_t c = size_class(bytes);
+		if (c == classCount) { return large_allocate(bytes); }
+		if (t_poolDestroyed) { return system_allocate(class_bytes(c)); }
+
+		std::vector<void *> &list = t_pool.blocks[c];
+		if (list.empty()) { return system_allocate(class_bytes(c)); }
+
+		void *p = list.back();
+		list.pop_back();
+		t_pool.cached -= class_bytes(c);
+		return p;
+	}
+
+	void pool_deallocate(void *p, size_t bytes) noexcept {
+		if (p == nullptr) { return; }
+		g_releases.fetch_add(1, std::memory_order_relaxed);
+
+		size_t c = size_class(bytes);
+		if (c == classCount) {
+			large_deallocate(p);
+			return;
+		}
+		if (t_poolDestroyed || t_pool.blocks[c].size() >= maxCachedBlocks ||
+			t_pool.cached + class_bytes(c) > maxCachedBytes) {
+			system_deallocate(p);
+			return;
+		}
+
+		// Keeping the block is only an optimization
+		try {
+			t_pool.blocks[c].push_back(p);
+			t_pool.cached += class_bytes(c);
+		}
+		catch (const std::bad_alloc &) {
+			system_deallocate(p);
+		}
+	}
+
+	void pool_release() noexcept {
+		if (!t_poolDestroyed) { t_pool.release(); }
+	}
+}
\ No newline at end of file
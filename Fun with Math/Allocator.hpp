@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+namespace la {
+	// Alignment of all pooled storage. Rows of matrices start on cache lines and
+	// full AVX-512 registers can be loaded from them.
+	constexpr size_t storage_alignment = 64;
+
+	// Counters of the storage requests of all threads since the last reset.
+	// Blocks a pool hands out again count as requests but not as system
+	// allocations, so a loop has reached its steady state once the system
+	// allocations stop growing. Loops whose blocks exceed the 32 MB a thread
+	// keeps always reach the system.
+	struct allocation_counters {
+		size_t requests = 0;
+		size_t releases = 0;
+		size_t systemAllocations = 0;
+		size_t systemBytes = 0;
+	};
+
+	// Read the counters
+	allocation_counters allocation_statistics() noexcept;
+	// Set all counters to 0
+	void reset_allocation_statistics() noexcept;
+
+	// Storage of at least the given amount of bytes aligned to storage_alignment.
+	// Requests up to 1 MB are rounded up to one of four size classes per power
+	// of two, at most 25% extra, and freed blocks are kept in a small pool of
+	// the freeing thread for the next request of their class. Larger requests
+	// are rounded up to whole pages, the pool keeps a few of them and hands
+	// them out again for requests at most 12.5% smaller. A thread keeps at most
+	// 32 MB, blocks beyond that go back to the system.
+	// Throws std::bad_alloc if the system has no memory left
+	void* pool_allocate(size_t);
+	// Return storage, the size has to be the one it was requested with
+	void pool_deallocate(void *, size_t) noexcept;
+	// Give the blocks cached by the pool of the calling thread back to the system
+	void pool_release() noexcept;
+
+	// Standard conforming allocator on top of the pool
+	template<typename T>
+	class allocator {
+	public:
+		using value_type = T;
+
+		// Constructors
+		allocator() noexcept = default;
+		template<typename U>
+		allocator(const allocator<U> &) noexcept;
+
+		// Storage for n objects, not constructed
+		// Throws std::bad_array_new_length if the size overflows
+		T* allocate(size_t);
+		void deallocate(T *, size_t) noexcept;
+
+		// All instances share the pools
+		template<typename U>
+		bool operator==(const allocator<U> &) const noexcept;
+		template<typename U>
+		bool operator!=(const allocator<U> &) const noexcept;
+	};
+
+	// Allocator la::matrix and la::vector of T take their storage from.
+	// Specialize it to plug in another allocator, which has to be stateless
+	// and provide allocate and deallocate like std::allocator.
+	template<typename T>
+	struct matrix_allocator {
+		using type = allocator<T>;
+	};
+
+	template<typename T>
+	using matrix_allocator_t = typename matrix_allocator<T>::type;
+
+	// Converting constructor required for rebinding
+	template<typename T>
+	template<typename U>
+	allocator<T>::allocator(const allocator<U> &) noexcept
+	{}
+
+	// Take storage for n objects from the pool
+	template<typename T>
+	T* allocator<T>::allocate(size_t n) {
+		static_assert(alignof(T) <= storage_alignment, "Type needs a larger alignment than the pool provides.");
+		if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+			throw std::bad_array_new_length();
+		}
+		return static_cast<T *>(pool_allocate(n * sizeof(T)));
+	}
+
+	// Return storage for n objects to the pool
+	template<typename T>
+	void allocator<T>::deallocate(T *p, size_t n) noexcept {
+		pool_deallocate(p, n * sizeof(T));
+	}
+
+	// Storage of one allocator can be freed by any other
+	template<typename T>
+	template<typename U>
+	bool allocator<T>::operator==(const allocator<U> &) const noexcept {
+		return true;
+	}
+
+	// Storage of one allocator can be freed by any other
+	template<typename T>
+	template<typename U>
+	bool allocator<T>::operator!=(const allocator<U> &) const noexcept {
+		return false;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,705 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "BigInteger.hpp"
+#include "Matrix.hpp"
+#include "ModuleRing.hpp"
+#include "ThreadPool.hpp"
+#include "Vector.hpp"
+
+namespace la {
+	// Gaussian elimination without fractions for entry types with exact
+	// arithmetic, integers and module_ring<m>.
+	//
+	// Integers are eliminated by Bareiss' algorithm: below pivot p the entries
+	// become a_ij = (p * a_ij - a_ic * a_rj) / p' with p' the previous pivot.
+	// The division is always exact and every entry stays a minor of the
+	// original matrix, so nothing grows beyond the determinant, which is the
+	// last pivot up to the sign of the row swaps. Products are formed in a type
+	// of twice the width of T, every result is checked to fit T. Unsigned
+	// matrices have negative minors and are eliminated as long long, their
+	// results have to be nonnegative and fit T again.
+	//
+	// Residue classes are eliminated with the inverse of a unit pivot. A column
+	// with nonzero entries but no unit, only possible for composite m, is
+	// cleared by the euclidean algorithm on its rows, which neither divides
+	// nor changes the determinant.
+	template<typename T = long long>
+	class bareiss {
+	public:
+		// Type of the eliminated entries
+		using entry_type = std::conditional_t<std::is_unsigned_v<T>, long long, T>;
+
+	private:
+		static_assert(exact_arithmetic<T>::value, "Bareiss elimination needs exact arithmetic.");
+
+		// Row echelon form
+		matrix<entry_type> m_echelon;
+		// Eliminated matrix, solving eliminates it again next to the right-hand
+		// side
+		matrix<entry_type> m_matrix;
+		// Column of the pivot of every nonzero row of the echelon form
+		std::vector<size_t> m_pivots;
+		// Whether the number of row swaps is odd
+		bool m_negate = false;
+
+		// Eliminate in place, searching pivots only in the given number of
+		// leading columns
+		static void eliminate(matrix<entry_type> &, size_t, std::vector<size_t> &, bool &);
+		// Throws std::invalid_argument if the matrix is not quadratic
+		void check_quadratic() const;
+		// Conversions between T and the eliminated entries
+		// Throw std::overflow_error if the value does not fit
+		static entry_type widen(T);
+		static T narrow(entry_type);
+		// Determinant and scaled solution before they are narrowed to T
+		entry_type determinant_entry() const;
+		vector<entry_type> solve_scaled_entries(const vector<T> &) const;
+
+	public:
+		// Constructors
+
+		// Eliminate a matrix
+		// Throws std::overflow_error if an integer minor exceeds the range of
+		// entry_type
+		explicit bareiss(const matrix<T> &);
+
+		// Getter
+		size_t size() const noexcept;
+		size_t rows() const noexcept;
+		size_t columns() const noexcept;
+		const std::vector<size_t>& pivots() const noexcept;
+
+		// Row echelon form, for integers the entries are minors of the matrix
+		const matrix<entry_type>& echelon() const noexcept;
+		// Number of nonzero rows of the echelon form. This is the rank for
+		// integers and prime m, for composite m it depends on the rows.
+		size_t rank() const noexcept;
+
+		// Algorithms using the elimination
+		// All of them throw std::invalid_argument if the matrix is not
+		// quadratic, the solvers also if it is not invertible. Integer results
+		// throw std::overflow_error if they exceed the range of T, unsigned
+		// ones also if they are negative.
+		T determinant() const;
+		// Integer solutions throw std::runtime_error if they are not integral
+		vector<T> solve(const vector<T> &) const;
+		// det(A) * x = adj(A) * b, integral for every integer system
+		vector<T> solve_scaled(const vector<T> &) const;
+	};
+
+	// Exact determinant of an integer matrix of any size and entry range.
+	// The determinant is computed modulo 31 bit primes until their product
+	// exceeds twice Hadamard's bound |det A| <= prod ||a_i||. The primes are
+	// independent of each other and eliminated in parallel, the residues are
+	// put together by the chinese remainder theorem.
+	// Throws std::invalid_argument if the matrix is not quadratic
+	template<typename T>
+	big_integer determinant_multimodular(const matrix<T> &);
+
+	namespace detail {
+		// Signed 128 bit integer of two limbs in two's complement for compilers
+		// without __int128, with just the operations Bareiss' algorithm needs
+		struct int128 {
+			uint64_t low = 0, high = 0;
+
+			constexpr int128() noexcept = default;
+			constexpr int128(long long v) noexcept
+				: low(static_cast<uint64_t>(v)), high(v < 0 ? ~uint64_t(0) : 0) {}
+
+			constexpr bool negative() const noexcept {
+				return (high >> 63) != 0;
+			}
+
+			// Whether the value is the sign extension of its low limb
+			constexpr bool fits_64() const noexcept {
+				return high == ((low >> 63) != 0 ? ~uint64_t(0) : 0);
+			}
+
+			constexpr int128 operator-() const noexcept {
+				int128 r;
+				r.low = ~low + 1;
+				r.high = ~high + (low == 0 ? 1 : 0);
+				return r;
+			}
+
+			friend constexpr int128 operator-(const int128 &a, const int128 &b) noexcept {
+				int128 r;
+				r.low = a.low - b.low;
+				r.high = a.high - b.high - (a.low < b.low ? 1 : 0);
+				return r;
+			}
+
+			// Full product of two magnitudes from 32 bit halves
+			static constexpr int128 multiply_unsigned(uint64_t a, uint64_t b) noexcept {
+				uint64_t a0 = a & 0xffffffffu, a1 = a >> 32;
+				uint64_t b0 = b & 0xffffffffu, b1 = b >> 32;
+				uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+				uint64_t middle = (p00 >> 32) + (p01 & 0xffffffffu) + (p10 & 0xffffffffu);
+				int128 r;
+				r.low = (middle << 32) | (p00 & 0xffffffffu);
+				r.high = p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32);
+				return r;
+			}
+
+			static constexpr uint64_t magnitude(long long v) noexcept {
+				return v < 0 ? ~static_cast<uint64_t>(v) + 1 : static_cast<uint64_t>(v);
+			}
+
+			static constexpr int128 multiply(long long a, long long b) noexcept {
+				int128 r = multiply_unsigned(magnitude(a), magnitude(b));
+				return (a < 0) != (b < 0) ? -r : r;
+			}
+
+			// Quotient of magnitudes by shifting and subtracting, false if it
+			// does not fit 64 bit
+			static constexpr bool divide_unsigned(int128 a, uint64_t b, uint64_t &q) noexcept {
+				if (a.high >= b) { return false; }
+				uint64_t remainder = a.high;
+				q = 0;
+				for (int bit = 63; bit >= 0; bit--) {
+					bool carry = (remainder >> 63) != 0;
+					remainder = (remainder << 1) | ((a.low >> bit) & 1);
+					if (carry || remainder >= b) {
+						remainder -= b;
+						q |= uint64_t(1) << bit;
+					}
+				}
+				return true;
+			}
+		};
+
+		// Integer arithmetic of Bareiss' algorithm. Products are formed in a type
+		// of twice the width of T, two limbs where the compiler has no 128 bit
+		// integer, or in T itself with explicit overflow checks for wider T.
+		template<typename T>
+		struct exact_integer {
+#ifdef __SIZEOF_INT128__
+			using wide_type = std::conditional_t<(sizeof(T) < 8), long long,
+				std::conditional_t<(sizeof(T) == 8), __int128, T>>;
+#else
+			using wide_type = std::conditional_t<(sizeof(T) < 8), long long,
+				std::conditional_t<(sizeof(T) == 8), int128, T>>;
+#endif
+			static constexpr bool checked = std::is_same_v<wide_type, T>;
+			static constexpr bool limbs = std::is_same_v<wide_type, int128>;
+			static constexpr T min = std::numeric_limits<T>::min();
+			static constexpr T max = std::numeric_limits<T>::max();
+
+			[[noreturn]] static void overflow() {
+				throw std::overflow_error("Exact result exceeds the range of the entry type.");
+			}
+
+			static wide_type multiply(T a, T b) {
+				if constexpr (checked) {
+					bool overflows = a > 0 ? (b > 0 ? a > max / b : b < min / a) :
+						(b > 0 ? a < min / b : a != 0 && b < max / a);
+					if (overflows) { overflow(); }
+				}
+				if constexpr (limbs) {
+					return int128::multiply(a, b);
+				}
+				else {
+					return wide_type(a) * b;
+				}
+			}
+
+			// Difference of two products, which always fits the wide type since
+			// the products are at most 2^(2w-2) in magnitude
+			static wide_type subtract(wide_type a, wide_type b) {
+				if constexpr (checked) {
+					if ((b < 0 && a > max + b) || (b > 0 && a < min + b)) { overflow(); }
+				}
+				return a - b;
+			}
+
+			// Subtract a product from a running sum, which is kept below 2^(2w-2)
+			// in magnitude so the next subtraction can not overflow
+			static wide_type accumulate(wide_type a, wide_type b) {
+				wide_type r = subtract(a, b);
+				if constexpr (limbs) {
+					const uint64_t limit = uint64_t(1) << 62;
+					bool outside = r.negative() ? (-r).high >= limit : r.high >= limit;
+					if (outside) { overflow(); }
+				}
+				else if constexpr (!checked) {
+					const wide_type limit = wide_type(1) << (8 * sizeof(wide_type) - 2);
+					if (r >= limit || r <= -limit) { overflow(); }
+				}
+				return r;
+			}
+
+			// Quotient of an exact division, narrowed to T
+			static T divide(wide_type a, wide_type b) {
+				if constexpr (limbs) {
+					// Both operands are 64 bit most of the time
+					if (a.fits_64() && b.fits_64() && static_cast<long long>(b.low) != -1) {
+						return T(static_cast<long long>(a.low) / static_cast<long long>(b.low));
+					}
+					// Divisors are entries of T
+					if (!b.fits_64()) { overflow(); }
+					uint64_t magnitude = 0;
+					if (!int128::divide_unsigned(a.negative() ? -a : a, b.negative() ? (-b).low : b.low, magnitude)) {
+						overflow();
+					}
+					bool negative = a.negative() != b.negative();
+					if (magnitude > (negative ? uint64_t(max) + 1 : uint64_t(max))) { overflow(); }
+					return negative ? T(~magnitude + 1) : T(magnitude);
+				}
+				else {
+					wide_type q;
+					if constexpr (sizeof(wide_type) > 8) {
+						// Division of 128 bit integers is slow, most operands fit 64 bit
+						if (wide_type(int64_t(a)) == a && wide_type(int64_t(b)) == b && b != -1) {
+							q = int64_t(a) / int64_t(b);
+						}
+						else {
+							q = a / b;
+						}
+					}
+					else {
+						if (b == -1 && a == std::numeric_limits<wide_type>::min()) { overflow(); }
+						q = a / b;
+					}
+
+					if (q < min || q > max) { overflow(); }
+					return T(q);
+				}
+			}
+
+			static T negate(T a) {
+				if (a == min) { overflow(); }
+				return -a;
+			}
+		};
+
+		// Miller-Rabin test with the bases 2, 7 and 61, which is deterministic
+		// for all numbers below 2^32
+		inline bool is_prime(uint32_t n) noexcept {
+			if (n < 2) { return false; }
+			for (uint32_t p : { 2u, 3u, 5u, 7u, 61u }) {
+				if (n % p == 0) { return n == p; }
+			}
+
+			uint32_t d = n - 1;
+			unsigned s = 0;
+			while (d % 2 == 0) {
+				d /= 2;
+				s++;
+			}
+
+			for (uint64_t a : { 2u, 7u, 61u }) {
+				uint64_t x = 1;
+				for (uint64_t base = a, e = d; e != 0; e >>= 1) {
+					if (e & 1) { x = x * base % n; }
+					base = base * base % n;
+				}
+				if (x == 1 || x == n - 1) { continue; }
+
+				bool composite = true;
+				for (unsigned r = 1; r < s && composite; r++) {
+					x = x * x % n;
+					composite = x != n - 1;
+				}
+				if (composite) { return false; }
+			}
+			return true;
+		}
+
+		// Determinant modulo a prime by gaussian elimination with inverses
+		template<typename T>
+		uint32_t determinant_mod(const matrix<T> &m, uint32_t p) {
+			size_t n = m.rows();
+			std::vector<uint64_t> a(n * n);
+			for (size_t i = 0; i < n * n; i++) {
+				T v = m.data()[i];
+				if constexpr (std::is_unsigned_v<T>) {
+					a[i] = static_cast<uint64_t>(v % p);
+				}
+				else {
+					long long r = static_cast<long long>(v) % static_cast<long long>(p);
+					a[i] = static_cast<uint64_t>(r < 0 ? r + p : r);
+				}
+			}
+
+			uint64_t det = 1;
+			for (size_t c = 0; c < n; c++) {
+				size_t r = c;
+				while (r < n && a[r * n + c] == 0) { r++; }
+				if (r == n) { return 0; }
+				if (r != c) {
+					std::swap_ranges(a.begin() + r * n, a.begin() + (r + 1) * n, a.begin() + c * n);
+					det = p - det;
+				}
+
+				det = det * a[c * n + c] % p;
+				uint64_t inverse = inverse_mod(static_cast<uint32_t>(a[c * n + c]), p);
+				for (size_t i = c + 1; i < n; i++) {
+					uint64_t f = a[i * n + c] * inverse % p;
+					if (f == 0) { continue; }
+					for (size_t j = c + 1; j < n; j++) {
+						a[i * n + j] = (a[i * n + j] + (p - f) * a[c * n + j]) % p;
+					}
+				}
+			}
+			return static_cast<uint32_t>(det % p);
+		}
+	}
+
+	// Eliminate the matrix and keep it for solving
+	template<typename T>
+	bareiss<T>::bareiss(const matrix<T> &m)
+		: m_echelon(m.rows(), m.columns()) {
+		std::transform(m.data(), m.data() + m.rows() * m.columns(), m_echelon.data(), widen);
+		m_matrix = m_echelon;
+		eliminate(m_echelon, m.columns(), m_pivots, m_negate);
+	}
+
+	// Column by column: choose a pivot, move it up, then update all rows below
+	// in parallel. Columns without a pivot are skipped, so rectangular and
+	// singular matrices end up in row echelon form.
+	template<typename T>
+	void bareiss<T>::eliminate(matrix<entry_type> &m, size_t pivotColumns, std::vector<size_t> &pivots, bool &negate) {
+		using E = entry_type;
+		const size_t minEntriesPerTask = 1 << 14;
+
+		size_t rows = m.rows();
+		size_t n = m.columns();
+		E *a = m.data();
+		E previous = E(1);
+		size_t r = 0;
+
+		for (size_t c = 0; c < pivotColumns && r < rows; c++) {
+			size_t p = r;
+			while (p < rows && a[p * n + c] == E(0)) { p++; }
+			// The column is 0 below the eliminated rows
+			if (p == rows) { continue; }
+
+			bool cleared = false;
+			if constexpr (!std::is_integral_v<E>) {
+				// Prefer a unit, a pivot that can be inverted
+				const uint32_t mod = ring_modulus<E>::value;
+				size_t unit = p;
+				while (unit < rows && inverse_mod(a[unit * n + c].value(), mod) == 0) { unit++; }
+
+				if (unit < rows) {
+					p = unit;
+				}
+				else {
+					// Euclidean algorithm between row r and every row below, the
+					// values of the residues decrease like integers
+					if (p != r) {
+						std::swap_ranges(a + r * n, a + (r + 1) * n, a + p * n);
+						negate = !negate;
+					}
+					for (size_t i = r + 1; i < rows; i++) {
+						while (a[i * n + c] != E(0)) {
+							E q = E(a[r * n + c].value() / a[i * n + c].value());
+							for (size_t j = c; j < n; j++) {
+								a[r * n + j] -= q * a[i * n + j];
+							}
+							std::swap_ranges(a + r * n, a + (r + 1) * n, a + i * n);
+							negate = !negate;
+						}
+					}
+					cleared = true;
+				}
+			}
+
+			if (!cleared) {
+				if (p != r) {
+					std::swap_ranges(a + r * n, a + (r + 1) * n, a + p * n);
+					negate = !negate;
+				}
+
+				E pivot = a[r * n + c];
+				size_t rowsPerTask = std::max<size_t>(minEntriesPerTask / (n - c), 1);
+				thread_pool::instance().parallel_for(r + 1, rows, rowsPerTask,
+					[a, n, r, c, pivot, previous](size_t first, size_t last) {
+					for (size_t i = first; i < last; i++) {
+						E *row = a + i * n;
+						const E *pivotRow = a + r * n;
+						if constexpr (std::is_integral_v<E>) {
+							// Rows with a 0 below the pivot are scaled as well
+							using ops = detail::exact_integer<E>;
+							E f = row[c];
+							for (size_t j = c + 1; j < n; j++) {
+								row[j] = ops::divide(ops::subtract(ops::multiply(pivot, row[j]),
+									ops::multiply(f, pivotRow[j])), previous);
+							}
+						}
+						else {
+							if (row[c] == E(0)) { continue; }
+							E f = row[c] * E(inverse_mod(pivot.value(), ring_modulus<E>::value));
+							for (size_t j = c + 1; j < n; j++) {
+								row[j] -= f * pivotRow[j];
+							}
+						}
+						row[c] = E(0);
+					}
+				});
+				previous = pivot;
+			}
+
+			pivots.push_back(c);
+			r++;
+		}
+	}
+
+	// Throw if solving or the determinant are not defined
+	template<typename T>
+	void bareiss<T>::check_quadratic() const {
+		if (rows() != columns()) {
+			throw std::invalid_argument("Matrix has to be quadratic.");
+		}
+	}
+
+	// Unsigned values above the range of long long cannot be eliminated
+	template<typename T>
+	typename bareiss<T>::entry_type bareiss<T>::widen(T value) {
+		if constexpr (std::is_unsigned_v<T>) {
+			if (value > static_cast<unsigned long long>(std::numeric_limits<long long>::max())) {
+				throw std::overflow_error("Exact result exceeds the range of the entry type.");
+			}
+		}
+		return static_cast<entry_type>(value);
+	}
+
+	// Unsigned results have to be nonnegative and fit T
+	template<typename T>
+	T bareiss<T>::narrow(entry_type value) {
+		if constexpr (std::is_unsigned_v<T>) {
+			if (value < 0 || static_cast<unsigned long long>(value) > std::numeric_limits<T>::max()) {
+				throw std::overflow_error("Exact result exceeds the range of the entry type.");
+			}
+		}
+		return static_cast<T>(value);
+	}
+
+	// Getter for the dimension of the eliminated quadratic matrix
+	template<typename T>
+	size_t bareiss<T>::size() const noexcept {
+		return m_echelon.rows();
+	}
+
+	// Getter for rows
+	template<typename T>
+	size_t bareiss<T>::rows() const noexcept {
+		return m_echelon.rows();
+	}
+
+	// Getter for columns
+	template<typename T>
+	size_t bareiss<T>::columns() const noexcept {
+		return m_echelon.columns();
+	}
+
+	// Getter for the pivot columns
+	template<typename T>
+	const std::vector<size_t>& bareiss<T>::pivots() const noexcept {
+		return m_pivots;
+	}
+
+	// Getter for the row echelon form
+	template<typename T>
+	const matrix<typename bareiss<T>::entry_type>& bareiss<T>::echelon() const noexcept {
+		return m_echelon;
+	}
+
+	// Every pivot starts a nonzero row
+	template<typename T>
+	size_t bareiss<T>::rank() const noexcept {
+		return m_pivots.size();
+	}
+
+	// The last pivot for integers, the product of the diagonal for residue
+	// classes
+	template<typename T>
+	typename bareiss<T>::entry_type bareiss<T>::determinant_entry() const {
+		using E = entry_type;
+		check_quadratic();
+		size_t n = size();
+		if (m_pivots.size() < n) { return E(0); }
+
+		if constexpr (std::is_integral_v<T>) {
+			E det = m_echelon(n - 1, n - 1);
+			return m_negate ? detail::exact_integer<E>::negate(det) : det;
+		}
+		else {
+			E det = E(1);
+			for (size_t i = 0; i < n; i++) {
+				det *= m_echelon(i, i);
+			}
+			return m_negate ? E(0) - det : det;
+		}
+	}
+
+	// Determinant narrowed to T
+	template<typename T>
+	T bareiss<T>::determinant() const {
+		return narrow(determinant_entry());
+	}
+
+	// Integers divide the scaled solution by the determinant, residue classes
+	// eliminate next to b and substitute backwards with the inverted pivots
+	template<typename T>
+	vector<T> bareiss<T>::solve(const vector<T> &b) const {
+		if constexpr (std::is_integral_v<T>) {
+			vector<entry_type> scaled = solve_scaled_entries(b);
+			entry_type det = determinant_entry();
+			vector<T> x(size());
+			for (size_t i = 0; i < size(); i++) {
+				if (scaled[i] % det != 0) {
+					throw std::runtime_error("Solution is not integral.");
+				}
+				x[i] = narrow(detail::exact_integer<entry_type>::divide(scaled[i], det));
+			}
+			return x;
+		}
+		else {
+			// Check for valid argument
+			check_quadratic();
+			if (b.size() != size()) {
+				throw std::invalid_argument("Size of vector has to match the matrix.");
+			}
+
+			const uint32_t mod = ring_modulus<T>::value;
+			size_t n = size();
+			matrix<T> system(n, n + 1);
+			for (size_t i = 0; i < n; i++) {
+				std::copy(m_matrix.data() + i * n, m_matrix.data() + (i + 1) * n, system.data() + i * (n + 1));
+				system(i, n) = b[i];
+			}
+			std::vector<size_t> pivots;
+			bool negate = false;
+			eliminate(system, n, pivots, negate);
+
+			// The matrix is invertible iff its determinant, the product of the
+			// diagonal, is a unit, so iff every diagonal entry is one
+			vector<T> x(n);
+			for (size_t i = n; i-- > 0;) {
+				uint32_t inverse = pivots.size() == n ? inverse_mod(system(i, i).value(), mod) : 0;
+				if (inverse == 0) {
+					throw std::invalid_argument("Matrix is not invertible.");
+				}
+				T sum = system(i, n);
+				for (size_t j = i + 1; j < n; j++) {
+					sum -= system(i, j) * x[j];
+				}
+				x[i] = sum * T(inverse);
+			}
+			return x;
+		}
+	}
+
+	// Fraction-free back substitution: with d the last pivot of the echelon form
+	// of [A | b], x~_i = (d * b_i - sum_{j > i} u_ij * x~_j) / u_ii is d * x and
+	// every division is exact
+	template<typename T>
+	vector<typename bareiss<T>::entry_type> bareiss<T>::solve_scaled_entries(const vector<T> &b) const {
+		static_assert(std::is_integral_v<T>, "Scaled solutions are only defined for integers.");
+		using E = entry_type;
+		using ops = detail::exact_integer<E>;
+
+		// Check for valid argument
+		check_quadratic();
+		if (b.size() != size()) {
+			throw std::invalid_argument("Size of vector has to match the matrix.");
+		}
+		if (m_pivots.size() < size()) {
+			throw std::invalid_argument("Matrix is not invertible.");
+		}
+
+		size_t n = size();
+		matrix<E> system(n, n + 1);
+		for (size_t i = 0; i < n; i++) {
+			std::copy(m_matrix.data() + i * n, m_matrix.data() + (i + 1) * n, system.data() + i * (n + 1));
+			system(i, n) = widen(b[i]);
+		}
+		std::vector<size_t> pivots;
+		bool negate = false;
+		eliminate(system, n, pivots, negate);
+
+		E d = system(n - 1, n - 1);
+		vector<E> x(n);
+		for (size_t i = n; i-- > 0;) {
+			typename ops::wide_type sum = ops::multiply(d, system(i, n));
+			for (size_t j = i + 1; j < n; j++) {
+				sum = ops::accumulate(sum, ops::multiply(system(i, j), x[j]));
+			}
+			x[i] = ops::divide(sum, system(i, i));
+		}
+
+		// d is the determinant up to the sign of the row swaps
+		if (negate) {
+			for (size_t i = 0; i < n; i++) {
+				x[i] = ops::negate(x[i]);
+			}
+		}
+		return x;
+	}
+
+	// Scaled solution narrowed to T
+	template<typename T>
+	vector<T> bareiss<T>::solve_scaled(const vector<T> &b) const {
+		vector<entry_type> scaled = solve_scaled_entries(b);
+		vector<T> x(scaled.size());
+		for (size_t i = 0; i < scaled.size(); i++) {
+			x[i] = narrow(scaled[i]);
+		}
+		return x;
+	}
+
+	// Bound the determinant, collect enough primes below 2^31 and eliminate
+	// modulo each of them in parallel
+	template<typename T>
+	big_integer determinant_multimodular(const matrix<T> &m) {
+		static_assert(std::is_integral_v<T>, "Multi-modular determinants need integer entries.");
+
+		// Check for valid argument
+		if (m.rows() != m.columns()) {
+			throw std::invalid_argument("Matrix has to be quadratic.");
+		}
+
+		// Logarithm of Hadamard's bound, a row of zeros makes the determinant 0
+		size_t n = m.rows();
+		double bound = 0.0;
+		for (size_t i = 0; i < n; i++) {
+			double norm = 0.0;
+			for (size_t j = 0; j < n; j++) {
+				double v = static_cast<double>(m(i, j));
+				norm += v * v;
+			}
+			if (norm == 0.0) { return big_integer(0); }
+			bound += 0.5 * std::log2(norm);
+		}
+
+		// The product of the primes has to exceed 2 * bound to tell the sign,
+		// one more bit covers rounding in the logarithms
+		std::vector<uint32_t> primes;
+		double bits = 0.0;
+		for (uint32_t p = 0x7fffffffu; bits < bound + 2.0; p -= 2) {
+			if (detail::is_prime(p)) {
+				primes.push_back(p);
+				bits += std::log2(static_cast<double>(p));
+			}
+		}
+
+		std::vector<uint32_t> residues(primes.size());
+		thread_pool::instance().parallel_for(0, primes.size(), 1,
+			[&m, &primes, &residues](size_t first, size_t last) {
+			for (size_t k = first; k < last; k++) {
+				residues[k] = detail::determinant_mod(m, primes[k]);
+			}
+		});
+		return chinese_remainder(residues, primes);
+	}
+}
\ No newline at end of file
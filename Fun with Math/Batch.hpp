@@ -0,0 +1,476 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "Allocator.hpp"
+#include "FixedMatrix.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include "Vector.hpp"
+
+namespace la {
+	namespace detail {
+		// Matrices per block of a batch, one cache line of entries
+		template<typename T>
+		constexpr size_t batch_lanes = storage_alignment / sizeof(T) > 0 ? storage_alignment / sizeof(T) : 1;
+
+		// L values of T that take part in arithmetic together. Every operator
+		// is a plain loop over the values, which the compiler turns into SIMD
+		// instructions, so formulas written for T run on L matrices at once.
+		template<typename T, size_t L>
+		struct lane_pack {
+			T values[L];
+
+			lane_pack() = default;
+			// Broadcast a value to all lanes, the formulas use constants like
+			// T(0) which have to work for types like la::complex as well
+			template<typename U>
+			explicit lane_pack(const U &value) {
+				for (size_t l = 0; l < L; l++) { values[l] = T(value); }
+			}
+
+			void load(const T *p) noexcept {
+				for (size_t l = 0; l < L; l++) { values[l] = p[l]; }
+			}
+			void store(T *p) const noexcept {
+				for (size_t l = 0; l < L; l++) { p[l] = values[l]; }
+			}
+
+			T& operator[](size_t l) noexcept { return values[l]; }
+			const T& operator[](size_t l) const noexcept { return values[l]; }
+
+			lane_pack& operator+=(const lane_pack &other) {
+				for (size_t l = 0; l < L; l++) { values[l] += other.values[l]; }
+				return *this;
+			}
+			lane_pack& operator-=(const lane_pack &other) {
+				for (size_t l = 0; l < L; l++) { values[l] -= other.values[l]; }
+				return *this;
+			}
+			lane_pack& operator*=(const lane_pack &other) {
+				for (size_t l = 0; l < L; l++) { values[l] *= other.values[l]; }
+				return *this;
+			}
+			lane_pack operator+(const lane_pack &other) const { return lane_pack(*this) += other; }
+			lane_pack operator-(const lane_pack &other) const { return lane_pack(*this) -= other; }
+			lane_pack operator*(const lane_pack &other) const { return lane_pack(*this) *= other; }
+			lane_pack operator*(const T &other) const {
+				lane_pack p;
+				for (size_t l = 0; l < L; l++) { p.values[l] = values[l] * other; }
+				return p;
+			}
+		};
+
+		// Kernels on consecutive blocks of a batch. Simd.cpp compiles them once
+		// more for every instruction set it dispatches to.
+
+		// det[k] = determinant of matrix k, N <= 4
+		template<typename T, size_t N>
+		void determinant_blocks(const T *a, T *det, size_t blocks) noexcept {
+			constexpr size_t L = batch_lanes<T>;
+			using pack = lane_pack<T, L>;
+
+			for (size_t b = 0; b < blocks; b++) {
+				pack x[N * N];
+				static_for<N * N>([&](size_t ij) { x[ij].load(a + (b * N * N + ij) * L); });
+				determinant<pack, N>(x).store(det + b * L);
+			}
+		}
+
+		// Inverses and determinants of all matrices, N <= 4. Singular matrices
+		// are scaled by 1 instead of dividing by 0, the caller checks det.
+		template<typename T, size_t N>
+		void invert_blocks(const T *a, T *inv, T *det, size_t blocks) noexcept {
+			constexpr size_t L = batch_lanes<T>;
+			using pack = lane_pack<T, L>;
+
+			for (size_t b = 0; b < blocks; b++) {
+				pack x[N * N], adj[N * N];
+				static_for<N * N>([&](size_t ij) { x[ij].load(a + (b * N * N + ij) * L); });
+				pack d = adjugate<pack, N>(x, adj);
+
+				pack scale;
+				for (size_t l = 0; l < L; l++) { scale[l] = T(1) / (d[l] == T(0) ? T(1) : d[l]); }
+				static_for<N * N>([&](size_t ij) { (adj[ij] * scale).store(inv + (b * N * N + ij) * L); });
+				d.store(det + b * L);
+			}
+		}
+
+		// Pairwise products of R x C and C x K matrices
+		template<typename T, size_t R, size_t C, size_t K>
+		void multiply_blocks(const T *a, const T *b, T *c, size_t blocks) noexcept {
+			constexpr size_t L = batch_lanes<T>;
+			using pack = lane_pack<T, L>;
+
+			for (size_t k = 0; k < blocks; k++) {
+				pack x[R * C], y[C * K];
+				static_for<R * C>([&](size_t ij) { x[ij].load(a + (k * R * C + ij) * L); });
+				static_for<C * K>([&](size_t ij) { y[ij].load(b + (k * C * K + ij) * L); });
+				static_for<R * K>([&](size_t ij) {
+					size_t i = ij / K, j = ij % K;
+					pack z = x[i * C] * y[j];
+					static_for<C - 1>([&](size_t m) { z += x[i * C + m + 1] * y[(m + 1) * K + j]; });
+					z.store(c + (k * R * K + ij) * L);
+				});
+			}
+		}
+
+		// Products of R x C matrices with the same C x K matrix
+		template<typename T, size_t R, size_t C, size_t K>
+		void multiply_blocks(const T *a, const matrix<T, C, K> &b, T *c, size_t blocks) noexcept {
+			constexpr size_t L = batch_lanes<T>;
+			using pack = lane_pack<T, L>;
+
+			for (size_t k = 0; k < blocks; k++) {
+				pack x[R * C];
+				static_for<R * C>([&](size_t ij) { x[ij].load(a + (k * R * C + ij) * L); });
+				static_for<R * K>([&](size_t ij) {
+					size_t i = ij / K, j = ij % K;
+					pack z = x[i * C] * b(0, j);
+					static_for<C - 1>([&](size_t m) { z += x[i * C + m + 1] * b(m + 1, j); });
+					z.store(c + (k * R * K + ij) * L);
+				});
+			}
+		}
+	}
+
+	// Batch of many independent R x C matrices, like the transforms of all
+	// tracked objects. The matrices are stored interleaved in blocks of lanes:
+	// a block holds entry (0, 0) of lanes matrices, then entry (0, 1) of the
+	// same matrices and so on. Every operation runs the closed-form formulas of
+	// the fixed size matrix on packs of these entries, so lanes matrices are
+	// handled by the same SIMD instructions without any branches, and blocks
+	// are spread over the thread pool for large batches.
+	//
+	// The last block is padded with zero matrices that never show up in results.
+	template<typename T, size_t R, size_t C>
+	class matrix_batch {
+	public:
+		// Matrices per block, one cache line of entries
+		static constexpr size_t lanes = detail::batch_lanes<T>;
+
+	private:
+		size_t m_size = 0;
+		std::vector<T, matrix_allocator_t<T>> m_entries;
+
+		// Call f(first, last) on ranges of blocks in parallel
+		template<typename F>
+		void for_each_block(F) const;
+
+	public:
+		using value_type = T;
+
+		// Constructors
+
+		// Default constructor
+		matrix_batch() = default;
+		// Construct batch of n zero matrices
+		explicit matrix_batch(size_t);
+		// Construct batch of n copies of a matrix
+		matrix_batch(size_t, const matrix<T, R, C> &);
+
+		// Getter for the dimensions
+		size_t size() const noexcept;
+		size_t blocks() const noexcept;
+		static constexpr size_t rows() noexcept;
+		static constexpr size_t columns() noexcept;
+		// Raw interleaved storage, entry (i, j) of matrix k is at
+		// (k / lanes * R * C + i * C + j) * lanes + k % lanes
+		T* data() noexcept;
+		const T* data() const noexcept;
+
+		// Copy single matrices in and out
+		// Throw std::out_of_range for invalid indices
+		matrix<T, R, C> get(size_t) const;
+		void set(size_t, const matrix<T, R, C> &);
+
+		// Matrix algorithms (may be multithreaded)
+		// Determinants and inverses are closed-form up to 4x4, bigger matrices
+		// are handled one by one
+		vector<T> determinant() const;
+		matrix_batch<T, C, R> transpose() const;
+		// Throws std::invalid_argument if any of the matrices is singular,
+		// determinant() tells which ones
+		matrix_batch invert() const;
+		// Solve A_k * X_k = B_k for every pair of the batches
+		// Throws std::runtime_error if the batch sizes differ and
+		// std::invalid_argument if any of the matrices is singular
+		template<size_t K>
+		matrix_batch<T, R, K> solve(const matrix_batch<T, R, K> &) const;
+
+		// Overloaded operators
+
+		// Access operators, unchecked
+		T operator()(size_t, size_t, size_t) const noexcept;
+		T& operator()(size_t, size_t, size_t) noexcept;
+
+		// Arithmetic operators (may be multithreaded), multiply pairwise or
+		// every matrix of the batch by the same matrix
+		// Throws std::runtime_error if the batch sizes differ
+		template<size_t K>
+		matrix_batch<T, R, K> operator*(const matrix_batch<T, C, K> &) const;
+		template<size_t K>
+		matrix_batch<T, R, K> operator*(const matrix<T, C, K> &) const;
+
+		// Comparison operators
+		bool operator==(const matrix_batch &) const;
+		bool operator!=(const matrix_batch &) const;
+	};
+
+	// Create batch of zero matrices
+	template<typename T, size_t R, size_t C>
+	matrix_batch<T, R, C>::matrix_batch(size_t n)
+		: m_size(n), m_entries((n + lanes - 1) / lanes * R * C * lanes, T(0))
+	{}
+
+	// Create batch of copies
+	template<typename T, size_t R, size_t C>
+	matrix_batch<T, R, C>::matrix_batch(size_t n, const matrix<T, R, C> &m)
+		: matrix_batch(n) {
+		for (size_t b = 0; b < blocks(); b++) {
+			T *block = m_entries.data() + b * R * C * lanes;
+			size_t count = std::min(lanes, n - b * lanes);
+			for (size_t ij = 0; ij < R * C; ij++) {
+				std::fill(block + ij * lanes, block + ij * lanes + count, m.data()[ij]);
+			}
+		}
+	}
+
+	// Split the blocks into tasks of at least minEntriesPerTask entries
+	template<typename T, size_t R, size_t C>
+	template<typename F>
+	void matrix_batch<T, R, C>::for_each_block(F f) const {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		thread_pool::instance().parallel_for(0, blocks(),
+			std::max<size_t>(minEntriesPerTask / (R * C * lanes), 1), f);
+	}
+
+	// Getter for the number of matrices
+	template<typename T, size_t R, size_t C>
+	size_t matrix_batch<T, R, C>::size() const noexcept {
+		return m_size;
+	}
+
+	// Getter for the number of blocks
+	template<typename T, size_t R, size_t C>
+	size_t matrix_batch<T, R, C>::blocks() const noexcept {
+		return (m_size + lanes - 1) / lanes;
+	}
+
+	// Getter for rows
+	template<typename T, size_t R, size_t C>
+	constexpr size_t matrix_batch<T, R, C>::rows() noexcept {
+		return R;
+	}
+
+	// Getter for columns
+	template<typename T, size_t R, size_t C>
+	constexpr size_t matrix_batch<T, R, C>::columns() noexcept {
+		return C;
+	}
+
+	// Getter for the interleaved storage
+	template<typename T, size_t R, size_t C>
+	T* matrix_batch<T, R, C>::data() noexcept {
+		return m_entries.data();
+	}
+
+	// Getter for the interleaved storage
+	template<typename T, size_t R, size_t C>
+	const T* matrix_batch<T, R, C>::data() const noexcept {
+		return m_entries.data();
+	}
+
+	// Gather a single matrix from its block
+	template<typename T, size_t R, size_t C>
+	matrix<T, R, C> matrix_batch<T, R, C>::get(size_t k) const {
+		// Check for valid argument
+		if (k >= m_size) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+
+		matrix<T, R, C> m;
+		const T *block = m_entries.data() + k / lanes * R * C * lanes + k % lanes;
+		static_for<R * C>([&](size_t ij) { m.data()[ij] = block[ij * lanes]; });
+		return m;
+	}
+
+	// Scatter a single matrix into its block
+	template<typename T, size_t R, size_t C>
+	void matrix_batch<T, R, C>::set(size_t k, const matrix<T, R, C> &m) {
+		// Check for valid argument
+		if (k >= m_size) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+
+		T *block = m_entries.data() + k / lanes * R * C * lanes + k % lanes;
+		static_for<R * C>([&](size_t ij) { block[ij * lanes] = m.data()[ij]; });
+	}
+
+	// Determinants of all matrices, the fixed size formula runs on packs of
+	// lanes entries
+	template<typename T, size_t R, size_t C>
+	vector<T> matrix_batch<T, R, C>::determinant() const {
+		static_assert(R == C, "Matrix has to be quadratic.");
+
+		std::vector<T, matrix_allocator_t<T>> det(blocks() * lanes);
+		T *d = det.data();
+		for_each_block([this, d](size_t first, size_t last) {
+			const T *a = m_entries.data() + first * R * C * lanes;
+			if constexpr (R <= 4 && simd_batch_supported_v<T>) {
+				simd_batch_determinant<T, R>(a, d + first * lanes, last - first);
+			}
+			else if constexpr (R <= 4) {
+				detail::determinant_blocks<T, R>(a, d + first * lanes, last - first);
+			}
+			else {
+				for (size_t k = first * lanes; k < std::min(last * lanes, m_size); k++) {
+					d[k] = get(k).determinant();
+				}
+			}
+		});
+
+		vector<T> v(m_size);
+		std::copy(det.begin(), det.begin() + m_size, v.data());
+		return v;
+	}
+
+	// Transpose all matrices, whole packs change their place
+	template<typename T, size_t R, size_t C>
+	matrix_batch<T, C, R> matrix_batch<T, R, C>::transpose() const {
+		matrix_batch<T, C, R> t(m_size);
+		T *dst = t.data();
+		for_each_block([this, dst](size_t first, size_t last) {
+			for (size_t b = first; b < last; b++) {
+				const T *block = m_entries.data() + b * R * C * lanes;
+				T *result = dst + b * R * C * lanes;
+				static_for<R * C>([&](size_t ij) {
+					std::copy(block + ij * lanes, block + (ij + 1) * lanes, result + (ij % C * R + ij / C) * lanes);
+				});
+			}
+		});
+		return t;
+	}
+
+	// Invert all matrices by their adjugates. Singular matrices are only
+	// found afterwards by their determinants, which keeps the lanes free of
+	// branches.
+	template<typename T, size_t R, size_t C>
+	matrix_batch<T, R, C> matrix_batch<T, R, C>::invert() const {
+		static_assert(R == C, "Matrix has to be quadratic.");
+
+		matrix_batch inverse(m_size);
+		if constexpr (R <= 4) {
+			std::vector<T, matrix_allocator_t<T>> det(blocks() * lanes);
+			T *d = det.data();
+			T *dst = inverse.m_entries.data();
+			for_each_block([this, d, dst](size_t first, size_t last) {
+				const T *a = m_entries.data() + first * R * C * lanes;
+				if constexpr (simd_batch_supported_v<T>) {
+					simd_batch_invert<T, R>(a, dst + first * R * C * lanes, d + first * lanes, last - first);
+				}
+				else {
+					detail::invert_blocks<T, R>(a, dst + first * R * C * lanes, d + first * lanes, last - first);
+				}
+			});
+
+			if (std::find(det.begin(), det.begin() + m_size, T(0)) != det.begin() + m_size) {
+				throw std::invalid_argument("Matrix is not invertible.");
+			}
+			// The adjugate of a 1 x 1 matrix is 1 even for the padding
+			for (size_t k = m_size; k < blocks() * lanes; k++) {
+				static_for<R * C>([&](size_t ij) { inverse.m_entries[(k / lanes * R * C + ij) * lanes + k % lanes] = T(0); });
+			}
+		}
+		else {
+			for_each_block([this, &inverse](size_t first, size_t last) {
+				for (size_t k = first * lanes; k < std::min(last * lanes, m_size); k++) {
+					inverse.set(k, get(k).invert());
+				}
+			});
+		}
+		return inverse;
+	}
+
+	// Solve by multiplying with the inverses, the closed-form inverse of small
+	// matrices is cheaper than an elimination with pivot search per lane
+	template<typename T, size_t R, size_t C>
+	template<size_t K>
+	matrix_batch<T, R, K> matrix_batch<T, R, C>::solve(const matrix_batch<T, R, K> &b) const {
+		// Check for valid argument
+		if (b.size() != m_size) {
+			throw std::runtime_error("Dimensions of matrices can not differ from each other.");
+		}
+
+		return invert() * b;
+	}
+
+	// Access entry (i, j) of matrix k by value
+	template<typename T, size_t R, size_t C>
+	T matrix_batch<T, R, C>::operator()(size_t k, size_t i, size_t j) const noexcept {
+		return m_entries[(k / lanes * R * C + i * C + j) * lanes + k % lanes];
+	}
+
+	// Access entry (i, j) of matrix k by reference
+	template<typename T, size_t R, size_t C>
+	T& matrix_batch<T, R, C>::operator()(size_t k, size_t i, size_t j) noexcept {
+		return m_entries[(k / lanes * R * C + i * C + j) * lanes + k % lanes];
+	}
+
+	// Multiply pairwise, every entry of the result is a sum of products of
+	// packs
+	template<typename T, size_t R, size_t C>
+	template<size_t K>
+	matrix_batch<T, R, K> matrix_batch<T, R, C>::operator*(const matrix_batch<T, C, K> &other) const {
+		// Check for valid argument
+		if (other.size() != m_size) {
+			throw std::runtime_error("Dimensions of matrices can not differ from each other.");
+		}
+
+		matrix_batch<T, R, K> m(m_size);
+		const T *rhs = other.data();
+		T *dst = m.data();
+		for_each_block([this, rhs, dst](size_t first, size_t last) {
+			const T *a = m_entries.data() + first * R * C * lanes;
+			const T *b = rhs + first * C * K * lanes;
+			T *c = dst + first * R * K * lanes;
+			if constexpr (R == C && C == K && R <= 4 && simd_batch_supported_v<T>) {
+				simd_batch_multiply<T, R>(a, b, c, last - first);
+			}
+			else {
+				detail::multiply_blocks<T, R, C, K>(a, b, c, last - first);
+			}
+		});
+		return m;
+	}
+
+	// Multiply every matrix by the same one, whose entries are broadcast to
+	// all lanes
+	template<typename T, size_t R, size_t C>
+	template<size_t K>
+	matrix_batch<T, R, K> matrix_batch<T, R, C>::operator*(const matrix<T, C, K> &other) const {
+		matrix_batch<T, R, K> m(m_size);
+		T *dst = m.data();
+		for_each_block([this, &other, dst](size_t first, size_t last) {
+			detail::multiply_blocks<T, R, C, K>(m_entries.data() + first * R * C * lanes, other,
+				dst + first * R * K * lanes, last - first);
+		});
+		return m;
+	}
+
+	// Check two batches for equality, the padding is always 0
+	template<typename T, size_t R, size_t C>
+	bool matrix_batch<T, R, C>::operator==(const matrix_batch &other) const {
+		return m_size == other.m_size && m_entries == other.m_entries;
+	}
+
+	// Check two batches for inequality
+	template<typename T, size_t R, size_t C>
+	bool matrix_batch<T, R, C>::operator!=(const matrix_batch &other) const {
+		return !(*this == other);
+	}
+}
\ No newline at end of file
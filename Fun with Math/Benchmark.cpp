@@ -0,0 +1,181 @@
+#include "stdafx.h"
+#include "Benchmark.hpp"
+#include "LinearAlgebra.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <random>
+
+namespace {
+	// Calls of the global operator new, so benchmarks can check that a loop does
+	// not allocate
+	std::atomic<size_t> g_heapAllocations{ 0 };
+
+	// Above this size the classic loop takes too long to be worth measuring
+	const size_t maxNaiveSize = 1024;
+
+	// Fill a matrix with uniformly distributed values in [-1, 1]
+	la::matrix<double> random_matrix(size_t n, std::mt19937_64 &gen) {
+		std::uniform_real_distribution<double> dist(-1.0, 1.0);
+		la::matrix<double> m(n, n);
+		for (size_t i = 0; i < n; i++) {
+			for (size_t j = 0; j < n; j++) {
+				m(i, j) = dist(gen);
+			}
+		}
+		return m;
+	}
+
+	// Return the best time of several runs of f in seconds
+	template<typename F>
+	double best_time(size_t repetitions, F f) {
+		double best = std::numeric_limits<double>::max();
+		for (size_t r = 0; r < repetitions; r++) {
+			auto start = std::chrono::steady_clock::now();
+			f();
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+		return best;
+	}
+}
+
+// Count every allocation of the program, the default array and nothrow forms
+// forward to these
+void* operator new(size_t bytes) {
+	g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *p = std::malloc(bytes != 0 ? bytes : 1)) { return p; }
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	std::free(p);
+}
+
+void benchmark_gemm(const std::vector<size_t>& sizes, size_t repetitions) {
+	std::mt19937_64 gen(42);
+
+	std::cout << "Micro kernel: " << la::simd_name(la::simd_support()) << std::endl;
+	std::cout << std::setw(8) << "n" << std::setw(16) << "naive GFLOP/s"
+		<< std::setw(16) << "kernel GFLOP/s" << std::setw(20) << "operator* GFLOP/s"
+		<< std::setw(10) << "speedup" << std::endl;
+
+	for (size_t n : sizes) {
+		la::matrix<double> a = random_matrix(n, gen);
+		la::matrix<double> b = random_matrix(n, gen);
+		la::matrix<double> c(n, n);
+		double flops = 2.0 * n * n * n;
+
+		// Single threaded classic loop and blocked kernel on identical operands
+		auto aRef = &a(0, 0);
+		auto bRef = &b(0, 0);
+		auto cRef = &c(0, 0);
+		double naive = 0;
+		if (n <= maxNaiveSize) {
+			naive = best_time(repetitions, [&]() {
+				la::gemm_naive(n, n, n, aRef, n, 1, bRef, n, 1, cRef, n, 1);
+			});
+		}
+		double kernel = best_time(repetitions, [&]() {
+			la::gemm(n, n, n, 1.0, aRef, n, 1, bRef, n, 1, 0.0, cRef, n, 1);
+		});
+		// Multithreaded public operator
+		double op = best_time(repetitions, [&]() { c = a * b; });
+
+		std::cout << std::setw(8) << n;
+		if (naive > 0) {
+			std::cout << std::setw(16) << flops / naive * 1e-9;
+		}
+		else {
+			std::cout << std::setw(16) << "-";
+		}
+		std::cout << std::setw(16) << flops / kernel * 1e-9
+			<< std::setw(20) << flops / op * 1e-9;
+		if (naive > 0) {
+			std::cout << std::setw(10) << naive / kernel;
+		}
+		std::cout << std::endl;
+	}
+}
+
+void benchmark_strassen(const std::vector<size_t>& sizes, size_t crossover, size_t repetitions) {
+	std::mt19937_64 gen(42);
+
+	std::cout << std::setw(8) << "n" << std::setw(20) << "operator* GFLOP/s"
+		<< std::setw(20) << "strassen GFLOP/s" << std::setw(10) << "speedup"
+		<< std::setw(16) << "rel. error" << std::endl;
+
+	std::vector<double> workspace;
+	for (size_t n : sizes) {
+		la::matrix<double> a = random_matrix(n, gen);
+		la::matrix<double> b = random_matrix(n, gen);
+		la::matrix<double> classic, fast;
+		double flops = 2.0 * n * n * n;
+
+		double op = best_time(repetitions, [&]() { classic = a * b; });
+		double strassen = best_time(repetitions, [&]() {
+			fast = la::strassen(a, b, workspace, crossover);
+		});
+
+		// Largest deviation from the classical result relative to its largest entry
+		double diff = 0, scale = 0;
+		for (size_t i = 0; i < n; i++) {
+			for (size_t j = 0; j < n; j++) {
+				diff = std::max(diff, std::abs(fast(i, j) - classic(i, j)));
+				scale = std::max(scale, std::abs(classic(i, j)));
+			}
+		}
+
+		std::cout << std::setw(8) << n << std::setw(20) << flops / op * 1e-9
+			<< std::setw(20) << flops / strassen * 1e-9 << std::setw(10) << op / strassen
+			<< std::setw(16) << (scale > 0 ? diff / scale : diff) << std::endl;
+	}
+}
+
+bool benchmark_compound_allocations(size_t n, size_t calls) {
+	std::mt19937_64 gen(42);
+	la::matrix<double> a = random_matrix(n, gen);
+	la::matrix<double> b = random_matrix(n, gen);
+	la::vector<double> v(n), w(n);
+	for (size_t i = 0; i < n; i++) {
+		v[i] = a(i, 0);
+		w[i] = b(i, 0);
+	}
+
+	std::cout << std::setw(12) << "operator" << std::setw(10) << "calls"
+		<< std::setw(16) << "allocations" << std::endl;
+
+	bool none = true;
+	// Heap and pool allocations of calls repetitions of f after one warm-up call
+	auto count = [&](const char *name, auto f) {
+		f();
+		size_t heap = g_heapAllocations.load();
+		size_t pool = la::allocation_statistics().requests;
+		for (size_t c = 0; c < calls; c++) { f(); }
+		size_t allocations = g_heapAllocations.load() - heap + la::allocation_statistics().requests - pool;
+		none = none && allocations == 0;
+		std::cout << std::setw(12) << name << std::setw(10) << calls
+			<< std::setw(16) << allocations << std::endl;
+	};
+
+	// Scalars close to 1 keep the entries in range over many calls
+	count("A += B", [&]() { a += b; });
+	count("A -= B", [&]() { a -= b; });
+	count("A *= s", [&]() { a *= 1.0001; });
+	count("A /= s", [&]() { a /= 1.0001; });
+	count("A *= B", [&]() { a *= b; a /= double(n); });
+	count("v += w", [&]() { v += w; });
+	count("v -= w", [&]() { v -= w; });
+	count("v *= s", [&]() { v *= 1.0001; });
+	count("v /= s", [&]() { v /= 1.0001; });
+	return none;
+}
\ No newline at end of file
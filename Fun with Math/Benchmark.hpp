@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+// Print the GFLOP/s of the classic and the cache blocked matrix multiplication
+// for square double matrices of the given sizes, after the instruction set of
+// the micro kernel
+void benchmark_gemm(const std::vector<size_t>&, size_t = 3);
+
+// Compare the Strassen-Winograd multiplication with the given crossover to the
+// classical operator* for square double matrices: GFLOP/s counted as 2 * n^3
+// for both and the largest difference relative to the largest entry
+void benchmark_strassen(const std::vector<size_t>&, size_t = 256, size_t = 3);
+
+// Count the heap allocations of the compound assignment operators of square
+// double matrices and vectors of the given size after a warm-up call each.
+// Returns whether all of them stayed at 0.
+bool benchmark_compound_allocations(size_t = 512, size_t = 10);
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "stdafx.h"
+#include "BigInteger.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace la {
+	// Extended euclidean algorithm, the remainders run down to gcd(a, m) while
+	// the coefficients of a are tracked
+	uint32_t inverse_mod(uint32_t a, uint32_t m) noexcept {
+		int64_t r0 = m, r1 = a % m;
+		int64_t s0 = 0, s1 = 1;
+		while (r1 != 0) {
+			int64_t q = r0 / r1;
+			std::swap(r0, r1);
+			r1 -= q * r0;
+			std::swap(s0, s1);
+			s1 -= q * s0;
+		}
+		if (r0 != 1) { return 0; }
+		return static_cast<uint32_t>(s0 < 0 ? s0 + m : s0);
+	}
+
+	// Store the magnitude in limbs and the sign separately
+	big_integer::big_integer(long long value)
+		: m_negative(value < 0) {
+		// Negate as unsigned so the smallest value does not overflow
+		unsigned long long magnitude = m_negative ? 0ull - static_cast<unsigned long long>(value) :
+			static_cast<unsigned long long>(value);
+		while (magnitude != 0) {
+			m_limbs.push_back(static_cast<uint32_t>(magnitude));
+			magnitude >>= 32;
+		}
+	}
+
+	// Remove leading zero limbs, 0 is never negative
+	void big_integer::trim() noexcept {
+		while (!m_limbs.empty() && m_limbs.back() == 0) { m_limbs.pop_back(); }
+		if (m_limbs.empty()) { m_negative = false; }
+	}
+
+	// Three-way comparison of magnitudes, -1 if the first one is smaller
+	int big_integer::compare_magnitude(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b) noexcept {
+		if (a.size() != b.size()) { return a.size() < b.size() ? -1 : 1; }
+		for (size_t i = a.size(); i-- > 0;) {
+			if (a[i] != b[i]) { return a[i] < b[i] ? -1 : 1; }
+		}
+		return 0;
+	}
+
+	// Schoolbook addition with carry
+	void big_integer::add_magnitude(std::vector<uint32_t> &a, const std::vector<uint32_t> &b) {
+		if (a.size() < b.size()) { a.resize(b.size(), 0); }
+		uint64_t carry = 0;
+		for (size_t i = 0; i < a.size(); i++) {
+			carry += uint64_t(a[i]) + (i < b.size() ? b[i] : 0);
+			a[i] = static_cast<uint32_t>(carry);
+			carry >>= 32;
+		}
+		if (carry != 0) { a.push_back(static_cast<uint32_t>(carry)); }
+	}
+
+	// Schoolbook subtraction with borrow, the operands are swapped first if the
+	// second one is larger
+	void big_integer::subtract_magnitude(std::vector<uint32_t> &a, const std::vector<uint32_t> &b) {
+		const std::vector<uint32_t> *larger = &a, *smaller = &b;
+		std::vector<uint32_t> copy;
+		if (compare_magnitude(a, b) < 0) {
+			copy = a;
+			a = b;
+			larger = &a;
+			smaller = &copy;
+		}
+		int64_t borrow = 0;
+		for (size_t i = 0; i < larger->size(); i++) {
+			int64_t d = int64_t((*larger)[i]) - (i < smaller->size() ? (*smaller)[i] : 0) - borrow;
+			borrow = d < 0;
+			a[i] = static_cast<uint32_t>(d + (borrow << 32));
+		}
+	}
+
+	// Check if the number is below 0
+	bool big_integer::negative() const noexcept {
+		return m_negative;
+	}
+
+	// Check if the number is 0
+	bool big_integer::zero() const noexcept {
+		return m_limbs.empty();
+	}
+
+	// Position of the highest set bit plus one
+	size_t big_integer::bits() const noexcept {
+		if (m_limbs.empty()) { return 0; }
+		size_t bits = 32 * (m_limbs.size() - 1);
+		for (uint32_t top = m_limbs.back(); top != 0; top >>= 1) { bits++; }
+		return bits;
+	}
+
+	// Getter for the limbs of the magnitude
+	const std::vector<uint32_t>& big_integer::limbs() const noexcept {
+		return m_limbs;
+	}
+
+	// Decimal representation, the magnitude is divided by 10^9 repeatedly
+	std::string big_integer::to_string() const {
+		if (m_limbs.empty()) { return "0"; }
+
+		std::vector<uint32_t> rest = m_limbs;
+		std::vector<uint32_t> chunks;
+		while (!rest.empty()) {
+			uint64_t remainder = 0;
+			for (size_t i = rest.size(); i-- > 0;) {
+				uint64_t current = (remainder << 32) | rest[i];
+				rest[i] = static_cast<uint32_t>(current / 1000000000u);
+				remainder = current % 1000000000u;
+			}
+			chunks.push_back(static_cast<uint32_t>(remainder));
+			while (!rest.empty() && rest.back() == 0) { rest.pop_back(); }
+		}
+
+		std::string s = m_negative ? "-" : "";
+		s += std::to_string(chunks.back());
+		for (size_t i = chunks.size() - 1; i-- > 0;) {
+			std::string digits = std::to_string(chunks[i]);
+			s += std::string(9 - digits.size(), '0') + digits;
+		}
+		return s;
+	}
+
+	// Convert back to a built-in integer
+	long long big_integer::to_long_long() const {
+		if (bits() > 64) {
+			throw std::overflow_error("Integer exceeds the range of the target type.");
+		}
+		unsigned long long magnitude = 0;
+		for (size_t i = m_limbs.size(); i-- > 0;) {
+			magnitude = (magnitude << 32) | m_limbs[i];
+		}
+
+		unsigned long long limit = static_cast<unsigned long long>(std::numeric_limits<long long>::max());
+		if (magnitude > limit + (m_negative ? 1 : 0)) {
+			throw std::overflow_error("Integer exceeds the range of the target type.");
+		}
+		return m_negative ? static_cast<long long>(0ull - magnitude) : static_cast<long long>(magnitude);
+	}
+
+	// Multiply the magnitude and add to it, the sign is kept
+	big_integer& big_integer::multiply_add(uint32_t factor, uint32_t summand) {
+		uint64_t carry = summand;
+		for (uint32_t &limb : m_limbs) {
+			carry += uint64_t(limb) * factor;
+			limb = static_cast<uint32_t>(carry);
+			carry >>= 32;
+		}
+		if (carry != 0) { m_limbs.push_back(static_cast<uint32_t>(carry)); }
+		trim();
+		return *this;
+	}
+
+	// Negate, 0 stays positive
+	big_integer big_integer::operator-() const {
+		big_integer r(*this);
+		if (!r.m_limbs.empty()) { r.m_negative = !r.m_negative; }
+		return r;
+	}
+
+	big_integer big_integer::operator+(const big_integer &other) const {
+		big_integer r(*this);
+		return r += other;
+	}
+
+	big_integer big_integer::operator-(const big_integer &other) const {
+		big_integer r(*this);
+		return r -= other;
+	}
+
+	// Same signs add the magnitudes, different signs subtract the smaller from
+	// the larger one which then determines the sign
+	big_integer& big_integer::operator+=(const big_integer &other) {
+		if (m_negative == other.m_negative) {
+			add_magnitude(m_limbs, other.m_limbs);
+		}
+		else {
+			if (compare_magnitude(m_limbs, other.m_limbs) < 0) { m_negative = other.m_negative; }
+			subtract_magnitude(m_limbs, other.m_limbs);
+		}
+		trim();
+		return *this;
+	}
+
+	// Subtraction is addition of the negated number
+	big_integer& big_integer::operator-=(const big_integer &other) {
+		return *this += -other;
+	}
+
+	bool big_integer::operator==(const big_integer &other) const noexcept {
+		return m_negative == other.m_negative && m_limbs == other.m_limbs;
+	}
+
+	bool big_integer::operator!=(const big_integer &other) const noexcept {
+		return !(*this == other);
+	}
+
+	bool big_integer::operator<(const big_integer &other) const noexcept {
+		if (m_negative != other.m_negative) { return m_negative; }
+		int c = compare_magnitude(m_limbs, other.m_limbs);
+		return m_negative ? c > 0 : c < 0;
+	}
+
+	bool big_integer::operator>(const big_integer &other) const noexcept {
+		return other < *this;
+	}
+
+	std::ostream& operator<<(std::ostream &os, const big_integer &b) {
+		os << b.to_string();
+		return os;
+	}
+
+	// Garner's algorithm computes the digits of x in the mixed radix system of
+	// the moduli, x = v0 + v1 * p0 + v2 * p0 * p1 + ..., with arithmetic modulo
+	// single moduli only. The digits are then combined by Horner's scheme.
+	big_integer chinese_remainder(const std::vector<uint32_t> &residues, const std::vector<uint32_t> &moduli) {
+		if (residues.size() != moduli.size()) {
+			throw std::invalid_argument("Every residue needs a modulus.");
+		}
+		if (std::any_of(moduli.begin(), moduli.end(), [](uint32_t p) { return p < 2; })) {
+			throw std::invalid_argument("Moduli have to be at least 2.");
+		}
+
+		size_t k = moduli.size();
+		std::vector<uint32_t> digits(k);
+		for (size_t i = 0; i < k; i++) {
+			uint64_t p = moduli[i];
+			uint64_t t = residues[i] % p;
+			for (size_t j = 0; j < i; j++) {
+				uint32_t inverse = inverse_mod(moduli[j], moduli[i]);
+				if (inverse == 0) {
+					throw std::invalid_argument("Moduli have to be coprime.");
+				}
+				t = (t + p - digits[j] % p) % p * inverse % p;
+			}
+			digits[i] = static_cast<uint32_t>(t);
+		}
+
+		big_integer x, product(1);
+		for (size_t i = k; i-- > 0;) {
+			x.multiply_add(moduli[i], digits[i]);
+			product.multiply_add(moduli[i], 0);
+		}
+
+		// Move from [0, P) to the symmetric range
+		if (x > product - x) { x -= product; }
+		return x;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace la {
+	// Signed integer of arbitrary size, stored as sign and magnitude in limbs of
+	// 32 bit, least significant first. It only offers what exact results need:
+	// building a number from its residues and reading it back, no division.
+	class big_integer {
+	private:
+		bool m_negative = false;
+		// No leading zero limbs, empty for 0
+		std::vector<uint32_t> m_limbs;
+
+		void trim() noexcept;
+		static int compare_magnitude(const std::vector<uint32_t> &, const std::vector<uint32_t> &) noexcept;
+		static void add_magnitude(std::vector<uint32_t> &, const std::vector<uint32_t> &);
+		// Subtract the smaller magnitude from the larger one in place
+		static void subtract_magnitude(std::vector<uint32_t> &, const std::vector<uint32_t> &);
+
+	public:
+		// Constructors
+		big_integer() = default;
+		big_integer(long long);
+
+		// Member functions
+		bool negative() const noexcept;
+		bool zero() const noexcept;
+		// Number of significant bits of the magnitude
+		size_t bits() const noexcept;
+		const std::vector<uint32_t>& limbs() const noexcept;
+		std::string to_string() const;
+		// Throws std::overflow_error if the value does not fit
+		long long to_long_long() const;
+
+		// this = this * factor + summand, the building block of conversions
+		big_integer& multiply_add(uint32_t, uint32_t);
+
+		// Overloaded operators
+		big_integer operator-() const;
+		big_integer operator+(const big_integer &) const;
+		big_integer operator-(const big_integer &) const;
+		big_integer& operator+=(const big_integer &);
+		big_integer& operator-=(const big_integer &);
+		bool operator==(const big_integer &) const noexcept;
+		bool operator!=(const big_integer &) const noexcept;
+		bool operator<(const big_integer &) const noexcept;
+		bool operator>(const big_integer &) const noexcept;
+	};
+
+	std::ostream& operator<<(std::ostream &, const big_integer &);
+
+	// Inverse of a modulo m, 0 if a and m are not coprime
+	uint32_t inverse_mod(uint32_t, uint32_t) noexcept;
+
+	// Unique integer x with |x| <= P / 2 and x = residues[i] mod moduli[i] for
+	// pairwise coprime moduli with product P, found by Garner's algorithm
+	// Throws std::invalid_argument if the sizes differ or a modulus is below 2
+	big_integer chinese_remainder(const std::vector<uint32_t> &, const std::vector<uint32_t> &);
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "Allocator.hpp"
+#include "Gemm.hpp"
+#include "Gemv.hpp"
+#include "Matrix.hpp"
+#include "Vector.hpp"
+
+namespace la {
+	// Multiply a chain of matrices A * B * C * ... in the cheapest order. The
+	// cost of every parenthesization follows from the dimensions alone, so the
+	// order is chosen by the classic dynamic program before anything is
+	// multiplied: for (10000 x 10) * (10 x 10000) * (10000 x 1) it computes
+	// B * C first and needs 2 * 10^5 instead of 2 * 10^9 multiplications. Every
+	// product uses the kernel for its shape, gemv and gevm for matrix-vector
+	// products and the tiled gemm for all others, and intermediates are freed
+	// as soon as they are used.
+	//
+	// A vector at the end of the chain is taken as a column and makes the
+	// result a vector, a vector at the start as a row. A chain starting and
+	// ending with a vector yields a scalar.
+	// Throws std::runtime_error if neighbouring dimensions do not match
+	template<typename First, typename... Rest>
+	auto multiply(const First &, const Rest &...);
+
+	// Order found by the dynamic program for the given dimensions, operand k
+	// being a dims[k] x dims[k + 1] matrix. Entry i * operands + j is the
+	// operand after which the chain of operands i to j is split.
+	inline std::vector<size_t> chain_order(const std::vector<size_t> &);
+
+	namespace detail {
+		// Operand of a product chain
+		template<typename T>
+		struct chain_operand {
+			const T *data;
+			size_t rows, cols;
+		};
+
+		template<typename T>
+		chain_operand<T> make_chain_operand(const matrix<T> &m, bool) {
+			return { m.data(), m.rows(), m.columns() };
+		}
+
+		template<typename T>
+		chain_operand<T> make_chain_operand(const vector<T> &v, bool first) {
+			return first ? chain_operand<T>{ v.data(), 1, v.size() } :
+				chain_operand<T>{ v.data(), v.size(), 1 };
+		}
+
+		// Evaluate the chain of operands i to j into dst, splitting it where
+		// the order says. Operands are used in place, partial chains are
+		// evaluated into temporary storage.
+		template<typename T>
+		void multiply_chain(const std::vector<chain_operand<T>> &operands, const std::vector<size_t> &order,
+			size_t i, size_t j, T *dst) {
+			using buffer = std::vector<T, matrix_allocator_t<T>>;
+
+			size_t split = order[i * operands.size() + j];
+			size_t m = operands[i].rows;
+			size_t k = operands[split].cols;
+			size_t n = operands[j].cols;
+
+			buffer left, right;
+			const T *a = operands[i].data;
+			const T *b = operands[j].data;
+			if (split != i) {
+				left.resize(m * k);
+				multiply_chain(operands, order, i, split, left.data());
+				a = left.data();
+			}
+			if (split + 1 != j) {
+				right.resize(k * n);
+				multiply_chain(operands, order, split + 1, j, right.data());
+				b = right.data();
+			}
+
+			if (n == 1) {
+				gemv(m, k, T(1), a, k, 1, b, 1, T(0), dst, 1);
+			}
+			else if (m == 1) {
+				gevm(k, n, T(1), a, 1, b, n, 1, T(0), dst, 1);
+			}
+			else {
+				gemm_parallel(m, n, k, a, k, 1, b, n, 1, dst, n, 1);
+			}
+		}
+	}
+
+	// Classic O(n^3) dynamic program over the lengths of partial chains
+	inline std::vector<size_t> chain_order(const std::vector<size_t> &dims) {
+		size_t n = dims.size() - 1;
+		std::vector<size_t> order(n * n, 0);
+		std::vector<double> cost(n * n, 0.0);
+
+		for (size_t length = 2; length <= n; length++) {
+			for (size_t i = 0; i + length <= n; i++) {
+				size_t j = i + length - 1;
+				double best = std::numeric_limits<double>::infinity();
+				for (size_t split = i; split < j; split++) {
+					double c = cost[i * n + split] + cost[(split + 1) * n + j] +
+						double(dims[i]) * double(dims[split + 1]) * double(dims[j + 1]);
+					if (c < best) {
+						best = c;
+						order[i * n + j] = split;
+					}
+				}
+				cost[i * n + j] = best;
+			}
+		}
+		return order;
+	}
+
+	// Check the chain, find the order and evaluate it into the result
+	template<typename First, typename... Rest>
+	auto multiply(const First &first, const Rest &... rest) {
+		static_assert(sizeof...(Rest) > 0, "A chain needs at least two operands.");
+		using T = typename First::value_type;
+		static_assert((std::is_same_v<T, typename Rest::value_type> && ...),
+			"All operands need the same entry type.");
+		using Last = std::tuple_element_t<sizeof...(Rest) - 1, std::tuple<Rest...>>;
+
+		std::vector<detail::chain_operand<T>> operands = { detail::make_chain_operand(first, true),
+			detail::make_chain_operand(rest, false)... };
+
+		std::vector<size_t> dims(1, operands.front().rows);
+		for (size_t k = 0; k < operands.size(); k++) {
+			if (k > 0 && operands[k - 1].cols != operands[k].rows) {
+				throw std::runtime_error("Can not multiply by a matrix which rows does not \
+										  match the columns of the original matrix.");
+			}
+			dims.push_back(operands[k].cols);
+		}
+		std::vector<size_t> order = chain_order(dims);
+		size_t last = operands.size() - 1;
+
+		if constexpr (First::is_vector && Last::is_vector) {
+			T result(0);
+			detail::multiply_chain(operands, order, 0, last, &result);
+			return result;
+		}
+		else if constexpr (First::is_vector || Last::is_vector) {
+			vector<T> result(First::is_vector ? dims.back() : dims.front());
+			detail::multiply_chain(operands, order, 0, last, result.data());
+			return result;
+		}
+		else {
+			matrix<T> result(dims.front(), dims.back());
+			detail::multiply_chain(operands, order, 0, last, result.data());
+			return result;
+		}
+	}
+}
\ No newline at end of file
@@ -56,42 +56,51 @@ namespace la {
 	}
 
 	complex& complex::operator*=(double other) {
-		*this = *this * other;
+		m_real *= other;
+		m_img *= other;
 		return *this;
 	}
 
 	complex& complex::operator*=(const complex &other) {
-		*this = *this * other;
+		double re = m_real * other.m_real - m_img * other.m_img;
+		m_img = m_real * other.m_img + m_img * other.m_real;
+		m_real = re;
 		return *this;
 	}
 
 	complex& complex::operator/=(double other) {
-		*this = *this / other;
+		m_real /= other;
+		m_img /= other;
 		return *this;
 	}
 
 	complex& complex::operator/=(const complex &other) {
-		*this = *this / other;
+		double norm = other.m_real * other.m_real + other.m_img * other.m_img;
+		double re = (m_real * other.m_real + m_img * other.m_img) / norm;
+		m_img = (m_img * other.m_real - m_real * other.m_img) / norm;
+		m_real = re;
 		return *this;
 	}
 
 	complex& complex::operator+=(double other) {
-		*this = *this + other;
+		m_real += other;
 		return *this;
 	}
 
 	complex& complex::operator+=(const complex &other) {
-		*this = *this + other;
+		m_real += other.m_real;
+		m_img += other.m_img;
 		return *this;
 	}
 
 	complex& complex::operator-=(double other) {
-		*this = *this - other;
+		m_real -= other;
 		return *this;
 	}
 
 	complex& complex::operator-=(const complex &other) {
-		*this = *this - other;
+		m_real -= other.m_real;
+		m_img -= other.m_img;
 		return *this;
 	}
 
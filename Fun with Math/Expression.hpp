@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include "Transpose.hpp"
+
+namespace la {
+	// Dimension of matrices and vectors which size is only known at runtime
+	constexpr size_t dynamic = 0;
+
+	// Matrices and vectors with dimensions known at compile time are stored
+	// inline, see FixedMatrix.hpp and FixedVector.hpp. The defaults select the
+	// dynamically sized types of Matrix.hpp and Vector.hpp.
+	template<typename T = double, size_t R = dynamic, size_t C = dynamic>
+	class matrix;
+
+	template<typename T = double, size_t N = dynamic>
+	class vector;
+
+	// Order in which the entries of a matrix lie in memory
+	enum class layout {
+		// Entries of a row are contiguous, the order of la::matrix
+		row_major,
+		// Entries of a column are contiguous, the order of Fortran and LAPACK
+		column_major
+	};
+
+	template<typename T>
+	class matrix_view;
+
+	// Base class of everything that can appear in an elementwise expression. An
+	// expression describes its result lazily: rows(), columns() and the value of
+	// every entry by its row-major index eval(i). Nothing is computed until the
+	// expression gets assigned to a matrix or vector, which then happens in a
+	// single pass without temporaries.
+	//
+	// Derived classes provide
+	//   value_type  type of the entries
+	//   is_vector   whether the expression is a la::vector
+	//   is_leaf     whether it is a la::matrix or la::vector holding storage
+	template<typename E>
+	class matrix_expression {
+	public:
+		// Access the actual expression
+		const E& self() const noexcept { return static_cast<const E&>(*this); }
+
+		size_t rows() const noexcept { return self().rows(); }
+		size_t columns() const noexcept { return self().columns(); }
+		size_t entries() const noexcept { return rows() * columns(); }
+
+		// Evaluate a single entry, throws std::out_of_range for invalid indices
+		auto operator()(size_t i, size_t j) const {
+			if (i >= rows() || j >= columns()) {
+				throw std::out_of_range("Exceeded matrix range.");
+			}
+			return self().eval(i * columns() + j);
+		}
+	};
+
+	// Check if a type is a matrix or vector expression
+	template<typename E>
+	constexpr bool is_matrix_expression_v =
+		std::is_base_of_v<matrix_expression<std::decay_t<E>>, std::decay_t<E>>;
+
+	// Check if an expression knows the layout of its operands
+	template<typename E, typename = void>
+	struct has_storage_layout : std::false_type {};
+
+	template<typename E>
+	struct has_storage_layout<E, std::void_t<decltype(std::declval<const E &>().storage_layout())>>
+		: std::true_type {};
+
+	// Order in which the entries of an expression are read fastest. Views tell
+	// their layout, elementwise combinations the one all their operands share,
+	// everything else is row-major.
+	template<typename E>
+	layout expression_layout(const E &e) noexcept {
+		if constexpr (has_storage_layout<E>::value) {
+			return e.storage_layout();
+		}
+		else {
+			return layout::row_major;
+		}
+	}
+
+	// Call f(i, j) for every entry of a rows x cols matrix (may be
+	// multithreaded). If the destination and the source of f share a layout,
+	// the entries are visited in that order. Otherwise one of them is read
+	// across its layout, so both are walked in tiles small enough to keep the
+	// lines of the strided side in L1 until all their entries are used.
+	template<typename F>
+	void for_each_entry(size_t rows, size_t cols, layout dst, layout src, F f) {
+		const size_t minEntriesPerTask = 1 << 15;
+
+		thread_pool &pool = thread_pool::instance();
+		if (dst == layout::row_major && src == layout::row_major) {
+			pool.parallel_for(0, rows, std::max<size_t>(minEntriesPerTask / std::max<size_t>(cols, 1), 1),
+				[&f, cols](size_t first, size_t last) {
+				for (size_t i = first; i < last; i++) {
+					for (size_t j = 0; j < cols; j++) { f(i, j); }
+				}
+			});
+		}
+		else if (dst == layout::column_major && src == layout::column_major) {
+			pool.parallel_for(0, cols, std::max<size_t>(minEntriesPerTask / std::max<size_t>(rows, 1), 1),
+				[&f, rows](size_t first, size_t last) {
+				for (size_t j = first; j < last; j++) {
+					for (size_t i = 0; i < rows; i++) { f(i, j); }
+				}
+			});
+		}
+		else {
+			size_t rowTiles = (rows + transpose_tile - 1) / transpose_tile;
+			size_t tilesPerTask = std::max<size_t>(minEntriesPerTask / std::max<size_t>(cols * transpose_tile, 1), 1);
+			pool.parallel_for(0, rowTiles, tilesPerTask, [&f, rows, cols](size_t first, size_t last) {
+				for (size_t i0 = first * transpose_tile; i0 < std::min(last * transpose_tile, rows); i0 += transpose_tile) {
+					size_t i1 = std::min(i0 + transpose_tile, rows);
+					for (size_t j0 = 0; j0 < cols; j0 += transpose_tile) {
+						size_t j1 = std::min(j0 + transpose_tile, cols);
+						for (size_t j = j0; j < j1; j++) {
+							for (size_t i = i0; i < i1; i++) { f(i, j); }
+						}
+					}
+				}
+			});
+		}
+	}
+
+	// Operands of an expression node. Named matrices and vectors are referenced,
+	// temporaries and other nodes are stored by value so expressions may safely
+	// outlive the statement that created them.
+	template<typename E>
+	using expression_operand_t = std::conditional_t<
+		std::is_lvalue_reference_v<E> && std::decay_t<E>::is_leaf,
+		const std::decay_t<E>&, std::decay_t<E>>;
+
+	// Elementwise combination of two expressions of equal dimensions
+	template<typename L, typename R, typename Op>
+	class binary_expression : public matrix_expression<binary_expression<L, R, Op>> {
+	private:
+		expression_operand_t<L> m_lhs;
+		expression_operand_t<R> m_rhs;
+
+	public:
+		using value_type = typename std::decay_t<L>::value_type;
+		static constexpr bool is_vector = std::decay_t<L>::is_vector;
+		static constexpr bool is_leaf = false;
+
+		// Throws std::runtime_error if the dimensions differ
+		binary_expression(L &&lhs, R &&rhs)
+			: m_lhs(std::forward<L>(lhs)), m_rhs(std::forward<R>(rhs)) {
+			static_assert(std::decay_t<L>::is_vector == std::decay_t<R>::is_vector,
+				"Can not combine matrices and vectors elementwise.");
+			if (m_lhs.rows() != m_rhs.rows() || m_lhs.columns() != m_rhs.columns()) {
+				throw std::runtime_error(is_vector ? "Vectors can not differ in dimension."
+					: "Dimensions of matrices can not differ from each other.");
+			}
+		}
+
+		size_t rows() const noexcept { return m_lhs.rows(); }
+		size_t columns() const noexcept { return m_lhs.columns(); }
+		value_type eval(size_t i) const { return Op()(m_lhs.eval(i), m_rhs.eval(i)); }
+
+		// Layout shared by both operands, row-major if they differ
+		layout storage_layout() const noexcept {
+			layout l = expression_layout(m_lhs);
+			return l == expression_layout(m_rhs) ? l : layout::row_major;
+		}
+
+		// Operands, used to recognize expressions with dedicated kernels
+		const std::decay_t<L>& lhs() const noexcept { return m_lhs; }
+		const std::decay_t<R>& rhs() const noexcept { return m_rhs; }
+	};
+
+	// Elementwise combination of an expression with a scalar
+	template<typename E, typename Op>
+	class scalar_expression : public matrix_expression<scalar_expression<E, Op>> {
+	public:
+		using value_type = typename std::decay_t<E>::value_type;
+		static constexpr bool is_vector = std::decay_t<E>::is_vector;
+		static constexpr bool is_leaf = false;
+
+	private:
+		expression_operand_t<E> m_expr;
+		value_type m_scalar;
+
+	public:
+		scalar_expression(E &&expr, const value_type &scalar)
+			: m_expr(std::forward<E>(expr)), m_scalar(scalar)
+		{}
+
+		size_t rows() const noexcept { return m_expr.rows(); }
+		size_t columns() const noexcept { return m_expr.columns(); }
+		value_type eval(size_t i) const { return Op()(m_expr.eval(i), m_scalar); }
+
+		// Layout of the operand
+		layout storage_layout() const noexcept { return expression_layout(m_expr); }
+
+		// Operands, used to recognize expressions with dedicated kernels
+		const std::decay_t<E>& expression() const noexcept { return m_expr; }
+		const value_type& scalar() const noexcept { return m_scalar; }
+	};
+
+	// Evaluate an expression into contiguous storage, applying op(dst[i], e.eval(i))
+	// for every entry (may be multithreaded). Reading entry i of an operand and
+	// writing entry i of the destination in the same step keeps statements like
+	// a = b + a correct. Expressions of column-major views are read in tiles.
+	template<typename T, typename E, typename Op>
+	void evaluate(T *dst, const matrix_expression<E> &expr, Op op) {
+		const size_t minEntriesPerTask = 1 << 15;
+
+		const E &e = expr.self();
+		if (!E::is_vector && expression_layout(e) == layout::column_major) {
+			size_t cols = expr.columns();
+			for_each_entry(expr.rows(), cols, layout::row_major, layout::column_major,
+				[dst, &e, &op, cols](size_t i, size_t j) { op(dst[i * cols + j], e.eval(i * cols + j)); });
+			return;
+		}
+
+		thread_pool::instance().parallel_for(0, expr.entries(), minEntriesPerTask,
+			[dst, &e, &op](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				op(dst[i], e.eval(i));
+			}
+		});
+	}
+
+	// Check if an expression combines two matrices or vectors with Op
+	template<typename E, typename Op>
+	struct is_leaf_binary : std::false_type {};
+
+	template<typename L, typename R, typename Op>
+	struct is_leaf_binary<binary_expression<L, R, Op>, Op>
+		: std::bool_constant<std::decay_t<L>::is_leaf && std::decay_t<R>::is_leaf> {};
+
+	// Check if an expression is a view of a matrix
+	template<typename E>
+	struct is_matrix_view : std::false_type {};
+
+	template<typename T>
+	struct is_matrix_view<matrix_view<T>> : std::true_type {};
+
+	// Check if an expression combines a matrix or vector with a scalar by Op
+	template<typename E, typename Op>
+	struct is_leaf_scalar : std::false_type {};
+
+	template<typename E, typename Op>
+	struct is_leaf_scalar<scalar_expression<E, Op>, Op>
+		: std::bool_constant<std::decay_t<E>::is_leaf> {};
+
+	// Assign an expression to contiguous storage (may be multithreaded). Sums and
+	// differences of two matrices or vectors and their products and quotients
+	// with a scalar run on the SIMD kernels, column-major views are copied by the
+	// transposition kernel, everything else is evaluated entry by entry.
+	template<typename T, typename E>
+	void assign(T *dst, const matrix_expression<E> &expr) {
+		const size_t minEntriesPerTask = 1 << 15;
+
+		const E &e = expr.self();
+		auto simd = [dst, &expr](auto kernel) {
+			thread_pool::instance().parallel_for(0, expr.entries(), minEntriesPerTask,
+				[dst, &kernel](size_t first, size_t last) { kernel(first, last - first, dst + first); });
+		};
+
+		if constexpr (simd_supported_v<T> && is_leaf_binary<E, std::plus<>>::value) {
+			simd([&e](size_t i, size_t n, T *d) { simd_add(e.lhs().data() + i, e.rhs().data() + i, d, n); });
+		}
+		else if constexpr (simd_supported_v<T> && is_leaf_binary<E, std::minus<>>::value) {
+			simd([&e](size_t i, size_t n, T *d) { simd_sub(e.lhs().data() + i, e.rhs().data() + i, d, n); });
+		}
+		else if constexpr (simd_supported_v<T> && is_leaf_scalar<E, std::multiplies<>>::value) {
+			simd([&e](size_t i, size_t n, T *d) { simd_scale(e.expression().data() + i, e.scalar(), d, n); });
+		}
+		else if constexpr (std::is_floating_point_v<T> && simd_supported_v<T>
+			&& is_leaf_scalar<E, std::divides<>>::value) {
+			simd([&e](size_t i, size_t n, T *d) { simd_divide(e.expression().data() + i, e.scalar(), d, n); });
+		}
+		else {
+			if constexpr (is_matrix_view<E>::value) {
+				if (e.storage_layout() == layout::column_major) {
+					transpose_parallel(e.columns(), e.rows(), e.data(), e.column_stride(), dst, e.columns());
+					return;
+				}
+			}
+			evaluate(dst, expr, [](T &d, const T &val) { d = val; });
+		}
+	}
+
+	// Add two expressions
+	template<typename L, typename R,
+		typename = std::enable_if_t<is_matrix_expression_v<L> && is_matrix_expression_v<R>>>
+	binary_expression<L, R, std::plus<>> operator+(L &&lhs, R &&rhs) {
+		return binary_expression<L, R, std::plus<>>(std::forward<L>(lhs), std::forward<R>(rhs));
+	}
+
+	// Subtract two expressions
+	template<typename L, typename R,
+		typename = std::enable_if_t<is_matrix_expression_v<L> && is_matrix_expression_v<R>>>
+	binary_expression<L, R, std::minus<>> operator-(L &&lhs, R &&rhs) {
+		return binary_expression<L, R, std::minus<>>(std::forward<L>(lhs), std::forward<R>(rhs));
+	}
+
+	// Multiply expression by constant
+	template<typename E, typename = std::enable_if_t<is_matrix_expression_v<E>>>
+	scalar_expression<E, std::multiplies<>> operator*(E &&expr,
+		const typename std::decay_t<E>::value_type &scalar) {
+		return scalar_expression<E, std::multiplies<>>(std::forward<E>(expr), scalar);
+	}
+
+	// Allow left handed multiplication by constant
+	template<typename E, typename = std::enable_if_t<is_matrix_expression_v<E>>>
+	scalar_expression<E, std::multiplies<>> operator*(
+		const typename std::decay_t<E>::value_type &scalar, E &&expr) {
+		return scalar_expression<E, std::multiplies<>>(std::forward<E>(expr), scalar);
+	}
+
+	// Divide expression by constant
+	template<typename E, typename = std::enable_if_t<is_matrix_expression_v<E>>>
+	scalar_expression<E, std::divides<>> operator/(E &&expr,
+		const typename std::decay_t<E>::value_type &scalar) {
+		return scalar_expression<E, std::divides<>>(std::forward<E>(expr), scalar);
+	}
+
+	// Allow unevaluated expressions to be printed
+	template<typename E, typename = std::enable_if_t<!E::is_leaf>>
+	std::ostream& operator<<(std::ostream &os, const matrix_expression<E> &expr) {
+		using result = std::conditional_t<E::is_vector, vector<typename E::value_type>,
+			matrix<typename E::value_type>>;
+		return os << result(expr);
+	}
+}
\ No newline at end of file
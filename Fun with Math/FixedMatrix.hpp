@@ -0,0 +1,467 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "Matrix.hpp"
+
+namespace la {
+	// Call f(i) for every i in [0, N). The calls are expanded at compile time, so
+	// loops of the fixed size types are fully unrolled regardless of the optimizer.
+	template<typename F, size_t... I>
+	constexpr void static_for(F &&f, std::index_sequence<I...>) {
+		(f(I), ...);
+	}
+
+	template<size_t N, typename F>
+	constexpr void static_for(F &&f) {
+		static_for(std::forward<F>(f), std::make_index_sequence<N>());
+	}
+
+	namespace detail {
+		// Determinant of the N x N matrix a, N <= 4, by cofactor expansion
+		template<typename T, size_t N>
+		constexpr T determinant(const T *a) {
+			static_assert(N >= 1 && N <= 4, "Closed-form determinant only exists up to 4x4.");
+
+			if constexpr (N == 1) {
+				return a[0];
+			}
+			else if constexpr (N == 2) {
+				return a[0] * a[3] - a[1] * a[2];
+			}
+			else if constexpr (N == 3) {
+				return a[0] * (a[4] * a[8] - a[5] * a[7])
+					- a[1] * (a[3] * a[8] - a[5] * a[6])
+					+ a[2] * (a[3] * a[7] - a[4] * a[6]);
+			}
+			else {
+				// Expand along the first two rows: every 2x2 minor of them times the
+				// complementary minor of the last two rows
+				T s0 = a[0] * a[5] - a[1] * a[4];
+				T s1 = a[0] * a[6] - a[2] * a[4];
+				T s2 = a[0] * a[7] - a[3] * a[4];
+				T s3 = a[1] * a[6] - a[2] * a[5];
+				T s4 = a[1] * a[7] - a[3] * a[5];
+				T s5 = a[2] * a[7] - a[3] * a[6];
+				T c0 = a[8] * a[13] - a[9] * a[12];
+				T c1 = a[8] * a[14] - a[10] * a[12];
+				T c2 = a[8] * a[15] - a[11] * a[12];
+				T c3 = a[9] * a[14] - a[10] * a[13];
+				T c4 = a[9] * a[15] - a[11] * a[13];
+				T c5 = a[10] * a[15] - a[11] * a[14];
+				return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+			}
+		}
+
+		// Write the adjugate of the N x N matrix a, N <= 4, to b and return the
+		// determinant. Shared by the inverse of fixed size matrices and batches.
+		template<typename T, size_t N>
+		constexpr T adjugate(const T *a, T *b) {
+			static_assert(N >= 1 && N <= 4, "Closed-form adjugate only exists up to 4x4.");
+
+			T det(0);
+			if constexpr (N == 1) {
+				b[0] = T(1);
+				det = a[0];
+			}
+			else if constexpr (N == 2) {
+				b[0] = a[3];
+				b[1] = T(0) - a[1];
+				b[2] = T(0) - a[2];
+				b[3] = a[0];
+				det = a[0] * a[3] - a[1] * a[2];
+			}
+			else if constexpr (N == 3) {
+				b[0] = a[4] * a[8] - a[5] * a[7];
+				b[1] = a[2] * a[7] - a[1] * a[8];
+				b[2] = a[1] * a[5] - a[2] * a[4];
+				b[3] = a[5] * a[6] - a[3] * a[8];
+				b[4] = a[0] * a[8] - a[2] * a[6];
+				b[5] = a[2] * a[3] - a[0] * a[5];
+				b[6] = a[3] * a[7] - a[4] * a[6];
+				b[7] = a[1] * a[6] - a[0] * a[7];
+				b[8] = a[0] * a[4] - a[1] * a[3];
+				det = a[0] * b[0] + a[1] * b[3] + a[2] * b[6];
+			}
+			else {
+				// Same 2x2 minors as in the determinant
+				T s0 = a[0] * a[5] - a[1] * a[4];
+				T s1 = a[0] * a[6] - a[2] * a[4];
+				T s2 = a[0] * a[7] - a[3] * a[4];
+				T s3 = a[1] * a[6] - a[2] * a[5];
+				T s4 = a[1] * a[7] - a[3] * a[5];
+				T s5 = a[2] * a[7] - a[3] * a[6];
+				T c0 = a[8] * a[13] - a[9] * a[12];
+				T c1 = a[8] * a[14] - a[10] * a[12];
+				T c2 = a[8] * a[15] - a[11] * a[12];
+				T c3 = a[9] * a[14] - a[10] * a[13];
+				T c4 = a[9] * a[15] - a[11] * a[13];
+				T c5 = a[10] * a[15] - a[11] * a[14];
+				det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+				b[0] = a[5] * c5 - a[6] * c4 + a[7] * c3;
+				b[1] = a[2] * c4 - a[1] * c5 - a[3] * c3;
+				b[2] = a[13] * s5 - a[14] * s4 + a[15] * s3;
+				b[3] = a[10] * s4 - a[9] * s5 - a[11] * s3;
+				b[4] = a[6] * c2 - a[4] * c5 - a[7] * c1;
+				b[5] = a[0] * c5 - a[2] * c2 + a[3] * c1;
+				b[6] = a[14] * s2 - a[12] * s5 - a[15] * s1;
+				b[7] = a[8] * s5 - a[10] * s2 + a[11] * s1;
+				b[8] = a[4] * c4 - a[5] * c2 + a[7] * c0;
+				b[9] = a[1] * c2 - a[0] * c4 - a[3] * c0;
+				b[10] = a[12] * s4 - a[13] * s2 + a[15] * s0;
+				b[11] = a[9] * s2 - a[8] * s4 - a[11] * s0;
+				b[12] = a[5] * c1 - a[4] * c3 - a[6] * c0;
+				b[13] = a[0] * c3 - a[1] * c1 + a[2] * c0;
+				b[14] = a[13] * s1 - a[12] * s3 - a[14] * s0;
+				b[15] = a[8] * s3 - a[9] * s1 + a[10] * s0;
+			}
+			return det;
+		}
+	}
+
+	// Matrix with dimensions known at compile time. The entries are stored inline
+	// without heap allocation or virtual destructor and access is unchecked, so
+	// small matrices like 3x3 or 4x4 transforms cost no more than plain arrays.
+	// Converts to and from the dynamic la::matrix<T>.
+	template<typename T, size_t R, size_t C>
+	class matrix {
+		static_assert(R != dynamic && C != dynamic,
+			"Matrix dimensions have to be either both fixed or both dynamic.");
+
+	private:
+		// Field to hold values of the matrix in row-major order
+		T m_entries[R * C]{};
+
+	public:
+		using value_type = T;
+
+		// Constructors
+
+		// Default constructor, all entries are 0
+		constexpr matrix() = default;
+		// Construct matrix with all entries set to value
+		constexpr explicit matrix(const T &);
+		// Constructor for std::initializer_list
+		// Throws std::invalid_argument if the lists do not match the dimensions
+		constexpr matrix(std::initializer_list<std::initializer_list<T>>);
+		// Convert dynamic matrix
+		// Throws std::runtime_error if the dimensions differ
+		explicit matrix(const matrix<T> &);
+
+		// Convert to dynamic matrix
+		operator matrix<T>() const;
+
+		// Getter for the dimensions
+		static constexpr size_t rows() noexcept;
+		static constexpr size_t columns() noexcept;
+		static constexpr size_t entries() noexcept;
+		// Raw row-major storage
+		constexpr T* data() noexcept;
+		constexpr const T* data() const noexcept;
+
+		// Matrix algorithms
+		// Determinant and inverse are closed-form up to 4x4, bigger matrices use
+		// the algorithms of the dynamic matrix
+		constexpr T determinant() const;
+		constexpr matrix<T, C, R> transpose() const;
+		constexpr matrix invert() const;
+
+		// Static methods
+		static constexpr matrix identity();
+
+		// Overloaded operators
+
+		// Access operators, unchecked
+		constexpr T operator()(size_t, size_t) const noexcept;
+		constexpr T& operator()(size_t, size_t) noexcept;
+
+		// Arithmetic operators
+		// Dimensions are checked at compile time, nothing throws except invert
+		template<size_t K>
+		constexpr matrix<T, R, K> operator*(const matrix<T, C, K> &) const;
+		constexpr vector<T, R> operator*(const vector<T, C> &) const;
+		constexpr matrix operator*(const T &) const;
+		constexpr matrix operator/(const T &) const;
+		constexpr matrix operator+(const matrix &) const;
+		constexpr matrix operator-(const matrix &) const;
+
+		// Assignment operators
+		constexpr matrix& operator*=(const matrix<T, C, C> &);
+		constexpr matrix& operator*=(const T &);
+		constexpr matrix& operator/=(const T &);
+		constexpr matrix& operator+=(const matrix &);
+		constexpr matrix& operator-=(const matrix &);
+
+		// Comparison operators
+		constexpr bool operator==(const matrix &) const;
+		constexpr bool operator!=(const matrix &) const;
+	};
+
+	// Allow left handed multiplication by constant
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C> operator*(const T &, const matrix<T, R, C> &);
+
+	// Allow matrices to be printed
+	template<typename T, size_t R, size_t C>
+	std::ostream& operator<<(std::ostream &, const matrix<T, R, C> &);
+
+	// Create matrix with all entries set to value
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C>::matrix(const T &value) {
+		static_for<R * C>([&](size_t i) { m_entries[i] = value; });
+	}
+
+	// Create matrix from intializer_lists
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C>::matrix(std::initializer_list<std::initializer_list<T>> list) {
+		// Check for valid argument
+		if (list.size() != R) {
+			throw std::invalid_argument("Amount of rows has to match the matrix.");
+		}
+
+		size_t i = 0;
+		for (const auto &row : list) {
+			if (row.size() != C) {
+				throw std::invalid_argument("Length of rows has to match the matrix.");
+			}
+			for (const auto &value : row) {
+				m_entries[i++] = value;
+			}
+		}
+	}
+
+	// Copy the entries of a dynamic matrix of equal dimensions
+	template<typename T, size_t R, size_t C>
+	matrix<T, R, C>::matrix(const matrix<T> &other) {
+		// Check for valid argument
+		if (other.rows() != R || other.columns() != C) {
+			throw std::runtime_error("Dimensions of matrices can not differ from each other.");
+		}
+		std::copy(other.data(), other.data() + R * C, m_entries);
+	}
+
+	// Copy the entries into a dynamic matrix
+	template<typename T, size_t R, size_t C>
+	matrix<T, R, C>::operator matrix<T>() const {
+		matrix<T> m(R, C);
+		std::copy(m_entries, m_entries + R * C, m.data());
+		return m;
+	}
+
+	// Getter for rows
+	template<typename T, size_t R, size_t C>
+	constexpr size_t matrix<T, R, C>::rows() noexcept {
+		return R;
+	}
+
+	// Getter for columns
+	template<typename T, size_t R, size_t C>
+	constexpr size_t matrix<T, R, C>::columns() noexcept {
+		return C;
+	}
+
+	// Getter for entries
+	template<typename T, size_t R, size_t C>
+	constexpr size_t matrix<T, R, C>::entries() noexcept {
+		return R * C;
+	}
+
+	// Getter for the storage
+	template<typename T, size_t R, size_t C>
+	constexpr T* matrix<T, R, C>::data() noexcept {
+		return m_entries;
+	}
+
+	// Getter for the storage
+	template<typename T, size_t R, size_t C>
+	constexpr const T* matrix<T, R, C>::data() const noexcept {
+		return m_entries;
+	}
+
+	// Calculate the determinant by cofactor expansion
+	template<typename T, size_t R, size_t C>
+	constexpr T matrix<T, R, C>::determinant() const {
+		static_assert(R == C, "Matrix has to be quadratic.");
+
+		if constexpr (R <= 4) {
+			return detail::determinant<T, R>(m_entries);
+		}
+		else {
+			return matrix<T>(*this).determinant();
+		}
+	}
+
+	// Create transposed matrix
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, C, R> matrix<T, R, C>::transpose() const {
+		matrix<T, C, R> m;
+		static_for<R * C>([&](size_t ij) {
+			m(ij % C, ij / C) = m_entries[ij];
+		});
+		return m;
+	}
+
+	// Invert matrix by its adjugate
+	// Throws std::invalid_argument if the matrix is singular
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C> matrix<T, R, C>::invert() const {
+		static_assert(R == C, "Matrix has to be quadratic.");
+
+		if constexpr (R <= 4) {
+			matrix adj;
+			T det = detail::adjugate<T, R>(m_entries, adj.m_entries);
+
+			if (det == T(0)) {
+				throw std::invalid_argument("Matrix is not invertible.");
+			}
+			return adj / det;
+		}
+		else {
+			return matrix(matrix<T>(*this).invert());
+		}
+	}
+
+	// Create identity matrix
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C> matrix<T, R, C>::identity() {
+		static_assert(R == C, "Matrix has to be quadratic.");
+
+		matrix m;
+		static_for<R>([&](size_t i) { m.m_entries[i * C + i] = T(1); });
+		return m;
+	}
+
+	// Access entries of the matrix by value
+	template<typename T, size_t R, size_t C>
+	constexpr T matrix<T, R, C>::operator()(size_t i, size_t j) const noexcept {
+		return m_entries[i * C + j];
+	}
+
+	// Access entries of the matrix by reference
+	template<typename T, size_t R, size_t C>
+	constexpr T& matrix<T, R, C>::operator()(size_t i, size_t j) noexcept {
+		return m_entries[i * C + j];
+	}
+
+	// Multiply two matrices
+	template<typename T, size_t R, size_t C>
+	template<size_t K>
+	constexpr matrix<T, R, K> matrix<T, R, C>::operator*(const matrix<T, C, K> &other) const {
+		matrix<T, R, K> m;
+		static_for<R * K>([&](size_t ij) {
+			size_t i = ij / K, j = ij % K;
+			T sum(0);
+			static_for<C>([&](size_t k) { sum += m_entries[i * C + k] * other(k, j); });
+			m(i, j) = sum;
+		});
+		return m;
+	}
+
+	// Multiply matrix by vector
+	template<typename T, size_t R, size_t C>
+	constexpr vector<T, R> matrix<T, R, C>::operator*(const vector<T, C> &other) const {
+		vector<T, R> v;
+		static_for<R>([&](size_t i) {
+			T sum(0);
+			static_for<C>([&](size_t k) { sum += m_entries[i * C + k] * other[k]; });
+			v[i] = sum;
+		});
+		return v;
+	}
+
+	// Multiply matrix by constant
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C> matrix<T, R, C>::operator*(const T &other) const {
+		matrix m(*this);
+		return m *= other;
+	}
+
+	// Divide matrix by constant
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C> matrix<T, R, C>::operator/(const T &other) const {
+		matrix m(*this);
+		return m /= other;
+	}
+
+	// Add two matrices
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C> matrix<T, R, C>::operator+(const matrix &other) const {
+		matrix m(*this);
+		return m += other;
+	}
+
+	// Subtract two matrices
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C> matrix<T, R, C>::operator-(const matrix &other) const {
+		matrix m(*this);
+		return m -= other;
+	}
+
+	// Multiply by quadratic matrix in place
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C>& matrix<T, R, C>::operator*=(const matrix<T, C, C> &other) {
+		return *this = *this * other;
+	}
+
+	// Multiply by constant in place
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C>& matrix<T, R, C>::operator*=(const T &other) {
+		static_for<R * C>([&](size_t i) { m_entries[i] *= other; });
+		return *this;
+	}
+
+	// Divide by constant in place
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C>& matrix<T, R, C>::operator/=(const T &other) {
+		static_for<R * C>([&](size_t i) { m_entries[i] = m_entries[i] / other; });
+		return *this;
+	}
+
+	// Add matrix in place
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C>& matrix<T, R, C>::operator+=(const matrix &other) {
+		static_for<R * C>([&](size_t i) { m_entries[i] += other.m_entries[i]; });
+		return *this;
+	}
+
+	// Subtract matrix in place
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C>& matrix<T, R, C>::operator-=(const matrix &other) {
+		static_for<R * C>([&](size_t i) { m_entries[i] -= other.m_entries[i]; });
+		return *this;
+	}
+
+	// Check two matrices for equality
+	template<typename T, size_t R, size_t C>
+	constexpr bool matrix<T, R, C>::operator==(const matrix &other) const {
+		for (size_t i = 0; i < R * C; i++) {
+			if (m_entries[i] != other.m_entries[i]) { return false; }
+		}
+		return true;
+	}
+
+	// Check two matrices for inequality
+	template<typename T, size_t R, size_t C>
+	constexpr bool matrix<T, R, C>::operator!=(const matrix &other) const {
+		return !(*this == other);
+	}
+
+	// Multiply constant by matrix
+	template<typename T, size_t R, size_t C>
+	constexpr matrix<T, R, C> operator*(const T &scalar, const matrix<T, R, C> &m) {
+		return m * scalar;
+	}
+
+	// Print fixed size matrices like dynamic ones
+	template<typename T, size_t R, size_t C>
+	std::ostream& operator<<(std::ostream &os, const matrix<T, R, C> &m) {
+		return os << static_cast<matrix<T>>(m);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "FixedMatrix.hpp"
+#include "Vector.hpp"
+
+namespace la {
+	// Vector with dimension known at compile time, stored inline like the fixed
+	// size matrix. Converts to and from the dynamic la::vector<T>.
+	template<typename T, size_t N>
+	class vector {
+	private:
+		// Field to hold values of the vector
+		T m_entries[N]{};
+
+	public:
+		using value_type = T;
+
+		// Constructors
+
+		// Default constructor, all entries are 0
+		constexpr vector() = default;
+		// Construct vector with all entries set to value
+		constexpr explicit vector(const T &);
+		// Constructor for std::initializer_list
+		// Throws std::invalid_argument if the list does not match the dimension
+		constexpr vector(std::initializer_list<T>);
+		// Convert dynamic vector
+		// Throws std::runtime_error if the dimensions differ
+		explicit vector(const vector<T> &);
+
+		// Convert to dynamic vector
+		operator vector<T>() const;
+
+		// Getter for dimension
+		static constexpr size_t size() noexcept;
+		// Raw storage
+		constexpr T* data() noexcept;
+		constexpr const T* data() const noexcept;
+		// Return vector norm
+		double norm() const;
+		// Return unit vector
+		vector unit() const;
+
+		// Calculate angle between vectors
+		double angle(const vector &) const;
+		// Check if two vectors are orthogonal
+		constexpr bool orthogonal(const vector &) const;
+
+		// Overloaded operators
+
+		// Access operators, unchecked
+		constexpr T operator[](size_t) const noexcept;
+		constexpr T& operator[](size_t) noexcept;
+
+		// Arithmetic operators
+		// Dimensions are checked at compile time
+		constexpr T operator*(const vector &) const;
+		template<size_t K>
+		constexpr vector<T, K> operator*(const matrix<T, N, K> &) const;
+		constexpr vector operator*(const T &) const;
+		constexpr vector operator/(const T &) const;
+		constexpr vector operator+(const vector &) const;
+		constexpr vector operator-(const vector &) const;
+
+		// Assignment operators
+		constexpr vector& operator*=(const T &);
+		constexpr vector& operator/=(const T &);
+		constexpr vector& operator+=(const vector &);
+		constexpr vector& operator-=(const vector &);
+
+		// Comparison operators
+		constexpr bool operator==(const vector &) const;
+		constexpr bool operator!=(const vector &) const;
+	};
+
+	// Allow left handed multiplication by constant
+	template<typename T, size_t N>
+	constexpr vector<T, N> operator*(const T &, const vector<T, N> &);
+
+	// Allow vectors to be printed
+	template<typename T, size_t N>
+	std::ostream& operator<<(std::ostream &, const vector<T, N> &);
+
+	// Create vector with all entries set to value
+	template<typename T, size_t N>
+	constexpr vector<T, N>::vector(const T &value) {
+		static_for<N>([&](size_t i) { m_entries[i] = value; });
+	}
+
+	// Create vector from initializer_list
+	template<typename T, size_t N>
+	constexpr vector<T, N>::vector(std::initializer_list<T> list) {
+		// Check for valid argument
+		if (list.size() != N) {
+			throw std::invalid_argument("Size of list has to match the vector.");
+		}
+
+		size_t i = 0;
+		for (const auto &value : list) {
+			m_entries[i++] = value;
+		}
+	}
+
+	// Copy the entries of a dynamic vector of equal dimension
+	template<typename T, size_t N>
+	vector<T, N>::vector(const vector<T> &other) {
+		// Check for valid argument
+		if (other.size() != N) {
+			throw std::runtime_error("Vectors can not differ in dimension.");
+		}
+		for (size_t i = 0; i < N; i++) {
+			m_entries[i] = other.eval(i);
+		}
+	}
+
+	// Copy the entries into a dynamic vector
+	template<typename T, size_t N>
+	vector<T, N>::operator vector<T>() const {
+		vector<T> v(N);
+		for (size_t i = 0; i < N; i++) {
+			v[i] = m_entries[i];
+		}
+		return v;
+	}
+
+	// Return size of vector
+	template<typename T, size_t N>
+	constexpr size_t vector<T, N>::size() noexcept {
+		return N;
+	}
+
+	// Getter for the storage
+	template<typename T, size_t N>
+	constexpr T* vector<T, N>::data() noexcept {
+		return m_entries;
+	}
+
+	// Getter for the storage
+	template<typename T, size_t N>
+	constexpr const T* vector<T, N>::data() const noexcept {
+		return m_entries;
+	}
+
+	// Calculate the norm of the vector
+	template<typename T, size_t N>
+	double vector<T, N>::norm() const {
+		// Check vector is arithmetic
+		if constexpr (std::is_arithmetic_v<T>) {
+			return std::sqrt((*this) * (*this));
+		}
+		else {
+			throw std::logic_error("Can not calculate length of non-arithmetic type vector.");
+		}
+	}
+
+	// Return the vector divided my its norm
+	template<typename T, size_t N>
+	vector<T, N> vector<T, N>::unit() const {
+		// Check if vector can be normalized
+		if constexpr (std::is_integral_v<T>) {
+			throw std::logic_error("Can not normalize vector of integral type.");
+		}
+		else {
+			return *this / T(norm());
+		}
+	}
+
+	// Calculate angle between two vectors
+	template<typename T, size_t N>
+	double vector<T, N>::angle(const vector &other) const {
+		return std::acos((*this * other) / (norm() * other.norm()));
+	}
+
+	// Check if two vectors are orthogonal
+	template<typename T, size_t N>
+	constexpr bool vector<T, N>::orthogonal(const vector &other) const {
+		return *this * other == T(0);
+	}
+
+	// Access elements of vector by value
+	template<typename T, size_t N>
+	constexpr T vector<T, N>::operator[](size_t index) const noexcept {
+		return m_entries[index];
+	}
+
+	// Access elements of vector by reference
+	template<typename T, size_t N>
+	constexpr T& vector<T, N>::operator[](size_t index) noexcept {
+		return m_entries[index];
+	}
+
+	// Multiply two vectors
+	template<typename T, size_t N>
+	constexpr T vector<T, N>::operator*(const vector &other) const {
+		T scalar(0);
+		static_for<N>([&](size_t i) { scalar += m_entries[i] * other.m_entries[i]; });
+		return scalar;
+	}
+
+	// Multiply vector by a matrix
+	template<typename T, size_t N>
+	template<size_t K>
+	constexpr vector<T, K> vector<T, N>::operator*(const matrix<T, N, K> &other) const {
+		vector<T, K> v;
+		static_for<K>([&](size_t j) {
+			T sum(0);
+			static_for<N>([&](size_t k) { sum += m_entries[k] * other(k, j); });
+			v[j] = sum;
+		});
+		return v;
+	}
+
+	// Multiply vector by constant
+	template<typename T, size_t N>
+	constexpr vector<T, N> vector<T, N>::operator*(const T &other) const {
+		vector v(*this);
+		return v *= other;
+	}
+
+	// Divide vector by constant
+	template<typename T, size_t N>
+	constexpr vector<T, N> vector<T, N>::operator/(const T &other) const {
+		vector v(*this);
+		return v /= other;
+	}
+
+	// Add two vectors
+	template<typename T, size_t N>
+	constexpr vector<T, N> vector<T, N>::operator+(const vector &other) const {
+		vector v(*this);
+		return v += other;
+	}
+
+	// Subtract two vectors
+	template<typename T, size_t N>
+	constexpr vector<T, N> vector<T, N>::operator-(const vector &other) const {
+		vector v(*this);
+		return v -= other;
+	}
+
+	// Multiply by constant in place
+	template<typename T, size_t N>
+	constexpr vector<T, N>& vector<T, N>::operator*=(const T &other) {
+		static_for<N>([&](size_t i) { m_entries[i] *= other; });
+		return *this;
+	}
+
+	// Divide by constant in place
+	template<typename T, size_t N>
+	constexpr vector<T, N>& vector<T, N>::operator/=(const T &other) {
+		static_for<N>([&](size_t i) { m_entries[i] = m_entries[i] / other; });
+		return *this;
+	}
+
+	// Add vector in place
+	template<typename T, size_t N>
+	constexpr vector<T, N>& vector<T, N>::operator+=(const vector &other) {
+		static_for<N>([&](size_t i) { m_entries[i] += other.m_entries[i]; });
+		return *this;
+	}
+
+	// Subtract vector in place
+	template<typename T, size_t N>
+	constexpr vector<T, N>& vector<T, N>::operator-=(const vector &other) {
+		static_for<N>([&](size_t i) { m_entries[i] -= other.m_entries[i]; });
+		return *this;
+	}
+
+	// Check two vectors for equality
+	template<typename T, size_t N>
+	constexpr bool vector<T, N>::operator==(const vector &other) const {
+		for (size_t i = 0; i < N; i++) {
+			if (m_entries[i] != other.m_entries[i]) { return false; }
+		}
+		return true;
+	}
+
+	// Check two vectors for inequality
+	template<typename T, size_t N>
+	constexpr bool vector<T, N>::operator!=(const vector &other) const {
+		return !(*this == other);
+	}
+
+	// Multiply constant by vector
+	template<typename T, size_t N>
+	constexpr vector<T, N> operator*(const T &scalar, const vector<T, N> &v) {
+		return v * scalar;
+	}
+
+	// Print fixed size vectors like dynamic ones
+	template<typename T, size_t N>
+	std::ostream& operator<<(std::ostream &os, const vector<T, N> &v) {
+		return os << static_cast<vector<T>>(v);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,487 @@
+#include "stdafx.h"
+#include "GF2Matrix.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "ThreadPool.hpp"
+
+namespace la {
+	namespace {
+		const size_t wordBits = 64;
+		// Entries selected by the byte of one table
+		const size_t tableBits = 8;
+		const size_t tableSize = size_t(1) << tableBits;
+		// Pivots cleared by one pass of the elimination, four tables
+		const size_t maxPivots = 4 * tableBits;
+		// Products are computed in tiles of rows and words of the result, the
+		// tables of a tile fit into the L2 cache
+		const size_t tileRows = 1024;
+		const size_t tileWords = 8;
+
+		const size_t minWordsPerTask = 1 << 12;
+
+		size_t words_for(size_t cols) noexcept {
+			return (cols + wordBits - 1) / wordBits;
+		}
+
+		bool test(const uint64_t *row, size_t j) noexcept {
+			return (row[j / wordBits] >> (j % wordBits)) & 1;
+		}
+
+		void add_row(uint64_t *dst, const uint64_t *src, size_t words) noexcept {
+			for (size_t w = 0; w < words; w++) {
+				dst[w] ^= src[w];
+			}
+		}
+
+		// Tabulate all sums of up to tableBits rows: entry x is the sum of the
+		// rows whose bits are set in x. Every entry is the entry without its
+		// lowest bit plus one row, so each costs a single row addition. Bits
+		// beyond count select nothing.
+		void build_table(uint64_t *table, const uint64_t *const *rows, size_t count, size_t words) noexcept {
+			std::fill(table, table + words, 0);
+			for (size_t x = 1; x < tableSize; x++) {
+				size_t bit = 0;
+				while (((x >> bit) & 1) == 0) { bit++; }
+
+				const uint64_t *previous = table + (x & (x - 1)) * words;
+				uint64_t *entry = table + x * words;
+				if (bit < count) {
+					for (size_t w = 0; w < words; w++) {
+						entry[w] = previous[w] ^ rows[bit][w];
+					}
+				}
+				else {
+					std::copy(previous, previous + words, entry);
+				}
+			}
+		}
+
+		// Transpose a block of 64 x 64 bits in place by swapping quadrants of
+		// halving size, all rows of a step at once
+		void transpose_block(uint64_t *a) noexcept {
+			uint64_t mask = 0x00000000ffffffffull;
+			for (size_t j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+				for (size_t k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+					uint64_t t = ((a[k] >> j) ^ a[k | j]) & mask;
+					a[k] ^= t << j;
+					a[k | j] ^= t;
+				}
+			}
+		}
+
+		// Copy count bits of a row of given words, starting at bit offset, to
+		// the start of dst
+		void read_bits(uint64_t *dst, const uint64_t *src, size_t srcWords, size_t offset, size_t count) noexcept {
+			size_t first = offset / wordBits;
+			size_t shift = offset % wordBits;
+			size_t words = words_for(count);
+			for (size_t w = 0; w < words; w++) {
+				uint64_t v = src[first + w] >> shift;
+				if (shift != 0 && first + w + 1 < srcWords) {
+					v |= src[first + w + 1] << (wordBits - shift);
+				}
+				dst[w] = v;
+			}
+			if (count % wordBits != 0) {
+				dst[words - 1] &= (uint64_t(1) << (count % wordBits)) - 1;
+			}
+		}
+
+		// Set count bits of src in dst starting at bit offset, the bits of dst
+		// have to be 0
+		void write_bits(uint64_t *dst, size_t offset, const uint64_t *src, size_t count) noexcept {
+			size_t first = offset / wordBits;
+			size_t shift = offset % wordBits;
+			for (size_t w = 0; w < words_for(count); w++) {
+				dst[first + w] |= src[w] << shift;
+				if (shift != 0 && (src[w] >> (wordBits - shift)) != 0) {
+					dst[first + w + 1] |= src[w] >> (wordBits - shift);
+				}
+			}
+		}
+	}
+
+	// Create zero matrix with given dimensions
+	gf2_matrix::gf2_matrix(size_t rows, size_t cols)
+		: m_rows(rows), m_cols(cols), m_words(words_for(cols)) {
+		if (rows == 0 || cols == 0) {
+			throw std::logic_error("Matrix does not allow zero dimensions.");
+		}
+		m_entries.assign(m_rows * m_words, 0);
+	}
+
+	// Pack every residue class into one bit
+	gf2_matrix::gf2_matrix(const matrix<module_ring<2>> &m)
+		: gf2_matrix(m.rows(), m.columns()) {
+		for (size_t i = 0; i < m_rows; i++) {
+			for (size_t j = 0; j < m_cols; j++) {
+				if (m.unchecked(i, j).value() != 0) {
+					row(i)[j / wordBits] |= uint64_t(1) << (j % wordBits);
+				}
+			}
+		}
+	}
+
+	// Pivots are collected in passes of up to maxPivots columns. Searching a
+	// pivot, the candidate rows are reduced by the pivots of the pass found so
+	// far, a new pivot row is then removed from the earlier ones, so the pivot
+	// rows of a pass are reduced against each other. Their columns are then
+	// cleared in all other rows by tables of their sums, in parallel.
+	std::vector<size_t> gf2_matrix::eliminate(size_t pivotColumns, bool reduced) {
+		std::vector<size_t> pivots;
+		std::vector<uint64_t> tables;
+		size_t r = 0;
+		size_t c = 0;
+
+		while (c < pivotColumns && r < m_rows) {
+			size_t start = r;
+			std::vector<size_t> pass;
+
+			for (; c < pivotColumns && r < m_rows && pass.size() < maxPivots; c++) {
+				size_t p = r;
+				for (; p < m_rows; p++) {
+					uint64_t *candidate = row(p);
+					for (size_t q = 0; q < pass.size(); q++) {
+						if (test(candidate, pass[q])) {
+							size_t w = pass[q] / wordBits;
+							add_row(candidate + w, row(start + q) + w, m_words - w);
+						}
+					}
+					if (test(candidate, c)) { break; }
+				}
+				// No pivot in this column
+				if (p == m_rows) { continue; }
+
+				size_t w = c / wordBits;
+				if (p != r) {
+					std::swap_ranges(row(p), row(p) + m_words, row(r));
+				}
+				for (size_t q = start; q < r; q++) {
+					if (test(row(q), c)) { add_row(row(q) + w, row(r) + w, m_words - w); }
+				}
+				pass.push_back(c);
+				pivots.push_back(c);
+				r++;
+			}
+			if (pass.empty()) { break; }
+
+			// Pivot rows are 0 left of the first pivot of the pass
+			size_t first = pass.front() / wordBits;
+			size_t width = m_words - first;
+			size_t groups = (pass.size() + tableBits - 1) / tableBits;
+			tables.resize(groups * tableSize * width);
+			for (size_t g = 0; g < groups; g++) {
+				const uint64_t *rows[tableBits];
+				size_t count = std::min(tableBits, pass.size() - g * tableBits);
+				for (size_t k = 0; k < count; k++) {
+					rows[k] = row(start + g * tableBits + k) + first;
+				}
+				build_table(tables.data() + g * tableSize * width, rows, count, width);
+			}
+
+			size_t rowsPerTask = std::max<size_t>(minWordsPerTask / width, 1);
+			const uint64_t *t = tables.data();
+			size_t end = r;
+			thread_pool::instance().parallel_for(reduced ? 0 : r, m_rows, rowsPerTask,
+				[this, t, &pass, start, end, first, width, groups](size_t begin, size_t last) {
+				for (size_t i = begin; i < last; i++) {
+					if (i >= start && i < end) { continue; }
+
+					// Read all selectors before the row changes
+					uint64_t *target = row(i);
+					size_t selector[maxPivots / tableBits] = {};
+					for (size_t q = 0; q < pass.size(); q++) {
+						if (test(target, pass[q])) { selector[q / tableBits] |= size_t(1) << (q % tableBits); }
+					}
+					for (size_t g = 0; g < groups; g++) {
+						if (selector[g] != 0) {
+							add_row(target + first, t + (g * tableSize + selector[g]) * width, width);
+						}
+					}
+				}
+			});
+		}
+		return pivots;
+	}
+
+	// Throw if solving or the determinant are not defined
+	void gf2_matrix::check_quadratic() const {
+		if (m_rows != m_cols) {
+			throw std::invalid_argument("Matrix has to be quadratic.");
+		}
+	}
+
+	// Throw if the entry is outside the matrix
+	void gf2_matrix::check_range(size_t i, size_t j) const {
+		if (i >= m_rows || j >= m_cols) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+	}
+
+	// Getter for rows
+	size_t gf2_matrix::rows() const noexcept {
+		return m_rows;
+	}
+
+	// Getter for columns
+	size_t gf2_matrix::columns() const noexcept {
+		return m_cols;
+	}
+
+	// Getter for the words of a packed row
+	size_t gf2_matrix::words_per_row() const noexcept {
+		return m_words;
+	}
+
+	// Packed row
+	uint64_t* gf2_matrix::row(size_t i) noexcept {
+		return m_entries.data() + i * m_words;
+	}
+
+	// Read-only packed row
+	const uint64_t* gf2_matrix::row(size_t i) const noexcept {
+		return m_entries.data() + i * m_words;
+	}
+
+	// Read a single entry
+	bool gf2_matrix::get(size_t i, size_t j) const {
+		check_range(i, j);
+		return (*this)(i, j);
+	}
+
+	// Write a single entry
+	void gf2_matrix::set(size_t i, size_t j, bool value) {
+		check_range(i, j);
+		uint64_t bit = uint64_t(1) << (j % wordBits);
+		if (value) { row(i)[j / wordBits] |= bit; }
+		else { row(i)[j / wordBits] &= ~bit; }
+	}
+
+	// Add 1 to a single entry
+	void gf2_matrix::flip(size_t i, size_t j) {
+		check_range(i, j);
+		row(i)[j / wordBits] ^= uint64_t(1) << (j % wordBits);
+	}
+
+	// Unpack every bit into a residue class
+	matrix<module_ring<2>> gf2_matrix::dense() const {
+		matrix<module_ring<2>> m(m_rows, m_cols);
+		for (size_t i = 0; i < m_rows; i++) {
+			for (size_t j = 0; j < m_cols; j++) {
+				m.unchecked(i, j) = module_ring<2>((*this)(i, j) ? 1 : 0);
+			}
+		}
+		return m;
+	}
+
+	// Transpose in blocks of 64 x 64 bits, block columns in parallel
+	gf2_matrix gf2_matrix::transpose() const {
+		gf2_matrix t(m_cols, m_rows);
+		size_t blockRows = words_for(m_rows);
+
+		thread_pool::instance().parallel_for(0, m_words, 1, [this, &t, blockRows](size_t first, size_t last) {
+			uint64_t block[wordBits];
+			for (size_t bj = first; bj < last; bj++) {
+				for (size_t bi = 0; bi < blockRows; bi++) {
+					for (size_t k = 0; k < wordBits; k++) {
+						size_t i = bi * wordBits + k;
+						block[k] = i < m_rows ? row(i)[bj] : 0;
+					}
+					transpose_block(block);
+					for (size_t k = 0; k < wordBits && bj * wordBits + k < m_cols; k++) {
+						t.row(bj * wordBits + k)[bi] = block[k];
+					}
+				}
+			}
+		});
+		return t;
+	}
+
+	// Number of pivots of the row echelon form
+	size_t gf2_matrix::rank() const {
+		gf2_matrix m(*this);
+		return m.eliminate(m_cols, false).size();
+	}
+
+	// Gauss-jordan elimination of a copy
+	gf2_matrix gf2_matrix::reduced_echelon() const {
+		gf2_matrix m(*this);
+		m.eliminate(m_cols, true);
+		return m;
+	}
+
+	// The determinant is 1 iff the matrix has full rank
+	bool gf2_matrix::determinant() const {
+		check_quadratic();
+		return rank() == m_rows;
+	}
+
+	// Eliminate [A | I] to [I | A^-1]
+	gf2_matrix gf2_matrix::inverse() const {
+		check_quadratic();
+
+		size_t n = m_rows;
+		gf2_matrix system(n, 2 * n);
+		for (size_t i = 0; i < n; i++) {
+			std::copy(row(i), row(i) + m_words, system.row(i));
+			system.row(i)[(n + i) / wordBits] |= uint64_t(1) << ((n + i) % wordBits);
+		}
+		if (system.eliminate(n, true).size() < n) {
+			throw std::invalid_argument("Matrix is not invertible.");
+		}
+
+		gf2_matrix x(n, n);
+		for (size_t i = 0; i < n; i++) {
+			read_bits(x.row(i), system.row(i), system.m_words, n, n);
+		}
+		return x;
+	}
+
+	// Eliminate [A | B] to [I | X]
+	gf2_matrix gf2_matrix::solve(const gf2_matrix &b) const {
+		// Check for valid argument
+		check_quadratic();
+		if (b.m_rows != m_rows) {
+			throw std::invalid_argument("Rows of matrix have to match the matrix.");
+		}
+
+		size_t n = m_rows;
+		gf2_matrix system(n, n + b.m_cols);
+		for (size_t i = 0; i < n; i++) {
+			std::copy(row(i), row(i) + m_words, system.row(i));
+			write_bits(system.row(i), n, b.row(i), b.m_cols);
+		}
+		if (system.eliminate(n, true).size() < n) {
+			throw std::invalid_argument("Matrix is not invertible.");
+		}
+
+		gf2_matrix x(n, b.m_cols);
+		for (size_t i = 0; i < n; i++) {
+			read_bits(x.row(i), system.row(i), system.m_words, n, b.m_cols);
+		}
+		return x;
+	}
+
+	// Create an identity matrix
+	gf2_matrix gf2_matrix::identity(size_t size) {
+		gf2_matrix m(size, size);
+		for (size_t i = 0; i < size; i++) {
+			m.row(i)[i / wordBits] |= uint64_t(1) << (i % wordBits);
+		}
+		return m;
+	}
+
+	// Access elements of matrix without checks
+	bool gf2_matrix::operator()(size_t i, size_t j) const noexcept {
+		return test(row(i), j);
+	}
+
+	// Add matrices
+	gf2_matrix gf2_matrix::operator+(const gf2_matrix &other) const {
+		gf2_matrix m(*this);
+		return m += other;
+	}
+
+	// Matrices with a single column are multiplied by the parity of AND-ed
+	// words, all others by M4RM in tiles of the result. Each tile goes through
+	// the inner dimension in steps of 64 rows of the right factor, with one
+	// table per 8 of them, so a row of the tile needs 8 table lookups per word
+	// of the left factor.
+	gf2_matrix gf2_matrix::operator*(const gf2_matrix &other) const {
+		// Check for valid argument
+		if (m_cols != other.m_rows) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not \
+									  match the columns of the original matrix.");
+		}
+
+		gf2_matrix c(m_rows, other.m_cols);
+		if (other.m_cols == 1) {
+			gf2_matrix v = other.transpose();
+			const uint64_t *x = v.row(0);
+			size_t rowsPerTask = std::max<size_t>(minWordsPerTask / m_words, 1);
+			thread_pool::instance().parallel_for(0, m_rows, rowsPerTask, [this, &c, x](size_t first, size_t last) {
+				for (size_t i = first; i < last; i++) {
+					uint64_t parity = 0;
+					for (size_t w = 0; w < m_words; w++) {
+						parity ^= row(i)[w] & x[w];
+					}
+					for (size_t s = wordBits / 2; s != 0; s >>= 1) {
+						parity ^= parity >> s;
+					}
+					c.row(i)[0] = parity & 1;
+				}
+			});
+			return c;
+		}
+
+		size_t rowTiles = (m_rows + tileRows - 1) / tileRows;
+		size_t wordTiles = (c.m_words + tileWords - 1) / tileWords;
+		thread_pool::instance().parallel_for(0, rowTiles * wordTiles, 1,
+			[this, &other, &c, wordTiles](size_t first, size_t last) {
+			std::vector<uint64_t> tables(wordBits / tableBits * tableSize * tileWords);
+			for (size_t tile = first; tile < last; tile++) {
+				size_t i0 = tile / wordTiles * tileRows;
+				size_t i1 = std::min(i0 + tileRows, m_rows);
+				size_t w0 = tile % wordTiles * tileWords;
+				size_t width = std::min(tileWords, c.m_words - w0);
+
+				for (size_t kw = 0; kw < m_words; kw++) {
+					for (size_t g = 0; g < wordBits / tableBits; g++) {
+						const uint64_t *rows[tableBits];
+						size_t k0 = kw * wordBits + g * tableBits;
+						size_t count = k0 < m_cols ? std::min(tableBits, m_cols - k0) : 0;
+						for (size_t k = 0; k < count; k++) {
+							rows[k] = other.row(k0 + k) + w0;
+						}
+						build_table(tables.data() + g * tableSize * width, rows, count, width);
+					}
+
+					for (size_t i = i0; i < i1; i++) {
+						uint64_t a = row(i)[kw];
+						uint64_t *target = c.row(i) + w0;
+						for (size_t g = 0; a != 0; g++, a >>= tableBits) {
+							size_t selector = a & (tableSize - 1);
+							if (selector != 0) {
+								add_row(target, tables.data() + (g * tableSize + selector) * width, width);
+							}
+						}
+					}
+				}
+			}
+		});
+		return c;
+	}
+
+	// Add matrix in place
+	gf2_matrix& gf2_matrix::operator+=(const gf2_matrix &other) {
+		// Check for valid argument
+		if (m_rows != other.m_rows || m_cols != other.m_cols) {
+			throw std::runtime_error("Dimensions of matrices can not differ from each other.");
+		}
+
+		add_row(m_entries.data(), other.m_entries.data(), m_entries.size());
+		return *this;
+	}
+
+	// Compare matrices, padding bits are 0 in both
+	bool gf2_matrix::operator==(const gf2_matrix &other) const noexcept {
+		return m_rows == other.m_rows && m_cols == other.m_cols && m_entries == other.m_entries;
+	}
+
+	bool gf2_matrix::operator!=(const gf2_matrix &other) const noexcept {
+		return !(*this == other);
+	}
+
+	// Print rows of 0 and 1
+	std::ostream& operator<<(std::ostream &os, const gf2_matrix &m) {
+		for (size_t i = 0; i < m.rows(); i++) {
+			for (size_t j = 0; j < m.columns(); j++) {
+				os << (m(i, j) ? '1' : '0');
+			}
+			os << std::endl;
+		}
+		return os;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "Allocator.hpp"
+#include "Matrix.hpp"
+#include "ModuleRing.hpp"
+
+namespace la {
+	// Matrix over GF(2), the integers modulo 2, with 64 entries packed into
+	// every word: entry (i, j) is bit j % 64 of word j / 64 of row i. Addition
+	// is XOR and multiplication AND, so rows are added a word at a time, and a
+	// matrix needs 1/32 of the memory of matrix<module_ring<2>>. Bits beyond
+	// the last column are kept 0.
+	//
+	// Products use the method of the four russians (M4RM): the 256 sums of
+	// every 8 rows of the right factor are tabulated and each byte of a row of
+	// the left factor selects one of them, one row addition per 8 entries.
+	// Products with a single column take the parity of AND-ed rows instead.
+	// Elimination works the same way (M4RI): up to 32 pivots are found at a
+	// time and their columns are cleared in all other rows with tables of
+	// their sums.
+	class gf2_matrix {
+	private:
+		size_t m_rows = 0, m_cols = 0;
+		// Words of 64 entries per row
+		size_t m_words = 0;
+		std::vector<uint64_t, matrix_allocator_t<uint64_t>> m_entries;
+
+		// Eliminate in place, searching pivots only in the given number of
+		// leading columns. Rows above the pivots are cleared as well for the
+		// reduced form. Returns the pivot columns.
+		std::vector<size_t> eliminate(size_t, bool);
+		// Throws std::invalid_argument if the matrix is not quadratic
+		void check_quadratic() const;
+		// Throws std::out_of_range if the entry exceeds the matrix
+		void check_range(size_t, size_t) const;
+
+	public:
+		// Constructors
+
+		// Default constructor
+		gf2_matrix() noexcept = default;
+		// Zero matrix of given dimensions
+		// Throws std::logic_error if a dimension is 0
+		gf2_matrix(size_t, size_t);
+		// Pack a matrix of residue classes
+		explicit gf2_matrix(const matrix<module_ring<2>> &);
+
+		// Getter
+		size_t rows() const noexcept;
+		size_t columns() const noexcept;
+		size_t words_per_row() const noexcept;
+		// Unchecked packed rows for kernels
+		uint64_t* row(size_t) noexcept;
+		const uint64_t* row(size_t) const noexcept;
+
+		// Checked access of single entries
+		// Throw std::out_of_range if the entry exceeds the matrix
+		bool get(size_t, size_t) const;
+		void set(size_t, size_t, bool);
+		void flip(size_t, size_t);
+
+		// Unpacked copy
+		matrix<module_ring<2>> dense() const;
+
+		// Matrix algorithms
+		gf2_matrix transpose() const;
+		size_t rank() const;
+		gf2_matrix reduced_echelon() const;
+		// All of them throw std::invalid_argument if the matrix is not
+		// quadratic, all except determinant if it is singular
+		bool determinant() const;
+		gf2_matrix inverse() const;
+		gf2_matrix solve(const gf2_matrix &) const;
+
+		// Static methods
+		static gf2_matrix identity(size_t);
+
+		// Overloaded operators
+
+		// Unchecked access
+		bool operator()(size_t, size_t) const noexcept;
+
+		// Arithmetic operators
+		// Throw std::runtime_error if the dimensions do not match
+		gf2_matrix operator+(const gf2_matrix &) const;
+		gf2_matrix operator*(const gf2_matrix &) const;
+		gf2_matrix& operator+=(const gf2_matrix &);
+
+		// Comparison operators
+		bool operator==(const gf2_matrix &) const noexcept;
+		bool operator!=(const gf2_matrix &) const noexcept;
+	};
+
+	// Allow matrices to be printed as rows of 0 and 1
+	std::ostream& operator<<(std::ostream &, const gf2_matrix &);
+}
\ No newline at end of file
@@ -0,0 +1,427 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "Allocator.hpp"
+#include "ModuleRing.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+
+namespace la {
+	// Cache and register blocking parameters of the packed multiplication kernel.
+	// A kc x nr sliver of B stays in L1, an mc x kc block of A in L2 and a
+	// kc x nc panel of B in L3 while the micro kernel updates an mr x nr tile of C
+	// held in registers.
+	// Floating point tiles have 6 rows, so the AVX2 and AVX-512 kernels of
+	// Simd.cpp keep twelve accumulators in registers.
+	template<typename T>
+	struct gemm_blocking {
+		static constexpr size_t mr = std::is_floating_point_v<T> ? 6 : 4;
+		static constexpr size_t nr = sizeof(T) >= 8 ? 8 : 64 / sizeof(T) / 4 * 4;
+		static constexpr size_t kc = 256;
+		static constexpr size_t mc = 32 * mr;
+		static constexpr size_t nc = 2048;
+	};
+
+	// All kernels address matrices by a pointer and a row and column stride, so
+	// row-major, column-major and transposed operands can be passed without copies.
+	// Element (i, j) of A lives at a[i * rsa + j * csa].
+
+	// Classic dot product multiplication C = A * B which only requires T(0), += and *
+	// and is therefore used for non-arithmetic types like la::complex
+	template<typename T>
+	void gemm_naive(size_t m, size_t n, size_t k,
+		const T *a, ptrdiff_t rsa, ptrdiff_t csa,
+		const T *b, ptrdiff_t rsb, ptrdiff_t csb,
+		T *c, ptrdiff_t rsc, ptrdiff_t csc) {
+		for (size_t i = 0; i < m; i++) {
+			for (size_t j = 0; j < n; j++) {
+				T c_ij(0);
+				for (size_t p = 0; p < k; p++) {
+					c_ij += a[i * rsa + p * csa] * b[p * rsb + j * csb];
+				}
+				c[i * rsc + j * csc] = c_ij;
+			}
+		}
+	}
+
+	// Copy an mc x kc block of A into row panels of height mr. Every panel stores
+	// the mr entries of one column contiguously, incomplete panels are zero padded.
+	template<typename T>
+	void gemm_pack_a(size_t mc, size_t kc, const T *a, ptrdiff_t rsa, ptrdiff_t csa,
+		T *packed) {
+		constexpr size_t mr = gemm_blocking<T>::mr;
+		for (size_t ir = 0; ir < mc; ir += mr) {
+			size_t rows = std::min(mr, mc - ir);
+			for (size_t p = 0; p < kc; p++) {
+				for (size_t i = 0; i < rows; i++) {
+					packed[i] = a[(ir + i) * rsa + p * csa];
+				}
+				for (size_t i = rows; i < mr; i++) {
+					packed[i] = T(0);
+				}
+				packed += mr;
+			}
+		}
+	}
+
+	// Copy a kc x nc panel of B into column slivers of width nr. Every sliver
+	// stores the nr entries of one row contiguously, incomplete slivers are zero padded.
+	template<typename T>
+	void gemm_pack_b(size_t kc, size_t nc, const T *b, ptrdiff_t rsb, ptrdiff_t csb,
+		T *packed) {
+		constexpr size_t nr = gemm_blocking<T>::nr;
+		for (size_t jr = 0; jr < nc; jr += nr) {
+			size_t cols = std::min(nr, nc - jr);
+			for (size_t p = 0; p < kc; p++) {
+				for (size_t j = 0; j < cols; j++) {
+					packed[j] = b[p * rsb + (jr + j) * csb];
+				}
+				for (size_t j = cols; j < nr; j++) {
+					packed[j] = T(0);
+				}
+				packed += nr;
+			}
+		}
+	}
+
+	// Multiply a packed mr x kc sliver of A by a packed kc x nr sliver of B and
+	// store the mr x nr result in acc. The fixed trip counts of the two inner loops
+	// let the compiler keep acc in vector registers. float and double use the
+	// kernels of the instruction set detected at runtime instead, this is their
+	// fallback.
+	template<typename T>
+	void gemm_micro_kernel(size_t kc, const T *a, const T *b, T *acc) {
+		constexpr size_t mr = gemm_blocking<T>::mr;
+		constexpr size_t nr = gemm_blocking<T>::nr;
+		for (size_t i = 0; i < mr * nr; i++) {
+			acc[i] = T(0);
+		}
+		for (size_t p = 0; p < kc; p++) {
+			for (size_t i = 0; i < mr; i++) {
+				const T a_ip = a[i];
+				for (size_t j = 0; j < nr; j++) {
+					acc[i * nr + j] += a_ip * b[j];
+				}
+			}
+			a += mr;
+			b += nr;
+		}
+	}
+
+	// Cache blocked matrix multiplication C = alpha * A * B + beta * C for
+	// arithmetic types. If beta is 0, C is not read and may be uninitialized.
+	template<typename T>
+	void gemm(size_t m, size_t n, size_t k, T alpha,
+		const T *a, ptrdiff_t rsa, ptrdiff_t csa,
+		const T *b, ptrdiff_t rsb, ptrdiff_t csb,
+		T beta, T *c, ptrdiff_t rsc, ptrdiff_t csc) {
+		static_assert(std::is_arithmetic_v<T>, "gemm requires an arithmetic type.");
+
+		constexpr size_t mr = gemm_blocking<T>::mr;
+		constexpr size_t nr = gemm_blocking<T>::nr;
+		constexpr size_t kcMax = gemm_blocking<T>::kc;
+		constexpr size_t mcMax = gemm_blocking<T>::mc;
+		constexpr size_t ncMax = gemm_blocking<T>::nc;
+
+		if (m == 0 || n == 0) { return; }
+
+		// An empty inner dimension only scales C
+		if (k == 0) {
+			for (size_t i = 0; i < m; i++) {
+				for (size_t j = 0; j < n; j++) {
+					T &c_ij = c[i * rsc + j * csc];
+					c_ij = beta == T(0) ? T(0) : beta * c_ij;
+				}
+			}
+			return;
+		}
+
+		// Packing buffers are kept per thread so repeated calls do not allocate
+		static thread_local std::vector<T, matrix_allocator_t<T>> packedA, packedB;
+		size_t sizeA = (std::min(mcMax, m) + mr - 1) / mr * mr * std::min(kcMax, k);
+		size_t sizeB = (std::min(ncMax, n) + nr - 1) / nr * nr * std::min(kcMax, k);
+		if (packedA.size() < sizeA) { packedA.resize(sizeA); }
+		if (packedB.size() < sizeB) { packedB.resize(sizeB); }
+
+		alignas(64) T acc[mr * nr];
+
+		for (size_t jc = 0; jc < n; jc += ncMax) {
+			size_t nc = std::min(ncMax, n - jc);
+			for (size_t pc = 0; pc < k; pc += kcMax) {
+				size_t kc = std::min(kcMax, k - pc);
+				// Only the first block of the inner dimension applies beta, every
+				// following block accumulates onto the partial result
+				T betaBlock = pc == 0 ? beta : T(1);
+
+				gemm_pack_b(kc, nc, b + pc * rsb + jc * csb, rsb, csb, packedB.data());
+
+				for (size_t ic = 0; ic < m; ic += mcMax) {
+					size_t mc = std::min(mcMax, m - ic);
+
+					gemm_pack_a(mc, kc, a + ic * rsa + pc * csa, rsa, csa, packedA.data());
+
+					for (size_t jr = 0; jr < nc; jr += nr) {
+						size_t cols = std::min(nr, nc - jr);
+						for (size_t ir = 0; ir < mc; ir += mr) {
+							size_t rows = std::min(mr, mc - ir);
+
+							if constexpr (simd_gemm_supported_v<T>) {
+								simd_gemm_kernel(kc, packedA.data() + ir * kc,
+									packedB.data() + jr * kc, acc);
+							}
+							else {
+								gemm_micro_kernel(kc, packedA.data() + ir * kc,
+									packedB.data() + jr * kc, acc);
+							}
+
+							T *cTile = c + (ic + ir) * rsc + (jc + jr) * csc;
+							for (size_t i = 0; i < rows; i++) {
+								for (size_t j = 0; j < cols; j++) {
+									T &c_ij = cTile[i * rsc + j * csc];
+									c_ij = betaBlock == T(0) ? alpha * acc[i * nr + j]
+										: alpha * acc[i * nr + j] + betaBlock * c_ij;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Multiplication of residue classes module_ring<mod> with delayed reduction.
+	// The residues are multiplied as plain numbers by the cache blocked kernel
+	// and only the sums are reduced, instead of a division per multiplication
+	// and per addition. Sums of up to 256 products of residues fit the 53 bits
+	// of a double exactly for moduli up to about 2^22, larger moduli are summed
+	// in 64 bit integers. The inner dimension is cut into slices whose sums can
+	// not overflow, every slice is reduced on its own.
+	template<typename T>
+	void gemm_modular(size_t m, size_t n, size_t k,
+		const T *a, ptrdiff_t rsa, ptrdiff_t csa,
+		const T *b, ptrdiff_t rsb, ptrdiff_t csb,
+		T *c, ptrdiff_t rsc, ptrdiff_t csc) {
+		constexpr uint64_t mod = ring_modulus<T>::value;
+		static_assert(mod != 0, "gemm_modular requires residue classes.");
+
+		constexpr uint64_t square = (mod - 1) * (mod - 1);
+		constexpr uint64_t doubleDepth = square == 0 ? std::numeric_limits<uint64_t>::max() :
+			(uint64_t(1) << std::numeric_limits<double>::digits) / square;
+		constexpr bool useDouble = doubleDepth >= gemm_blocking<double>::kc;
+		using acc_type = std::conditional_t<useDouble, double, uint64_t>;
+		constexpr uint64_t depth = useDouble ? doubleDepth : std::numeric_limits<uint64_t>::max() / square;
+
+		if (m == 0 || n == 0) { return; }
+
+		// Buffers are kept per thread so repeated calls do not allocate
+		static thread_local std::vector<acc_type, matrix_allocator_t<acc_type>> left, right, partial;
+		static thread_local std::vector<uint64_t> sum;
+		size_t slice = static_cast<size_t>(std::min<uint64_t>(depth, std::max<size_t>(k, 1)));
+		if (left.size() < m * slice) { left.resize(m * slice); }
+		if (right.size() < slice * n) { right.resize(slice * n); }
+		if (partial.size() < m * n) { partial.resize(m * n); }
+		sum.assign(m * n, 0);
+
+		for (size_t p0 = 0; p0 < k; p0 += slice) {
+			size_t kk = std::min(slice, k - p0);
+			for (size_t i = 0; i < m; i++) {
+				for (size_t p = 0; p < kk; p++) {
+					left[i * kk + p] = acc_type(a[i * rsa + (p0 + p) * csa].value());
+				}
+			}
+			for (size_t p = 0; p < kk; p++) {
+				for (size_t j = 0; j < n; j++) {
+					right[p * n + j] = acc_type(b[(p0 + p) * rsb + j * csb].value());
+				}
+			}
+
+			gemm(m, n, kk, acc_type(1), left.data(), kk, 1, right.data(), n, 1,
+				acc_type(0), partial.data(), n, 1);
+
+			for (size_t i = 0; i < m * n; i++) {
+				sum[i] = (sum[i] + static_cast<uint64_t>(partial[i]) % mod) % mod;
+			}
+		}
+
+		for (size_t i = 0; i < m; i++) {
+			for (size_t j = 0; j < n; j++) {
+				c[i * rsc + j * csc] = T(static_cast<uint32_t>(sum[i * n + j]));
+			}
+		}
+	}
+
+	// Grid of tiles a parallel m x n x k multiplication is split into. The result
+	// is divided into rowTiles x colTiles blocks and, if there are not enough of
+	// them to occupy all threads, the inner dimension into depthTiles partial
+	// products which get summed up afterwards.
+	struct gemm_tiling {
+		size_t rowTiles = 1, colTiles = 1, depthTiles = 1;
+		size_t tileRows = 0, tileCols = 0, tileDepth = 0;
+	};
+
+	// Choose a tiling for the given shape. Tiles are kept roughly proportional to
+	// the shape of the result, aligned to the register tile of the micro kernel
+	// and never smaller than minFlopsPerTile so scheduling stays negligible.
+	inline gemm_tiling gemm_tile(size_t m, size_t n, size_t k, size_t mr, size_t nr,
+		size_t minDepth, size_t threads) {
+		const double minFlopsPerTile = 1 << 20;
+
+		gemm_tiling tiling;
+		tiling.tileRows = m;
+		tiling.tileCols = n;
+		tiling.tileDepth = k;
+
+		// Some more tiles than threads let the work stealing balance the load
+		double flops = 2.0 * m * n * k;
+		size_t tiles = static_cast<size_t>(std::min(flops / minFlopsPerTile, 2.0 * threads));
+		if (tiles <= 1 || m == 0 || n == 0 || k == 0) { return tiling; }
+
+		size_t maxRowTiles = (m + mr - 1) / mr;
+		size_t maxColTiles = (n + nr - 1) / nr;
+
+		// Split rows and columns in proportion to the shape of the result
+		size_t rowTiles = static_cast<size_t>(std::lround(std::sqrt(double(tiles) * m / n)));
+		rowTiles = std::clamp<size_t>(rowTiles, 1, maxRowTiles);
+		size_t colTiles = std::clamp<size_t>((tiles + rowTiles - 1) / rowTiles, 1, maxColTiles);
+		rowTiles = std::clamp<size_t>((tiles + colTiles - 1) / colTiles, 1, maxRowTiles);
+
+		// Align tile sizes to the micro kernel and drop tiles that became empty
+		tiling.tileRows = ((m + rowTiles - 1) / rowTiles + mr - 1) / mr * mr;
+		tiling.tileCols = ((n + colTiles - 1) / colTiles + nr - 1) / nr * nr;
+		tiling.rowTiles = (m + tiling.tileRows - 1) / tiling.tileRows;
+		tiling.colTiles = (n + tiling.tileCols - 1) / tiling.tileCols;
+
+		// Small results with a long inner dimension additionally split the sum
+		size_t outputTiles = tiling.rowTiles * tiling.colTiles;
+		if (2 * outputTiles <= tiles) {
+			size_t depthTiles = std::min(tiles / outputTiles, std::max<size_t>(k / minDepth, 1));
+			tiling.tileDepth = (k + depthTiles - 1) / depthTiles;
+			tiling.depthTiles = (k + tiling.tileDepth - 1) / tiling.tileDepth;
+		}
+		return tiling;
+	}
+
+	// Multiply with the fastest single threaded kernel available for T, C = A * B
+	template<typename T>
+	void gemm_kernel(size_t m, size_t n, size_t k,
+		const T *a, ptrdiff_t rsa, ptrdiff_t csa,
+		const T *b, ptrdiff_t rsb, ptrdiff_t csb,
+		T *c, ptrdiff_t rsc, ptrdiff_t csc) {
+		if constexpr (std::is_arithmetic_v<T>) {
+			gemm(m, n, k, T(1), a, rsa, csa, b, rsb, csb, T(0), c, rsc, csc);
+		}
+		else if constexpr (ring_modulus<T>::value != 0) {
+			gemm_modular(m, n, k, a, rsa, csa, b, rsb, csb, c, rsc, csc);
+		}
+		else {
+			gemm_naive(m, n, k, a, rsa, csa, b, rsb, csb, c, rsc, csc);
+		}
+	}
+
+	// Multiply C = A * B on the thread pool with a tiling chosen for the shape, so
+	// tall-skinny, short-wide and matrix-vector products use all threads
+	template<typename T>
+	void gemm_parallel(size_t m, size_t n, size_t k,
+		const T *a, ptrdiff_t rsa, ptrdiff_t csa,
+		const T *b, ptrdiff_t rsb, ptrdiff_t csb,
+		T *c, ptrdiff_t rsc, ptrdiff_t csc) {
+		thread_pool &pool = thread_pool::instance();
+		gemm_tiling tiling = gemm_tile(m, n, k, gemm_blocking<T>::mr, gemm_blocking<T>::nr,
+			gemm_blocking<T>::kc, pool.size());
+
+		size_t outputTiles = tiling.rowTiles * tiling.colTiles;
+
+		// Every tile of the result is computed completely by one task
+		if (tiling.depthTiles == 1) {
+			pool.parallel_for(0, outputTiles, 1, [&](size_t first, size_t last) {
+				for (size_t t = first; t < last; t++) {
+					size_t i0 = t / tiling.colTiles * tiling.tileRows;
+					size_t j0 = t % tiling.colTiles * tiling.tileCols;
+					size_t rows = std::min(tiling.tileRows, m - i0);
+					size_t cols = std::min(tiling.tileCols, n - j0);
+					gemm_kernel(rows, cols, k, a + i0 * rsa, rsa, csa, b + j0 * csb, rsb, csb,
+						c + i0 * rsc + j0 * csc, rsc, csc);
+				}
+			});
+			return;
+		}
+
+		// Otherwise every task writes a partial product of its slice of the inner
+		// dimension into its own buffer and the buffers are summed up afterwards
+		std::vector<T, matrix_allocator_t<T>> partial(tiling.depthTiles * m * n);
+		pool.parallel_for(0, outputTiles * tiling.depthTiles, 1, [&](size_t first, size_t last) {
+			for (size_t t = first; t < last; t++) {
+				size_t d = t / outputTiles;
+				size_t i0 = t % outputTiles / tiling.colTiles * tiling.tileRows;
+				size_t j0 = t % outputTiles % tiling.colTiles * tiling.tileCols;
+				size_t p0 = d * tiling.tileDepth;
+				size_t rows = std::min(tiling.tileRows, m - i0);
+				size_t cols = std::min(tiling.tileCols, n - j0);
+				size_t depth = std::min(tiling.tileDepth, k - p0);
+				gemm_kernel(rows, cols, depth, a + i0 * rsa + p0 * csa, rsa, csa,
+					b + p0 * rsb + j0 * csb, rsb, csb, partial.data() + d * m * n + i0 * n + j0, n, 1);
+			}
+		});
+
+		pool.parallel_for(0, m, std::max<size_t>((1 << 14) / n, 1), [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				for (size_t j = 0; j < n; j++) {
+					T c_ij = partial[i * n + j];
+					for (size_t d = 1; d < tiling.depthTiles; d++) {
+						c_ij += partial[d * m * n + i * n + j];
+					}
+					c[i * rsc + j * csc] = c_ij;
+				}
+			}
+		});
+	}
+
+	// Subtract a product on the thread pool, C -= A * B. Every tile of C is
+	// updated by one task so the inner dimension is never split. Used by the
+	// trailing updates of the blocked eliminations.
+	template<typename T>
+	void gemm_subtract_parallel(size_t m, size_t n, size_t k,
+		const T *a, ptrdiff_t rsa, ptrdiff_t csa,
+		const T *b, ptrdiff_t rsb, ptrdiff_t csb,
+		T *c, ptrdiff_t rsc, ptrdiff_t csc) {
+		if (m == 0 || n == 0 || k == 0) { return; }
+
+		thread_pool &pool = thread_pool::instance();
+		gemm_tiling tiling = gemm_tile(m, n, k, gemm_blocking<T>::mr, gemm_blocking<T>::nr,
+			k, pool.size());
+
+		pool.parallel_for(0, tiling.rowTiles * tiling.colTiles, 1, [&](size_t first, size_t last) {
+			for (size_t t = first; t < last; t++) {
+				size_t i0 = t / tiling.colTiles * tiling.tileRows;
+				size_t j0 = t % tiling.colTiles * tiling.tileCols;
+				size_t rows = std::min(tiling.tileRows, m - i0);
+				size_t cols = std::min(tiling.tileCols, n - j0);
+				const T *aTile = a + i0 * rsa;
+				const T *bTile = b + j0 * csb;
+				T *cTile = c + i0 * rsc + j0 * csc;
+
+				if constexpr (std::is_arithmetic_v<T>) {
+					gemm(rows, cols, k, T(-1), aTile, rsa, csa, bTile, rsb, csb, T(1), cTile, rsc, csc);
+				}
+				else {
+					for (size_t i = 0; i < rows; i++) {
+						for (size_t p = 0; p < k; p++) {
+							T a_ip = aTile[i * rsa + p * csa];
+							if (a_ip == T(0)) { continue; }
+							for (size_t j = 0; j < cols; j++) {
+								cTile[i * rsc + j * csc] -= a_ip * bTile[p * rsb + j * csb];
+							}
+						}
+					}
+				}
+			}
+		});
+	}
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+#include "Expression.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+
+namespace la {
+	// Matrix-vector kernels. Every entry of A is used exactly once, so unlike
+	// gemm there is nothing to block or pack: the kernels stream A once from
+	// memory, contiguous parts with the SIMD kernels. Matrices are addressed like
+	// in Gemm.hpp, vectors by a pointer and the distance between entries.
+
+	template<typename T>
+	void gevm(size_t, size_t, T, const T *, ptrdiff_t, const T *, ptrdiff_t, ptrdiff_t,
+		T, T *, ptrdiff_t);
+
+	// Multiply y = alpha * A * x + beta * y for an m x n matrix A (may be
+	// multithreaded). If beta is 0, y is not read. Every task computes a band of
+	// y, one dot product of a row of A with x per entry. Column-major matrices
+	// are passed on to gevm as A^T, which walks them along their columns.
+	template<typename T>
+	void gemv(size_t m, size_t n, T alpha,
+		const T *a, ptrdiff_t rsa, ptrdiff_t csa,
+		const T *x, ptrdiff_t incx,
+		T beta, T *y, ptrdiff_t incy) {
+		const size_t minEntriesPerTask = 1 << 15;
+
+		if (rsa == 1 && csa != 1) {
+			gevm(n, m, alpha, x, incx, a, csa, rsa, beta, y, incy);
+			return;
+		}
+
+		thread_pool::instance().parallel_for(0, m, std::max<size_t>(minEntriesPerTask / std::max<size_t>(n, 1), 1),
+			[=](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				const T *row = a + i * rsa;
+				T dot(0);
+				if constexpr (simd_supported_v<T>) {
+					if (csa == 1 && incx == 1) {
+						dot = simd_dot(row, x, n);
+					}
+					else {
+						for (size_t j = 0; j < n; j++) { dot += row[j * csa] * x[j * incx]; }
+					}
+				}
+				else {
+					for (size_t j = 0; j < n; j++) { dot += row[j * csa] * x[j * incx]; }
+				}
+
+				T &y_i = y[i * incy];
+				y_i = beta == T(0) ? alpha * dot : alpha * dot + beta * y_i;
+			}
+		});
+	}
+
+	// Multiply y = alpha * x^T * A + beta * y for an m x n matrix A (may be
+	// multithreaded). If beta is 0, y is not read. Every task owns a band of y
+	// and adds x_i times the matching part of every row of A to it, in blocks of
+	// columns small enough to keep their part of y in L1. Column-major matrices
+	// are passed on to gemv as A^T, which takes dot products of their columns.
+	template<typename T>
+	void gevm(size_t m, size_t n, T alpha,
+		const T *x, ptrdiff_t incx,
+		const T *a, ptrdiff_t rsa, ptrdiff_t csa,
+		T beta, T *y, ptrdiff_t incy) {
+		const size_t minEntriesPerTask = 1 << 15;
+		const size_t columnsPerBlock = 2048;
+
+		if (rsa == 1 && csa != 1) {
+			gemv(n, m, alpha, a, csa, rsa, x, incx, beta, y, incy);
+			return;
+		}
+
+		thread_pool::instance().parallel_for(0, n, std::max<size_t>(minEntriesPerTask / std::max<size_t>(m, 1), 1),
+			[=](size_t first, size_t last) {
+			for (size_t j0 = first; j0 < last; j0 += columnsPerBlock) {
+				size_t cols = std::min(columnsPerBlock, last - j0);
+				T *yBlock = y + j0 * incy;
+
+				for (size_t j = 0; j < cols; j++) {
+					T &y_j = yBlock[j * incy];
+					y_j = beta == T(0) ? T(0) : beta * y_j;
+				}
+
+				for (size_t i = 0; i < m; i++) {
+					T s = alpha * x[i * incx];
+					if (s == T(0)) { continue; }
+
+					const T *row = a + i * rsa + j0 * csa;
+					if constexpr (simd_supported_v<T>) {
+						if (csa == 1 && incy == 1) {
+							simd_axpy(row, s, yBlock, cols);
+							continue;
+						}
+					}
+					for (size_t j = 0; j < cols; j++) { yBlock[j * incy] += row[j * csa] * s; }
+				}
+			}
+		});
+	}
+
+	// Accumulate y = alpha * A * x + beta * y into an existing vector
+	// Throws std::runtime_error if the dimensions do not match
+	template<typename T>
+	void gemv(T alpha, const matrix<T> &a, const vector<T> &x, T beta, vector<T> &y) {
+		// Check for valid argument
+		if (a.columns() != x.size()) {
+			throw std::runtime_error("Can not multiply by a vector which dimension does \
+									  not match the columns of the matrix.");
+		}
+		if (a.rows() != y.size()) {
+			throw std::runtime_error("Size of the result vector has to match the rows of the matrix.");
+		}
+
+		gemv(a.rows(), a.columns(), alpha, a.data(), a.columns(), 1, x.data(), 1, beta, y.data(), 1);
+	}
+
+	// Accumulate y = alpha * x^T * A + beta * y into an existing vector
+	// Throws std::runtime_error if the dimensions do not match
+	template<typename T>
+	void gevm(T alpha, const vector<T> &x, const matrix<T> &a, T beta, vector<T> &y) {
+		// Check for valid argument
+		if (x.size() != a.rows()) {
+			throw std::runtime_error("Size of vector has to match rows \
+									  of the matrix.");
+		}
+		if (a.columns() != y.size()) {
+			throw std::runtime_error("Size of the result vector has to match the columns of the matrix.");
+		}
+
+		gevm(a.rows(), a.columns(), alpha, x.data(), 1, a.data(), a.columns(), 1, beta, y.data(), 1);
+	}
+}
\ No newline at end of file
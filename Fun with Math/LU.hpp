@@ -0,0 +1,440 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Gemm.hpp"
+#include "Matrix.hpp"
+#include "ThreadPool.hpp"
+#include "Vector.hpp"
+
+namespace la {
+	// LU factorization with partial pivoting, P * A = L * U. The factorization is
+	// computed once and can then be used to solve any number of systems, to
+	// calculate the determinant or the inverse without eliminating again.
+	//
+	// The elimination is blocked and right-looking: a panel of columns is
+	// factorized, then the rest of the matrix is updated with it by a parallel
+	// matrix multiplication. Rectangular matrices are eliminated up to the
+	// smaller dimension, which gives their row echelon form.
+	template<typename T = double>
+	class lu {
+	private:
+		// Columns of the factorization are processed in panels of this width so
+		// the update of the remaining matrix becomes a matrix multiplication
+		static constexpr size_t blockSize = 128;
+
+		// L (below the diagonal, unit diagonal implied) and U (on and above the
+		// diagonal) share one matrix
+		matrix<T> m_lu;
+		// Row i of L * U is row m_perm[i] of the original matrix
+		std::vector<size_t> m_perm;
+		// Sign of the permutation, used for the determinant
+		T m_sign = T(1);
+		// Whether a zero pivot was encountered
+		bool m_singular = false;
+
+		// Steps of the factorization of rows x columns row-major entries a
+		static void factorize(T *, size_t, size_t, pivoting, std::vector<size_t> &, T &, bool &);
+		static void factorize_panel(T *, size_t, size_t, size_t, size_t, pivoting,
+			std::vector<size_t> &, T &, bool &);
+		static void update_trailing(T *, size_t, size_t, size_t, size_t);
+		// Solve L * U * X = B in place, x holds the n x cols row-major block B
+		void substitute(T *, size_t) const;
+		// Throws std::invalid_argument if the factorized matrix is not quadratic
+		void check_quadratic() const;
+
+	public:
+		// Constructors
+
+		// Factorize a matrix choosing pivots by the given rule
+		explicit lu(const matrix<T> &, pivoting = pivoting::largest);
+
+		// Factorize rows x columns row-major entries in place without copying
+		// them, they end up like factors(). Returns the permutation.
+		static std::vector<size_t> factorize_in_place(T *, size_t, size_t, pivoting = pivoting::largest);
+
+		// Getter
+		size_t size() const noexcept;
+		size_t rows() const noexcept;
+		size_t columns() const noexcept;
+		bool singular() const noexcept;
+		const matrix<T>& factors() const noexcept;
+		const std::vector<size_t>& permutation() const noexcept;
+
+		// Row echelon form U and reduced row echelon form, the result of the
+		// gauss and the gauss-jordan algorithm
+		matrix<T> echelon() const;
+		matrix<T> reduced_echelon() const;
+
+		// Algorithms using the factorization
+		// All of them throw std::invalid_argument if the matrix is not
+		// quadratic, all except determinant if it is singular
+		T determinant() const;
+		vector<T> solve(const vector<T> &) const;
+		matrix<T> solve(const matrix<T> &) const;
+		matrix<T> inverse() const;
+	};
+
+	// Factorize a copy of the matrix
+	template<typename T>
+	lu<T>::lu(const matrix<T> &m, pivoting rule)
+		: m_lu(m) {
+		factorize(m_lu.data(), rows(), columns(), rule, m_perm, m_sign, m_singular);
+	}
+
+	// Factorize borrowed storage, the sign and singularity are not needed
+	template<typename T>
+	std::vector<size_t> lu<T>::factorize_in_place(T *a, size_t rows, size_t columns, pivoting rule) {
+		std::vector<size_t> perm;
+		T sign = T(1);
+		bool singular = false;
+		factorize(a, rows, columns, rule, perm, sign, singular);
+		return perm;
+	}
+
+	// Factorize matrix in blocks: factorize a panel of columns, then update the
+	// rest of the matrix with it
+	template<typename T>
+	void lu<T>::factorize(T *a, size_t rows, size_t columns, pivoting rule,
+		std::vector<size_t> &perm, T &sign, bool &singular) {
+		perm.resize(rows);
+		for (size_t i = 0; i < rows; i++) {
+			perm[i] = i;
+		}
+
+		size_t steps = std::min(rows, columns);
+		for (size_t k = 0; k < steps; k += blockSize) {
+			size_t kb = std::min(blockSize, steps - k);
+			factorize_panel(a, rows, columns, k, kb, rule, perm, sign, singular);
+			update_trailing(a, rows, columns, k, kb);
+		}
+	}
+
+	// Eliminate the columns [k, k + kb) below the diagonal. Row swaps are applied
+	// to complete rows, updates only within the panel. The rows below the pivot
+	// are updated in parallel.
+	template<typename T>
+	void lu<T>::factorize_panel(T *a, size_t rows, size_t n, size_t k, size_t kb, pivoting rule,
+		std::vector<size_t> &perm, T &sign, bool &singular) {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		size_t rowsPerTask = std::max<size_t>(minEntriesPerTask / kb, 1);
+
+		for (size_t j = k; j < k + kb; j++) {
+			// Signed arithmetic types can use the largest entry as pivot for
+			// numerical stability, all others the first entry unequal to 0.
+			// Unsigned types wrap around like residue classes, for them the size
+			// of a pivot means nothing.
+			size_t p = j;
+			bool largest = false;
+			if constexpr (std::is_signed_v<T> || std::is_floating_point_v<T>) {
+				largest = rule == pivoting::largest;
+				if (largest) {
+					for (size_t i = j + 1; i < rows; i++) {
+						if (std::abs(a[i * n + j]) > std::abs(a[p * n + j])) { p = i; }
+					}
+				}
+			}
+			if (!largest) {
+				while (p < rows && a[p * n + j] == T(0)) { p++; }
+				if (p == rows) { p = j; }
+			}
+
+			// The whole column is 0 so there is nothing to eliminate
+			if (a[p * n + j] == T(0)) {
+				singular = true;
+				continue;
+			}
+
+			if (p != j) {
+				std::swap_ranges(a + j * n, a + (j + 1) * n, a + p * n);
+				std::swap(perm[j], perm[p]);
+				sign *= T(-1);
+			}
+
+			T pivot = a[j * n + j];
+			thread_pool::instance().parallel_for(j + 1, rows, rowsPerTask,
+				[a, n, j, k, kb, pivot](size_t first, size_t last) {
+				for (size_t i = first; i < last; i++) {
+					T &l_ij = a[i * n + j];
+					if (l_ij == T(0)) { continue; }
+					l_ij = l_ij / pivot;
+					for (size_t c = j + 1; c < k + kb; c++) {
+						a[i * n + c] -= l_ij * a[j * n + c];
+					}
+				}
+			});
+		}
+	}
+
+	// Compute U12 = L11^-1 * A12 right of the panel and A22 -= L21 * U12 below it,
+	// both in parallel
+	template<typename T>
+	void lu<T>::update_trailing(T *a, size_t rows, size_t n, size_t k, size_t kb) {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		size_t rest = n - k - kb;
+		size_t below = rows - k - kb;
+		if (rest == 0) { return; }
+
+		T *a12 = a + k * n + k + kb;
+
+		// Forward substitution with the unit lower triangle of the panel, the
+		// columns of A12 are independent of each other
+		thread_pool::instance().parallel_for(0, rest, std::max<size_t>(minEntriesPerTask / kb, 1),
+			[a, a12, n, k, kb](size_t first, size_t last) {
+			for (size_t j = 0; j < kb; j++) {
+				for (size_t i = j + 1; i < kb; i++) {
+					T l_ij = a[(k + i) * n + k + j];
+					if (l_ij == T(0)) { continue; }
+					for (size_t c = first; c < last; c++) {
+						a12[i * n + c] -= l_ij * a12[j * n + c];
+					}
+				}
+			}
+		});
+
+		const T *l21 = a + (k + kb) * n + k;
+		T *a22 = a + (k + kb) * n + k + kb;
+		gemm_subtract_parallel(below, rest, kb, l21, n, 1, a12, n, 1, a22, n, 1);
+	}
+
+	// Forward substitution with L followed by back substitution with U, both
+	// blocked so arithmetic types do most of the work in matrix multiplications
+	template<typename T>
+	void lu<T>::substitute(T *x, size_t cols) const {
+		size_t n = size();
+		const T *a = m_lu.data();
+
+		// Subtract the contribution of the rows [first, last) of x from the row
+		// block starting at target
+		auto subtract = [&](size_t target, size_t rows, size_t first, size_t last) {
+			gemm_subtract_parallel(rows, cols, last - first, a + target * n + first, n, 1,
+				x + first * cols, cols, 1, x + target * cols, cols, 1);
+		};
+
+		// L * Y = P * B
+		for (size_t k = 0; k < n; k += blockSize) {
+			size_t kb = std::min(blockSize, n - k);
+			subtract(k, kb, 0, k);
+			for (size_t i = k + 1; i < k + kb; i++) {
+				subtract(i, 1, k, i);
+			}
+		}
+
+		// U * X = Y, starting with the last block
+		for (size_t end = n; end > 0;) {
+			size_t k = end > blockSize ? end - blockSize : 0;
+			subtract(k, end - k, end, n);
+			for (size_t i = end; i-- > k;) {
+				subtract(i, 1, i + 1, end);
+				T u_ii = a[i * n + i];
+				for (size_t c = 0; c < cols; c++) {
+					x[i * cols + c] = x[i * cols + c] / u_ii;
+				}
+			}
+			end = k;
+		}
+	}
+
+	// Throw if solving or the determinant are not defined
+	template<typename T>
+	void lu<T>::check_quadratic() const {
+		if (rows() != columns()) {
+			throw std::invalid_argument("Matrix has to be quadratic.");
+		}
+	}
+
+	// Getter for the dimension of the factorized quadratic matrix
+	template<typename T>
+	size_t lu<T>::size() const noexcept {
+		return m_perm.size();
+	}
+
+	// Getter for rows
+	template<typename T>
+	size_t lu<T>::rows() const noexcept {
+		return m_lu.rows();
+	}
+
+	// Getter for columns
+	template<typename T>
+	size_t lu<T>::columns() const noexcept {
+		return m_lu.columns();
+	}
+
+	// Check if the factorized matrix is singular
+	template<typename T>
+	bool lu<T>::singular() const noexcept {
+		return m_singular;
+	}
+
+	// Getter for the combined L and U factors
+	template<typename T>
+	const matrix<T>& lu<T>::factors() const noexcept {
+		return m_lu;
+	}
+
+	// Getter for the row permutation
+	template<typename T>
+	const std::vector<size_t>& lu<T>::permutation() const noexcept {
+		return m_perm;
+	}
+
+	// U with the multipliers below the diagonal replaced by 0
+	template<typename T>
+	matrix<T> lu<T>::echelon() const {
+		matrix<T> u(m_lu);
+		T *a = u.data();
+		for (size_t i = 1; i < rows(); i++) {
+			std::fill(a + i * columns(), a + i * columns() + std::min(i, columns()), T(0));
+		}
+		return u;
+	}
+
+	// Gauss-jordan elimination of the echelon form, blocked like the
+	// factorization. Going upwards, the rows of a block are solved against their
+	// triangular diagonal block, then the pivot columns of the block are removed
+	// from all rows above by a parallel matrix multiplication. Rows with a zero
+	// pivot are neither normalized nor used for elimination.
+	template<typename T>
+	matrix<T> lu<T>::reduced_echelon() const {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		matrix<T> r = echelon();
+		size_t n = columns();
+		T *a = r.data();
+
+		for (size_t end = std::min(rows(), columns()); end > 0;) {
+			size_t k = end > blockSize ? end - blockSize : 0;
+			size_t kb = end - k;
+
+			// The diagonal block gets overwritten while it is still needed
+			std::vector<T, matrix_allocator_t<T>> u(kb * kb);
+			for (size_t i = 0; i < kb; i++) {
+				std::copy(a + (k + i) * n + k, a + (k + i) * n + k + kb, u.data() + i * kb);
+			}
+
+			// Back substitution, the columns are independent of each other
+			thread_pool::instance().parallel_for(k, n, std::max<size_t>(minEntriesPerTask / kb, 1),
+				[a, n, k, kb, &u](size_t first, size_t last) {
+				for (size_t i = kb; i-- > 0;) {
+					// Entries left of the diagonal are 0 already
+					size_t start = std::max(first, std::min(k + i, last));
+					T *row = a + (k + i) * n;
+					for (size_t l = i + 1; l < kb; l++) {
+						T u_il = u[i * kb + l];
+						if (u_il == T(0) || u[l * kb + l] == T(0)) { continue; }
+						const T *pivotRow = a + (k + l) * n;
+						for (size_t c = start; c < last; c++) {
+							row[c] -= u_il * pivotRow[c];
+						}
+					}
+					T u_ii = u[i * kb + i];
+					if (u_ii == T(0)) { continue; }
+					for (size_t c = start; c < last; c++) {
+						row[c] = row[c] / u_ii;
+					}
+				}
+			});
+
+			if (k > 0) {
+				// Multipliers of the rows above
+				std::vector<T, matrix_allocator_t<T>> factors(k * kb);
+				for (size_t i = 0; i < k; i++) {
+					for (size_t l = 0; l < kb; l++) {
+						factors[i * kb + l] = u[l * kb + l] == T(0) ? T(0) : a[i * n + k + l];
+					}
+				}
+				gemm_subtract_parallel(k, n - k, kb, factors.data(), kb, 1,
+					a + k * n + k, n, 1, a + k, n, 1);
+
+				// Pivot columns are 0 above the pivot up to rounding
+				for (size_t i = 0; i < k; i++) {
+					for (size_t l = 0; l < kb; l++) {
+						if (u[l * kb + l] != T(0)) { a[i * n + k + l] = T(0); }
+					}
+				}
+			}
+			end = k;
+		}
+		return r;
+	}
+
+	// The determinant is the product of the diagonal of U
+	template<typename T>
+	T lu<T>::determinant() const {
+		check_quadratic();
+		if (m_singular) { return T(0); }
+
+		T det = m_sign;
+		for (size_t i = 0; i < size(); i++) {
+			det *= m_lu(i, i);
+		}
+		return det;
+	}
+
+	// Solve A * x = b
+	template<typename T>
+	vector<T> lu<T>::solve(const vector<T> &b) const {
+		// Check for valid argument
+		check_quadratic();
+		if (b.size() != size()) {
+			throw std::invalid_argument("Size of vector has to match the matrix.");
+		}
+		if (m_singular) {
+			throw std::invalid_argument("Matrix is not invertible.");
+		}
+
+		vector<T> x(size());
+		for (size_t i = 0; i < size(); i++) {
+			x[i] = b[m_perm[i]];
+		}
+		substitute(&x[0], 1);
+		return x;
+	}
+
+	// Solve A * X = B for all columns of B at once
+	template<typename T>
+	matrix<T> lu<T>::solve(const matrix<T> &b) const {
+		// Check for valid argument
+		check_quadratic();
+		if (b.rows() != size()) {
+			throw std::invalid_argument("Rows of matrix have to match the factorized matrix.");
+		}
+		if (m_singular) {
+			throw std::invalid_argument("Matrix is not invertible.");
+		}
+
+		size_t cols = b.columns();
+		matrix<T> x(size(), cols);
+		for (size_t i = 0; i < size(); i++) {
+			std::copy(b.data() + m_perm[i] * cols, b.data() + (m_perm[i] + 1) * cols,
+				x.data() + i * cols);
+		}
+		substitute(x.data(), cols);
+		return x;
+	}
+
+	// Calculate the inverse by solving A * X = I
+	template<typename T>
+	matrix<T> lu<T>::inverse() const {
+		check_quadratic();
+		if (m_singular) {
+			throw std::invalid_argument("Matrix is not invertible.");
+		}
+
+		// P * I only has a single 1 per row so we can skip the permutation step
+		matrix<T> x(size(), size());
+		for (size_t i = 0; i < size(); i++) {
+			x(i, m_perm[i]) = T(1);
+		}
+		substitute(x.data(), size());
+		return x;
+	}
+}
\ No newline at end of file
@@ -2,4 +2,17 @@
 
 #include "Matrix.hpp"
 #include "Vector.hpp"
-#include "Fields.hpp"
\ No newline at end of file
+#include "FixedMatrix.hpp"
+#include "FixedVector.hpp"
+#include "SparseMatrix.hpp"
+#include "LU.hpp"
+#include "Strassen.hpp"
+#include "Fields.hpp"
+#include "Serialization.hpp"
+#include "OutOfCore.hpp"
+#include "Chain.hpp"
+#include "Structured.hpp"
+#include "Batch.hpp"
+#include "Bareiss.hpp"
+#include "GF2Matrix.hpp"
+#include "MixedLU.hpp"
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "stdafx.h"
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace la {
+#ifdef _WIN32
+	mapped_file::mapped_file(const std::string &path) {
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("Could not open file " + path + ".");
+		}
+		m_file = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size)) {
+			close();
+			throw std::runtime_error("Could not read the size of file " + path + ".");
+		}
+		m_size = static_cast<size_t>(size.QuadPart);
+		// Empty files can not be mapped
+		if (m_size == 0) { return; }
+
+		m_mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (m_mapping != nullptr) {
+			m_data = static_cast<char *>(MapViewOfFile(m_mapping, FILE_MAP_COPY, 0, 0, 0));
+		}
+		if (m_data == nullptr) {
+			close();
+			throw std::runtime_error("Could not map file " + path + ".");
+		}
+	}
+
+	void mapped_file::close() noexcept {
+		if (m_data != nullptr) { UnmapViewOfFile(m_data); }
+		if (m_mapping != nullptr) { CloseHandle(m_mapping); }
+		if (m_file != nullptr) { CloseHandle(m_file); }
+		m_data = nullptr;
+		m_mapping = nullptr;
+		m_file = nullptr;
+		m_size = 0;
+	}
+#else
+	mapped_file::mapped_file(const std::string &path) {
+		int file = ::open(path.c_str(), O_RDONLY);
+		if (file < 0) {
+			throw std::runtime_error("Could not open file " + path + ".");
+		}
+
+		struct stat status;
+		if (::fstat(file, &status) != 0) {
+			::close(file);
+			throw std::runtime_error("Could not read the size of file " + path + ".");
+		}
+		m_size = static_cast<size_t>(status.st_size);
+
+		// Empty files can not be mapped, the mapping stays valid after closing
+		// the file
+		if (m_size != 0) {
+			void *data = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+			if (data == MAP_FAILED) {
+				::close(file);
+				m_size = 0;
+				throw std::runtime_error("Could not map file " + path + ".");
+			}
+			m_data = static_cast<char *>(data);
+		}
+		::close(file);
+	}
+
+	void mapped_file::close() noexcept {
+		if (m_data != nullptr) { ::munmap(m_data, m_size); }
+		m_data = nullptr;
+		m_size = 0;
+	}
+#endif
+
+	mapped_file::mapped_file(mapped_file &&other) noexcept {
+		*this = std::move(other);
+	}
+
+	mapped_file::~mapped_file() {
+		close();
+	}
+
+	mapped_file& mapped_file::operator=(mapped_file &&other) noexcept {
+		if (this != &other) {
+			close();
+			std::swap(m_data, other.m_data);
+			std::swap(m_size, other.m_size);
+#ifdef _WIN32
+			std::swap(m_file, other.m_file);
+			std::swap(m_mapping, other.m_mapping);
+#endif
+		}
+		return *this;
+	}
+
+	char* mapped_file::data() const noexcept {
+		return m_data;
+	}
+
+	size_t mapped_file::size() const noexcept {
+		return m_size;
+	}
+}
\ No newline at end of file
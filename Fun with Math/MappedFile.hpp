@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace la {
+	// Read-only file mapped into memory as a private copy-on-write mapping.
+	// Pages are read from the file when they are first touched, writing to them
+	// copies the page and never changes the file.
+	class mapped_file {
+	private:
+		char *m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void *m_file = nullptr;
+		void *m_mapping = nullptr;
+#endif
+
+		void close() noexcept;
+
+	public:
+		// Constructors
+
+		// Empty mapping
+		mapped_file() noexcept = default;
+		// Map the whole file
+		// Throws std::runtime_error if the file can not be opened or mapped
+		explicit mapped_file(const std::string &);
+		// Mappings can only be moved
+		mapped_file(const mapped_file &) = delete;
+		mapped_file(mapped_file &&) noexcept;
+
+		// Destructor, unmaps the file
+		~mapped_file();
+
+		// Assignment operators
+		mapped_file& operator=(const mapped_file &) = delete;
+		mapped_file& operator=(mapped_file &&) noexcept;
+
+		// Start and size of the mapped file in bytes
+		char* data() const noexcept;
+		size_t size() const noexcept;
+	};
+}
\ No newline at end of file
@@ -4,31 +4,87 @@
 #include <stdexcept>
 #include <iostream>
 #include <iterator>
-#include <future>
-#include <thread>
 #include <cmath>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "Allocator.hpp"
+#include "Expression.hpp"
+#include "Gemm.hpp"
+#include "Gemv.hpp"
+#include "ThreadPool.hpp"
+#include "Transpose.hpp"
+#include "View.hpp"
 
 namespace la {
 	template <typename T>
-	class vector;
+	class lu;
 
-	template<typename T = double>
-	class matrix {
+	template <typename T>
+	class bareiss;
+
+	template <uint32_t m>
+	class module_ring;
+
+	// Entry types with exact arithmetic, their determinants come from
+	// fraction-free elimination instead of the LU factorization whose divisions
+	// would truncate. Unsigned integers are eliminated as signed ones.
+	template <typename T>
+	struct exact_arithmetic : std::bool_constant<std::is_integral_v<T> && !std::is_same_v<T, bool>> {};
+
+	template <uint32_t m>
+	struct exact_arithmetic<module_ring<m>> : std::true_type {};
+
+	// Rule for choosing the pivot of a column during elimination
+	enum class pivoting {
+		// Entry with the largest absolute value, only signed arithmetic types,
+		// all others fall back to first_nonzero
+		largest,
+		// First entry unequal to 0, like elimination by hand
+		first_nonzero
+	};
+
+	// How matrices and vectors treat storage handed to them
+	enum class buffer {
+		// The caller keeps ownership, the storage has to outlive the matrix
+		borrow,
+		// The matrix takes ownership, the storage has to come from
+		// matrix_allocator_t<T> with default constructed entries
+		adopt
+	};
+
+	template<typename T>
+	class matrix<T, dynamic, dynamic> : public matrix_expression<matrix<T>> {
 	private:
 		// Field to hold values of the matrix
-		T* m_entries;
+		T* m_entries = nullptr;
 
 		// Dimensions for the matrix
-		size_t m_rows, m_cols;
+		size_t m_rows = 0, m_cols = 0;
 
-		// This is an intern version for the gauss algorithm that also yields
-		// information for the determinant calculation
-		std::pair<matrix, T> gauss_intern() const
-			noexcept(std::is_nothrow_default_constructible_v<T>);
+		// Amount of entries m_entries has room for, assignments of matrices
+		// that fit reuse the storage
+		size_t m_capacity = 0;
+
+		// Whether m_entries has to be freed, false for borrowed storage
+		bool m_owner = true;
+
+		// Make room for the given amount of entries, replacing the storage by
+		// new default constructed entries only if it is too small
+		void reserve(size_t);
+		// Free owned storage
+		void release() noexcept;
 
 		friend class vector<T>;
 
 	public:
+		// Expression traits
+		using value_type = T;
+		static constexpr bool is_vector = false;
+		static constexpr bool is_leaf = true;
+
 		// Constructors
 
 		// Default constructor
@@ -44,6 +100,13 @@ namespace la {
 			noexcept(std::is_nothrow_default_constructible_v<T>);
 		// Move constructor
 		matrix(matrix &&) noexcept;
+		// Evaluate elementwise expression
+		template<typename E>
+		matrix(const matrix_expression<E> &);
+		// Use existing row-major storage of given dimensions without copying.
+		// Borrowed storage is kept as long as copied or evaluated matrices fit into it,
+		// otherwise the matrix allocates its own.
+		matrix(T *, size_t, size_t, buffer) noexcept;
 
 		// Destructor
 		virtual ~matrix();
@@ -52,10 +115,31 @@ namespace la {
 		size_t rows() const;
 		size_t columns() const;
 		size_t entries() const;
+		// Unchecked access by row-major index used to evaluate expressions
+		T eval(size_t) const noexcept;
+		// Raw row-major storage for kernels
+		T* data() noexcept;
+		const T* data() const noexcept;
+		// Unchecked access for kernels
+		T unchecked(size_t, size_t) const noexcept;
+		T& unchecked(size_t, size_t) noexcept;
+
+		// Views of the entries without copying
+		// Throw std::out_of_range if the part exceeds the matrix
+		matrix_view<T> view() noexcept;
+		matrix_view<const T> view() const noexcept;
+		matrix_view<T> submatrix(size_t, size_t, size_t, size_t);
+		matrix_view<const T> submatrix(size_t, size_t, size_t, size_t) const;
+		vector_view<T> row(size_t);
+		vector_view<const T> row(size_t) const;
+		vector_view<T> column(size_t);
+		vector_view<const T> column(size_t) const;
 
 		// Matrix algorithms
 		T determinant() const;
 		matrix transpose() const;
+		// Transpose without a second matrix, the dimensions are swapped
+		matrix& transpose_in_place();
 		matrix gauss() const
 			noexcept(std::is_nothrow_default_constructible_v<T>);
 		matrix gauss_jordan() const
@@ -75,41 +159,34 @@ namespace la {
 
 		// Arithmetic operators
 		// All arithmetic operations throw if the operations are mathematically
-		// not well-defined
+		// not well-defined. Elementwise operations (+, - and multiplication or
+		// division by a constant) are lazily evaluated expressions, see Expression.hpp
 		matrix operator*(const matrix &) const;
 		vector<T> operator*(const vector<T> &) const;
-		matrix operator*(const T &) const
-			noexcept(std::is_nothrow_constructible_v<matrix<T>, size_t, size_t>);
-		matrix operator/(const T &) const
-			noexcept(std::is_nothrow_constructible_v<matrix<T>, size_t, size_t>);
-		matrix operator+(const matrix &) const;
-		matrix operator-(const matrix &) const;
 
 		// Assignment operators
 		matrix& operator*=(const matrix &);
-		matrix& operator*=(const T &)
-			noexcept(std::is_nothrow_constructible_v<matrix<T>, size_t, size_t>);
-		matrix& operator/=(const T &)
-			noexcept(std::is_nothrow_constructible_v<matrix<T>, size_t, size_t>);
-		matrix& operator+=(const matrix &);
-		matrix& operator-=(const matrix &);
+		matrix& operator*=(const T &);
+		matrix& operator/=(const T &);
+		template<typename E>
+		matrix& operator+=(const matrix_expression<E> &);
+		template<typename E>
+		matrix& operator-=(const matrix_expression<E> &);
 
 		// Copy assignment
 		matrix& operator=(const matrix &)
 			noexcept(std::is_nothrow_default_constructible_v<T>);
 		// Move assignment
 		matrix& operator=(matrix &&) noexcept;
+		// Assignment of elementwise expression
+		template<typename E>
+		matrix& operator=(const matrix_expression<E> &);
 
 		// Comparison operators
 		bool operator==(const matrix &) const noexcept;
 		bool operator!=(const matrix &) const noexcept;
 	};
 
-	// Allow both-sided multiplication by constant
-	template<typename U, typename T>
-	matrix<T> operator*(const U &, const matrix<T> &)
-		noexcept(std::is_nothrow_constructible_v<matrix<T>, size_t, size_t>);
-
 	// Allow matrices to be printed
 	template<typename T>
 	std::ostream& operator<<(std::ostream &, const matrix<T> &);
@@ -123,7 +200,7 @@ namespace la {
 			throw std::logic_error("Matrix does not allow zero dimensions.");
 		}
 
-		m_entries = new T[rows * cols];
+		reserve(rows * cols);
 		std::fill(m_entries, m_entries + (rows * cols), defVal);
 	}
 
@@ -138,7 +215,7 @@ namespace la {
 
 		m_rows = list.size();
 		m_cols = list.begin()->size();
-		m_entries = new T[m_rows * m_cols];
+		reserve(m_rows * m_cols);
 
 		uint32_t index = 0;
 		for (const auto &i : list) {
@@ -154,7 +231,7 @@ namespace la {
 		noexcept(std::is_nothrow_default_constructible_v<T>) {
 		m_rows = other.m_rows;
 		m_cols = other.m_cols;
-		m_entries = new T[other.entries()];
+		reserve(other.entries());
 		std::copy(other.m_entries, other.m_entries + other.entries(),
 			stdext::checked_array_iterator<T*>(m_entries, entries()));
 	}
@@ -165,13 +242,64 @@ namespace la {
 		m_rows = other.m_rows;
 		m_cols = other.m_cols;
 		m_entries = other.m_entries;
+		m_capacity = other.m_capacity;
+		m_owner = other.m_owner;
 		other.m_entries = nullptr;
+		other.m_capacity = 0;
 	}
 
+	// Evaluate an elementwise expression in a single pass
+	template<typename T>
+	template<typename E>
+	matrix<T>::matrix(const matrix_expression<E> &expr)
+		: m_rows(expr.rows()), m_cols(expr.columns()) {
+		static_assert(!E::is_vector, "Can not construct matrix from vector expression.");
+		reserve(entries());
+		assign(m_entries, expr);
+	}
+
+	// Adopt or borrow storage
+	template<typename T>
+	matrix<T>::matrix(T *entries, size_t rows, size_t cols, buffer mode) noexcept
+		: m_entries(entries), m_rows(rows), m_cols(cols), m_capacity(rows * cols),
+		m_owner(mode == buffer::adopt)
+	{}
+
 	// Destructor
 	template<typename T>
 	matrix<T>::~matrix() {
-		delete[] m_entries;
+		release();
+	}
+
+	// Keep storage that is large enough, owned or borrowed
+	template<typename T>
+	void matrix<T>::reserve(size_t entries) {
+		if (m_entries != nullptr && entries <= m_capacity) { return; }
+
+		release();
+		matrix_allocator_t<T> allocator;
+		T *storage = allocator.allocate(entries);
+		try {
+			std::uninitialized_default_construct_n(storage, entries);
+		}
+		catch (...) {
+			allocator.deallocate(storage, entries);
+			throw;
+		}
+		m_entries = storage;
+		m_capacity = entries;
+		m_owner = true;
+	}
+
+	// Destroy the entries and give the storage back to the allocator
+	template<typename T>
+	void matrix<T>::release() noexcept {
+		if (m_owner && m_entries != nullptr) {
+			std::destroy_n(m_entries, m_capacity);
+			matrix_allocator_t<T>().deallocate(m_entries, m_capacity);
+		}
+		m_entries = nullptr;
+		m_capacity = 0;
 	}
 
 	// Getter for rows
@@ -192,7 +320,86 @@ namespace la {
 		return m_rows * m_cols;
 	}
 
-	// Calculate determinant using gauss algorithm
+	// Unchecked access by row-major index
+	template<typename T>
+	T matrix<T>::eval(size_t i) const noexcept {
+		return m_entries[i];
+	}
+
+	// Getter for the storage
+	template<typename T>
+	T* matrix<T>::data() noexcept {
+		return m_entries;
+	}
+
+	// Getter for the storage
+	template<typename T>
+	const T* matrix<T>::data() const noexcept {
+		return m_entries;
+	}
+
+	// Unchecked access by row and column
+	template<typename T>
+	T matrix<T>::unchecked(size_t i, size_t j) const noexcept {
+		return m_entries[i * m_cols + j];
+	}
+
+	// Unchecked access by row and column
+	template<typename T>
+	T& matrix<T>::unchecked(size_t i, size_t j) noexcept {
+		return m_entries[i * m_cols + j];
+	}
+
+	// View of the whole matrix
+	template<typename T>
+	matrix_view<T> matrix<T>::view() noexcept {
+		return matrix_view<T>(m_entries, m_rows, m_cols, m_cols);
+	}
+
+	// Read-only view of the whole matrix
+	template<typename T>
+	matrix_view<const T> matrix<T>::view() const noexcept {
+		return matrix_view<const T>(m_entries, m_rows, m_cols, m_cols);
+	}
+
+	// View of the block with upper left entry (row, col)
+	template<typename T>
+	matrix_view<T> matrix<T>::submatrix(size_t row, size_t col, size_t rows, size_t cols) {
+		return view().submatrix(row, col, rows, cols);
+	}
+
+	// Read-only view of the block with upper left entry (row, col)
+	template<typename T>
+	matrix_view<const T> matrix<T>::submatrix(size_t row, size_t col, size_t rows, size_t cols) const {
+		return view().submatrix(row, col, rows, cols);
+	}
+
+	// View of a single row
+	template<typename T>
+	vector_view<T> matrix<T>::row(size_t i) {
+		return view().row(i);
+	}
+
+	// Read-only view of a single row
+	template<typename T>
+	vector_view<const T> matrix<T>::row(size_t i) const {
+		return view().row(i);
+	}
+
+	// View of a single column
+	template<typename T>
+	vector_view<T> matrix<T>::column(size_t j) {
+		return view().column(j);
+	}
+
+	// Read-only view of a single column
+	template<typename T>
+	vector_view<const T> matrix<T>::column(size_t j) const {
+		return view().column(j);
+	}
+
+	// Calculate determinant using the blocked LU factorization, or exactly by
+	// Bareiss elimination for integers and residue classes
 	template<typename T>
 	T matrix<T>::determinant() const {
 		// Check for valid argument
@@ -200,122 +407,54 @@ namespace la {
 			throw std::invalid_argument("Matrix has to be quadratic.");
 		}
 
-		// Do gauss transformation and obtain additional correction factor
-		auto gPair = gauss_intern();
-
-		// Calculate result variable and multiply by correction factor
-		T det = T(1) * gPair.second;
-
-		// Multiply result variable by every entry of the main diagonal of the
-		// transformed matrix
-		for (size_t i = 0; i < this->m_rows; i++) {
-			det *= gPair.first(i, i);
+		if constexpr (exact_arithmetic<T>::value) {
+			return bareiss<T>(*this).determinant();
+		}
+		else {
+			T det = lu<T>(*this).determinant();
+			return det == T(0) ? T(0) : det;
 		}
-
-		return det == T(0) ? T(0) : det;
 	}
 
-	// Return the transposed matrix
+	// Return the transposed matrix, copied cache-obliviously in tiles (may be
+	// multithreaded)
 	template<typename T>
 	matrix<T> matrix<T>::transpose() const {
 		matrix<T> m(m_cols, m_rows);
-		
-		for (size_t i = 0; i < m_cols; i++) {
-			for (size_t j = 0; j < m_rows; j++) {
-				m.m_entries[i * m_rows + j] = m_entries[j * m_cols + i];
-			}
-		}
+		transpose_parallel(m_rows, m_cols, m_entries, m_cols, m.m_entries, m_rows);
 		return m;
 	}
 
-	// Return the gauss transformed matrix
+	// Transpose the storage itself. Quadratic matrices swap tiles (may be
+	// multithreaded), rectangular ones follow the cycles of the permutation.
 	template<typename T>
-	matrix<T> matrix<T>::gauss() const
-		noexcept(std::is_nothrow_default_constructible_v<T>) {
-		// Just a public wrapper for the intern gauss algorithm that also return
-		// addtional information for determinant calculation
-		return gauss_intern().first;
+	matrix<T>& matrix<T>::transpose_in_place() {
+		if (m_rows == m_cols) {
+			transpose_square_in_place(m_rows, m_entries, m_cols);
+		}
+		else {
+			transpose_cycles(m_rows, m_cols, m_entries);
+			std::swap(m_rows, m_cols);
+		}
+		return *this;
 	}
 
-	// The actual gauss transformations takes place and also yields a correction
-	// factor for determinant calculation
+	// Return the gauss transformed matrix, eliminated in parallel blocks by the
+	// LU factorization with the classic choice of pivots
 	template<typename T>
-	std::pair<matrix<T>, T> matrix<T>::gauss_intern() const
+	matrix<T> matrix<T>::gauss() const
 		noexcept(std::is_nothrow_default_constructible_v<T>) {
-		// Create a working copy of the matrix
-		matrix<T> m(*this);
-		// Correction factor
-		T cf(1);
-
-		for (size_t j = 0; j < std::min(m.m_rows, m.m_cols); j++) {
-			// Reference value we use to make all the entries below in this column 0
-			T t1 = m.m_entries[j * (m.m_cols + 1)];
-			// If our reference value is 0 we need to swap some rows
-			if (t1 == T(0)) {
-				for (size_t i = j + 1; i < m.m_rows; i++) {
-					// If an entry below is unequal to 0 we swap the rows and adjust cf
-					if (m.m_entries[j * (m.m_cols + 1) + (i - j) * m.m_cols] != T(0)) {
-						std::swap_ranges(m.m_entries + j * m.m_cols,
-							m.m_entries + (j + 1) * m.m_cols,
-							m.m_entries + i * m.m_cols);
-						// This value has now changed
-						t1 = m.m_entries[j * (m.m_cols + 1)];
-						cf *= T(-1);
-						break;
-					}
-				}
-			}
-
-			// If t1 is unequal to 0 the real transformation part begins
-			for (size_t i = j + 1; i < m.m_rows; i++) {
-				// Second reference value to calculate factor we multiply the above row by
-				// to make this entry 0
-				T t2 = m.m_entries[i * m.m_cols + j];
-				// If it already is 0 we don't need to doing something here
-				if (t2 == T(0)) { continue; }
-				// This might look very confusing but in the end it simply subtracts the
-				// above row from all the above rows multiplied by a factor of our
-				// reference values t2 / t1 so all the entries below the first reference
-				// become 0
-				std::transform(m.m_entries + j * m.m_cols,
-					m.m_entries + (j + 1) * m.m_cols,
-					m.m_entries + i * m.m_cols, m.m_entries + i * m.m_cols,
-					[t1, t2](T first, T second) { return second - first * (t2 / t1); });
-			}
-		}
-		// The madness is over we make a pair from matrix and factor and return it
-		return std::make_pair(m, cf);
+		return lu<T>(*this, pivoting::first_nonzero).echelon();
 	}
 
 	// Return gauss-jordan transformed matrix
 	template<typename T>
 	matrix<T> matrix<T>::gauss_jordan() const
 		noexcept(std::is_nothrow_default_constructible_v<T>) {
-		// Do normal gauss first
-		matrix<T> m = gauss_intern().first;
-
-		// We don't use size_t here because j and i have to become negative to
-		// terminate the loops
-		for (int32_t j = std::min(m.m_rows, m.m_cols) - 1; j >= 0; j--) {
-			// Make entry m(j, j) 1 by diving the row by m(j, j)
-			std::transform(m.m_entries + j * (m.m_cols + 1),
-				m.m_entries + (j + 1) * m.m_cols,
-				m.m_entries + j * (m.m_cols + 1),
-				[m, j](T first) { return first / m(j, j); });
-			// Now we want to make every entry above m(j, j) 0, so m(j, j) remains as
-			// the only 1 in its column
-			for (int32_t i = j - 1; i >= 0; i--) {
-				std::transform(m.m_entries + j * (m.m_cols + 1),
-					m.m_entries + (j + 1) * m.m_cols,
-					m.m_entries + j * (m.m_cols + 1) - m.m_cols * (j - i),
-					m.m_entries + j * (m.m_cols + 1) - m.m_cols * (j - i),
-					[m, i, j](T first, T second) { return second - first * m(i, j); });
-			}
-		}
-		return m;
+		return lu<T>(*this, pivoting::first_nonzero).reduced_echelon();
 	}
 
-	// Calculated inverted matrix
+	// Calculated inverted matrix from a single LU factorization
 	template<typename T>
 	matrix<T> matrix<T>::invert() const {
 		// Check for valid argument
@@ -323,37 +462,12 @@ namespace la {
 			throw std::invalid_argument("Matrix has to be quadratic.");
 		}
 
-		// Check for invertibility
-		if (this->determinant() == 0) {
+		// The factorization also tells us whether the matrix is invertible
+		lu<T> factorization(*this);
+		if (factorization.singular()) {
 			throw::std::invalid_argument("Matrix is not invertible.");
 		}
-
-		// Construct helper matrix
-		matrix<T> h(this->m_rows, 2 * this->m_cols);
-
-		// Copy entries of this in the left section of h
-		for (size_t i = 0; i < h.m_rows; i++) {
-			std::copy(m_entries + i * this->m_cols, m_entries + (i + 1) * this->m_cols,
-				h.m_entries + i * h.m_cols);
-		}
-		// Make right section of h and identity matrix
-		for (size_t i = 0; i < h.m_rows; i++) {
-			h(i, i + h.m_rows) = T(1);
-		}
-
-		// Do gauss-jordan on h so the identity matrix will be on the left side now
-		h = h.gauss_jordan();
-
-		// Create result matrix
-		matrix<T> m(this->m_rows, this->m_cols);
-
-		// Copy entries of the right side of h into m
-		for (size_t i = 0; i < m.m_rows; i++) {
-			std::copy(h.m_entries + 2 * i * m.m_cols + m.m_cols,
-				h.m_entries + (2 * i + 1) * m.m_cols + m.m_cols,
-				m.m_entries + i * m.m_cols);
-		}
-		return m;
+		return factorization.inverse();
 	}
 
 	// Create an identity matrix
@@ -398,7 +512,8 @@ namespace la {
 		return m_entries[i * m_cols + j];
 	}
 
-	// Multiply two matrices (may be multithreaded)
+	// Multiply two matrices (may be multithreaded). Arithmetic types use the cache
+	// blocked kernel, all other types fall back to the classic dot product loop
 	template<typename T>
 	matrix<T> matrix<T>::operator*(const matrix<T> &other) const {
 		// Check for valid argument
@@ -407,50 +522,14 @@ namespace la {
 				                      match the columns of the original matrix.");
 		}
 
-		const size_t minColsPerThread = 50;
-		size_t supportedThreads = std::max<size_t>(std::thread::hardware_concurrency(), 2);
-
 		size_t rows = m_rows; // std::min(m_rows, other.m_cols);
 		size_t cols = other.m_cols; // std::max(m_rows, other.m_cols);
 
 		matrix<T> m(rows, cols);
 
-		size_t maxAmountOfThreads = (cols + minColsPerThread - 1) / minColsPerThread;
-		size_t amountOfThreads = supportedThreads > maxAmountOfThreads ? maxAmountOfThreads : supportedThreads;
-
-		size_t colsPerThread = cols / amountOfThreads;
-
-		std::future<void>* futures = new std::future<void>[amountOfThreads - 1];
-
-		for (int c = 0; c < amountOfThreads - 1; c++) {
-			futures[c] = std::async([c, rows, cols, colsPerThread, this, other, &m]() {
-				for (size_t i = 0; i < rows; i++) {
-					for (size_t k = c * colsPerThread; k < (c + 1) * colsPerThread; k++) {
-						T c_ik(0);
-						for (size_t j = 0; j < m_cols; j++) {
-							c_ik += m_entries[i * m_cols + j] * other.m_entries[j * other.m_cols + k];
-						}
-						m.m_entries[i * cols + k] = c_ik;
-					}
-				}
-				});
-		}
-
-		for (size_t i = 0; i < rows; i++) {
-			for (size_t k = (amountOfThreads - 1) * colsPerThread; k < cols; k++) {
-				T c_ik(0);
-				for (size_t j = 0; j < m_cols; j++) {
-					c_ik += m_entries[i * m_cols + j] * other.m_entries[j * other.m_cols + k];
-				}
-				m.m_entries[i * cols + k] = c_ik;
-			}
-		}
-
-		for (int c = 0; c < amountOfThreads - 1; c++) {
-			futures[c].get();
-		}
-
-		delete[] futures;
+		// The result is split into tiles according to its shape
+		gemm_parallel(rows, cols, m_cols, m_entries, m_cols, 1,
+			other.m_entries, other.m_cols, 1, m.m_entries, cols, 1);
 
 		if (rows != m_rows) {
 			m.m_rows = cols;
@@ -460,106 +539,106 @@ namespace la {
 		return m;
 	}
 
-	// Multiply matrix by vector
+	// Multiply matrix by vector (may be multithreaded)
 	template<typename T>
 	vector<T> matrix<T>::operator*(const vector<T> &other) const {
 		// Check for valid argument
-		if (m_cols != other.mDimension) {
+		if (m_cols != other.m_dimension) {
 			throw std::runtime_error("Can not multiply by a vector which dimension does \
 									  not match the columns of the matrix.");
 		}
 
 		vector<T> v(m_rows);
-		v.mmatrix = *this * other.mmatrix;
+		gemv(m_rows, m_cols, T(1), m_entries, m_cols, 1, other.data(), 1, T(0), v.data(), 1);
 		return v;
 	}
 
-	// Multiply matrix by constant
-	template<typename T>
-	matrix<T> matrix<T>::operator*(const T &other) const
-		noexcept(std::is_nothrow_constructible_v<matrix<T>, size_t, size_t>) {
-		matrix<T> m(m_rows, m_cols);
-		for (size_t i = 0; i < entries(); i++) {
-			m.m_entries[i] = m_entries[i] * other;
-		}
-		return m;
-	}
-
-	// Divide matrix by constant
+	// Multiply two matrices and assign result to *this (may be multithreaded). A
+	// quadratic right hand side keeps the dimensions, so the rows are multiplied
+	// in bands: a band is copied into a scratch buffer and the product written
+	// back over it. The buffer is kept per thread, so repeated products do not
+	// allocate.
 	template<typename T>
-	matrix<T> matrix<T>::operator/(const T &other) const
-		noexcept(std::is_nothrow_constructible_v<matrix<T>, size_t, size_t>) {
-		matrix<T> m(m_rows, m_cols);
-		for (size_t i = 0; i < entries(); i++) {
-			m.m_entries[i] = m_entries[i] / other;
-		}
-		return m;
-	}
+	matrix<T>& matrix<T>::operator*=(const matrix<T> &other) {
+		const size_t rowsPerBand = 256;
 
-	// Add two matrices
-	template<typename T>
-	matrix<T> matrix<T>::operator+(const matrix<T> &other) const {
 		// Check for valid argument
-		if (m_rows != other.m_rows || m_cols != other.m_cols) {
-			throw std::runtime_error("Dimensions of matrices can not differ from each other.");
+		if (m_cols != other.m_rows) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not \
+				                      match the columns of the original matrix.");
 		}
 
-		matrix<T> m(m_rows, m_cols);
-		for (size_t i = 0; i < entries(); i++) {
-			m.m_entries[i] = m_entries[i] + other.m_entries[i];
+		// The result has other dimensions and needs new storage anyway
+		if (other.m_rows != other.m_cols) {
+			*this = *this * other;
+			return *this;
 		}
-		return m;
-	}
 
-	// Subtract two matrices
-	template<typename T>
-	matrix<T> matrix<T>::operator-(const matrix<T> &other) const {
-		// Check for valid argument
-		if (m_rows != other.m_rows || m_cols != other.m_cols) {
-			throw std::runtime_error("Dimensions of matrices can not differ from each other.");
+		size_t n = m_cols;
+		size_t band = std::min(rowsPerBand, m_rows);
+		bool aliased = &other == this;
+
+		// Taken out of its slot while in use, so a product started by a task this
+		// thread runs in the meantime gets a buffer of its own
+		static thread_local std::vector<T, matrix_allocator_t<T>> scratch;
+		std::vector<T, matrix_allocator_t<T>> buffer = std::move(scratch);
+		size_t needed = band * n + (aliased ? n * n : 0);
+		if (buffer.size() < needed) { buffer.resize(needed); }
+
+		// Multiplying by itself overwrites the right hand side as well
+		const T *b = other.m_entries;
+		if (aliased) {
+			std::copy(m_entries, m_entries + n * n, buffer.data() + band * n);
+			b = buffer.data() + band * n;
 		}
 
-		matrix<T> m(m_rows, m_cols);
-		for (size_t i = 0; i < entries(); i++) {
-			m.m_entries[i] = m_entries[i] - other.m_entries[i];
+		for (size_t i0 = 0; i0 < m_rows; i0 += band) {
+			size_t rows = std::min(band, m_rows - i0);
+			std::copy(m_entries + i0 * n, m_entries + (i0 + rows) * n, buffer.data());
+			gemm_parallel(rows, n, n, buffer.data(), n, 1, b, n, 1, m_entries + i0 * n, n, 1);
 		}
-		return m;
-	}
 
-	// Multiply two matrices and assign result to *this
-	template<typename T>
-	matrix<T>& matrix<T>::operator*=(const matrix<T> &other) {
-		*this = *this * other;
+		scratch = std::move(buffer);
 		return *this;
 	}
 
-	// Multiply matrix by constant and assign result to *this
+	// Multiply matrix by constant in place
 	template<typename T>
-	matrix<T>& matrix<T>::operator*=(const T &other)
-		noexcept(std::is_nothrow_constructible_v<matrix<T>, size_t, size_t>) {
-		*this = *this * other;
+	matrix<T>& matrix<T>::operator*=(const T &other) {
+		assign(m_entries, *this * other);
 		return *this;
 	}
 
-	// Divide matrix by constant and assign result to *this
+	// Divide matrix by constant in place
 	template<typename T>
-	matrix<T>& matrix<T>::operator/=(const T &other)
-		noexcept(std::is_nothrow_constructible_v<matrix<T>, size_t, size_t>) {
-		*this = *this / other;
+	matrix<T>& matrix<T>::operator/=(const T &other) {
+		assign(m_entries, *this / other);
 		return *this;
 	}
 
-	// Add two matrices and assign result to *this
+	// Add matrix expression in place
 	template<typename T>
-	matrix<T>& matrix<T>::operator+=(const matrix<T> &other) {
-		*this = *this + other;
+	template<typename E>
+	matrix<T>& matrix<T>::operator+=(const matrix_expression<E> &other) {
+		// Check for valid argument
+		if (m_rows != other.rows() || m_cols != other.columns()) {
+			throw std::runtime_error("Dimensions of matrices can not differ from each other.");
+		}
+
+		assign(m_entries, *this + other.self());
 		return *this;
 	}
 
-	// Subtract two matrices and assign result to *this
+	// Subtract matrix expression in place
 	template<typename T>
-	matrix<T>& matrix<T>::operator-=(const matrix<T> &other) {
-		*this = *this - other;
+	template<typename E>
+	matrix<T>& matrix<T>::operator-=(const matrix_expression<E> &other) {
+		// Check for valid argument
+		if (m_rows != other.rows() || m_cols != other.columns()) {
+			throw std::runtime_error("Dimensions of matrices can not differ from each other.");
+		}
+
+		assign(m_entries, *this - other.self());
 		return *this;
 	}
 
@@ -568,10 +647,7 @@ namespace la {
 	matrix<T>& matrix<T>::operator=(const matrix<T> &other)
 		noexcept(std::is_nothrow_default_constructible_v<T>) {
 		if (this != &other) {
-			if (this->entries() != other.entries()) {
-				delete[] m_entries;
-				m_entries = new T[other.entries()];
-			}
+			reserve(other.entries());
 			m_rows = other.m_rows;
 			m_cols = other.m_cols;
 			std::copy(other.m_entries, other.m_entries + other.entries(), 
@@ -584,25 +660,46 @@ namespace la {
 	template<typename T>
 	matrix<T>& matrix<T>::operator=(matrix<T> &&other) noexcept {
 		if (this != &other) {
-			delete[] m_entries;
+			release();
 			m_entries = other.m_entries;
+			m_capacity = other.m_capacity;
+			m_owner = other.m_owner;
 			other.m_entries = nullptr;
+			other.m_capacity = 0;
 			m_rows = other.m_rows;
 			m_cols = other.m_cols;
 		}
 		return *this;
 	}
 
+	// Assign elementwise expression, only reallocates if the entries do not fit
+	// into the storage
+	template<typename T>
+	template<typename E>
+	matrix<T>& matrix<T>::operator=(const matrix_expression<E> &expr) {
+		static_assert(!E::is_vector, "Can not assign vector expression to matrix.");
+		reserve(expr.entries());
+		m_rows = expr.rows();
+		m_cols = expr.columns();
+		assign(m_entries, expr);
+		return *this;
+	}
+
 	// Check two matrices for equality
 	template<typename T>
 	bool matrix<T>::operator==(const matrix &other) const noexcept {
 		if (m_rows != other.m_rows || m_cols != other.m_cols) { return false; }
-		for (size_t i = 0; i < other.entries(); i++) {
-			if (m_entries[i] != other.m_entries[i]) {
-				return false;
+		if constexpr (simd_supported_v<T>) {
+			return simd_equal(m_entries, other.m_entries, entries());
+		}
+		else {
+			for (size_t i = 0; i < other.entries(); i++) {
+				if (m_entries[i] != other.m_entries[i]) {
+					return false;
+				}
 			}
+			return true;
 		}
-		return true;
 	}
 
 	// Check two matrices for inequality
@@ -612,13 +709,6 @@ namespace la {
 		return true;
 	}
 
-	// Allow left handed multiplication by constant
-	template<typename U, typename T>
-	matrix<T> operator*(const U &lhs, const matrix<T> &m) 
-		noexcept(std::is_nothrow_constructible_v<matrix<T>, size_t, size_t>) {
-		return m * lhs;
-	}
-
 	// Test wise implementation
 	template<typename T>
 	std::ostream& operator<<(std::ostream &os, const matrix<T> &m) {
@@ -0,0 +1,196 @@
+#include "stdafx.h"
+#include "MixedLU.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "Gemm.hpp"
+#include "Gemv.hpp"
+#include "ThreadPool.hpp"
+
+namespace la {
+	namespace {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		// Round to float, values beyond its range become infinite
+		float narrow(double v) noexcept {
+			const double max = std::numeric_limits<float>::max();
+			if (v > max) { return std::numeric_limits<float>::infinity(); }
+			if (v < -max) { return -std::numeric_limits<float>::infinity(); }
+			return static_cast<float>(v);
+		}
+
+		// Float copy of a quadratic matrix, rows in parallel
+		matrix<float> to_float(const matrix<double> &m) {
+			// Check for valid argument
+			if (m.rows() != m.columns()) {
+				throw std::invalid_argument("Matrix has to be quadratic.");
+			}
+
+			size_t n = m.columns();
+			matrix<float> f(n, n);
+			const double *src = m.data();
+			float *dst = f.data();
+			thread_pool::instance().parallel_for(0, n, std::max<size_t>(minEntriesPerTask / n, 1),
+				[src, dst, n](size_t first, size_t last) {
+				for (size_t i = first * n; i < last * n; i++) {
+					dst[i] = narrow(src[i]);
+				}
+			});
+			return f;
+		}
+
+		double max_norm(const double *v, size_t count) noexcept {
+			double norm = 0.0;
+			for (size_t i = 0; i < count; i++) {
+				norm = std::max(norm, std::abs(v[i]));
+			}
+			return norm;
+		}
+	}
+
+	// Factorize the float copy right away, the double factorization only when
+	// refinement needs it
+	mixed_lu::mixed_lu(const matrix<double> &m)
+		: m_matrix(m), m_low(to_float(m)) {
+		size_t n = m.rows();
+		for (size_t i = 0; i < n; i++) {
+			double sum = 0.0;
+			for (size_t j = 0; j < n; j++) {
+				sum += std::abs(m.unchecked(i, j));
+			}
+			m_norm = std::max(m_norm, sum);
+		}
+
+		const matrix<float> &factors = m_low.factors();
+		m_lowUsable = !m_low.singular() &&
+			std::all_of(factors.data(), factors.data() + n * n, [](float f) { return std::isfinite(f); });
+	}
+
+	// Factorize in double on first use
+	const lu<double>& mixed_lu::high() const {
+		std::lock_guard<std::mutex> lock(m_highMutex);
+		if (!m_high) {
+			m_high = std::make_unique<lu<double>>(m_matrix);
+		}
+		return *m_high;
+	}
+
+	// Every right-hand side for the float factors is scaled to a max norm of 1
+	// first, so residuals far below the range of float do not underflow
+	void mixed_lu::refine(const double *b, double *x, size_t cols, refinement_report &report) const {
+		size_t n = size();
+		size_t count = n * cols;
+		const double *a = m_matrix.data();
+		report = refinement_report();
+		double tolerance = m_norm * std::numeric_limits<double>::epsilon() * std::sqrt(double(n));
+
+		matrix<double> r(n, cols);
+		// r = b - A * x
+		auto residual = [&]() {
+			std::copy(b, b + count, r.data());
+			if (cols == 1) {
+				gemv(n, n, -1.0, a, n, 1, x, 1, 1.0, r.data(), 1);
+			}
+			else {
+				gemm_subtract_parallel(n, cols, n, a, n, 1, x, cols, 1, r.data(), cols, 1);
+			}
+			return max_norm(r.data(), count);
+		};
+		// Solve A * d = v with the float factors and add d * scale to x
+		auto correct = [&](const double *v, double norm, bool assign) {
+			matrix<float> low(n, cols);
+			double scale = norm == 0.0 ? 1.0 : norm;
+			for (size_t i = 0; i < count; i++) {
+				low.data()[i] = narrow(v[i] / scale);
+			}
+			matrix<float> d = m_low.solve(low);
+			for (size_t i = 0; i < count; i++) {
+				x[i] = (assign ? 0.0 : x[i]) + scale * d.data()[i];
+			}
+		};
+
+		bool fallen = false;
+		{
+			std::lock_guard<std::mutex> lock(m_highMutex);
+			fallen = m_high != nullptr;
+		}
+
+		if (m_lowUsable && !fallen) {
+			correct(b, max_norm(b, count), true);
+
+			double previous = std::numeric_limits<double>::infinity();
+			for (size_t step = 0; step <= maxIterations; step++) {
+				double rNorm = residual();
+				double xNorm = max_norm(x, count);
+				if (!std::isfinite(rNorm) || !std::isfinite(xNorm)) { break; }
+				if (rNorm <= xNorm * tolerance) {
+					report.residual = rNorm;
+					return;
+				}
+				// Stalled or too slow to be worth it
+				if (rNorm > 0.5 * previous || step == maxIterations) { break; }
+
+				previous = rNorm;
+				correct(r.data(), rNorm, false);
+				report.iterations++;
+			}
+		}
+
+		report.fallback = true;
+		matrix<double> rhs(n, cols);
+		std::copy(b, b + count, rhs.data());
+		matrix<double> solution = high().solve(rhs);
+		std::copy(solution.data(), solution.data() + count, x);
+		report.residual = residual();
+	}
+
+	// Getter for the dimension of the quadratic matrix
+	size_t mixed_lu::size() const noexcept {
+		return m_low.size();
+	}
+
+	// Getter for the float factorization
+	const lu<float>& mixed_lu::factors() const noexcept {
+		return m_low;
+	}
+
+	// Solve A * x = b
+	vector<double> mixed_lu::solve(const vector<double> &b) const {
+		refinement_report report;
+		return solve(b, report);
+	}
+
+	// Solve A * x = b and report the refinement
+	vector<double> mixed_lu::solve(const vector<double> &b, refinement_report &report) const {
+		// Check for valid argument
+		if (b.size() != size()) {
+			throw std::invalid_argument("Size of vector has to match the matrix.");
+		}
+
+		vector<double> x(size());
+		refine(b.data(), x.data(), 1, report);
+		return x;
+	}
+
+	// Solve A * X = B for all columns of B at once
+	matrix<double> mixed_lu::solve(const matrix<double> &b) const {
+		refinement_report report;
+		return solve(b, report);
+	}
+
+	// Solve A * X = B and report the refinement, the columns are refined
+	// together until all of them are accurate
+	matrix<double> mixed_lu::solve(const matrix<double> &b, refinement_report &report) const {
+		// Check for valid argument
+		if (b.rows() != size()) {
+			throw std::invalid_argument("Rows of matrix have to match the factorized matrix.");
+		}
+
+		matrix<double> x(size(), b.columns());
+		refine(b.data(), x.data(), b.columns(), report);
+		return x;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+#include "LU.hpp"
+#include "Matrix.hpp"
+#include "Vector.hpp"
+
+namespace la {
+	// What a mixed precision solve took
+	struct refinement_report {
+		// Corrections applied to the solution of the float factors
+		size_t iterations = 0;
+		// Whether refinement stalled and the double factorization was used
+		bool fallback = false;
+		// Largest entry of the final residual B - A * X
+		double residual = 0.0;
+	};
+
+	// Solver for double systems that does the O(n^3) elimination in float, with
+	// half the memory traffic and twice the SIMD width. The solution of the
+	// float factors is refined in double: the residual r = b - A * x is
+	// computed in double, the correction d from A * d = r with the float
+	// factors, until the residual reaches what a double factorization achieves,
+	// |r| <= |x| * |A| * eps * sqrt(n) in the max norm. If the residual does not
+	// at least halve per step, which happens once the condition number nears
+	// 1 / eps of float, the matrix is factorized in double once and that
+	// factorization is used from then on.
+	//
+	// The matrix is copied like lu copies it, so temporaries can be passed.
+	class mixed_lu {
+	private:
+		// Refinement gives up after this many corrections, like LAPACK's dsgesv
+		static constexpr size_t maxIterations = 30;
+
+		matrix<double> m_matrix;
+		lu<float> m_low;
+		// Max norm of the matrix for the stopping criterion
+		double m_norm = 0.0;
+		// Whether the float factors are usable at all, false if entries
+		// exceeded the range of float or the factors are singular
+		bool m_lowUsable = true;
+
+		// Factorization in double, created by the first solve that needs it
+		mutable std::unique_ptr<lu<double>> m_high;
+		mutable std::mutex m_highMutex;
+
+		const lu<double>& high() const;
+		// Solve for the n x cols row-major right-hand sides b into x
+		void refine(const double *, double *, size_t, refinement_report &) const;
+
+	public:
+		// Constructors
+
+		// Factorize a float copy of the matrix
+		// Throws std::invalid_argument if the matrix is not quadratic
+		explicit mixed_lu(const matrix<double> &);
+
+		// Getter
+		size_t size() const noexcept;
+		const lu<float>& factors() const noexcept;
+
+		// Solve A * x = b and A * X = B to double accuracy
+		// Throw std::invalid_argument if the size does not match or the matrix
+		// is singular
+		vector<double> solve(const vector<double> &) const;
+		vector<double> solve(const vector<double> &, refinement_report &) const;
+		matrix<double> solve(const matrix<double> &) const;
+		matrix<double> solve(const matrix<double> &, refinement_report &) const;
+	};
+}
\ No newline at end of file
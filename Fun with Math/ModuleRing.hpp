@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
+#include <type_traits>
 
 namespace la {
 	template<uint32_t m>
@@ -45,6 +47,13 @@ namespace la {
 		bool operator>=(const module_ring &) const;
 	};
 
+	// Modulus of a residue class type, 0 for all other types
+	template<typename T>
+	struct ring_modulus : std::integral_constant<uint32_t, 0> {};
+
+	template<uint32_t m>
+	struct ring_modulus<module_ring<m>> : std::integral_constant<uint32_t, m> {};
+
 	template<uint32_t m>
 	module_ring<m> operator*(uint32_t, const module_ring<m> &);
 
@@ -69,67 +78,73 @@ namespace la {
 
 	template<uint32_t m>
 	module_ring<m> module_ring<m>::operator*(uint32_t other) const {
-		return module_ring<m>(m_value * other);
+		module_ring<m> r(*this);
+		return r *= other;
 	}
 
 	template<uint32_t m>
 	module_ring<m> module_ring<m>::operator*(const module_ring<m> &other) const {
-		return module_ring<m>(m_value * other.m_value);
+		module_ring<m> r(*this);
+		return r *= other;
 	}
 
 	template<uint32_t m>
 	module_ring<m> module_ring<m>::operator+(uint32_t other) const {
-		return module_ring<m>(m_value + other);
+		module_ring<m> r(*this);
+		return r += other;
 	}
 
 	template<uint32_t m>
 	module_ring<m> module_ring<m>::operator+(const module_ring<m> &other) const {
-		return module_ring<m>(m_value + other.m_value);
+		module_ring<m> r(*this);
+		return r += other;
 	}
 
 	template<uint32_t m>
 	module_ring<m> module_ring<m>::operator-(uint32_t other) const {
-		return module_ring<m>(m_value - other);
+		module_ring<m> r(*this);
+		return r -= other;
 	}
 
 	template<uint32_t m>
 	module_ring<m> module_ring<m>::operator-(const module_ring<m> &other) const {
-		return module_ring<m>(m_value - other.m_value);
+		module_ring<m> r(*this);
+		return r -= other;
 	}
 
 	template<uint32_t m>
 	module_ring<m>& module_ring<m>::operator*=(uint32_t other) {
-		*this = *this * other;
+		m_value = static_cast<uint32_t>(uint64_t(m_value) * other % m);
 		return *this;
 	}
 
 	template<uint32_t m>
 	module_ring<m>& module_ring<m>::operator*=(const module_ring<m> &other) {
-		*this = *this * other;
+		m_value = static_cast<uint32_t>(uint64_t(m_value) * other.m_value % m);
 		return *this;
 	}
 
 	template<uint32_t m>
 	module_ring<m>& module_ring<m>::operator+=(uint32_t other) {
-		*this = *this + other;
+		m_value = static_cast<uint32_t>((uint64_t(m_value) + other % m) % m);
 		return *this;
 	}
 
 	template<uint32_t m>
 	module_ring<m>& module_ring<m>::operator+=(const module_ring<m> &other) {
-		*this = *this + other;
+		m_value = static_cast<uint32_t>((uint64_t(m_value) + other.m_value) % m);
 		return *this;
 	}
 
 	template<uint32_t m>
 	module_ring<m>& module_ring<m>::operator-=(uint32_t other) {
-		*this = *this - other;
+		m_value = static_cast<uint32_t>((uint64_t(m_value) + m - other % m) % m);
 		return *this;
 	}
 
 	template<uint32_t m>
 	module_ring<m>& module_ring<m>::operator-=(const module_ring<m> &other) {
-		*this = *this - other;
+		m_value = static_cast<uint32_t>((uint64_t(m_value) + m - other.m_value) % m);
 		return *this;
 	}
 
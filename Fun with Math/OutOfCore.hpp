@@ -0,0 +1,508 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Allocator.hpp"
+#include "Gemm.hpp"
+#include "LU.hpp"
+#include "Matrix.hpp"
+#include "Serialization.hpp"
+#include "ThreadPool.hpp"
+
+namespace la {
+	// Matrix stored in a file on disk in square tiles, for matrices larger than
+	// the memory. The file starts with the header of matrix files, followed by
+	// the tiles ordered by tile rows. Every tile is stored row-major in a slot of
+	// tile x tile entries, tiles at the right and bottom edge only use the start
+	// of their slot. Tiles are read and written whole, so their size should be
+	// large enough to make a disk access worth it.
+	//
+	// Tiles may be read and written from several threads at once.
+	template<typename T>
+	class tiled_matrix {
+	private:
+		std::unique_ptr<std::fstream> m_file;
+		// Serializes the accesses to the file
+		std::unique_ptr<std::mutex> m_mutex;
+
+		size_t m_rows = 0, m_cols = 0;
+		size_t m_tile = 0;
+		uint64_t m_dataOffset = 0;
+
+		// Position of the first entry of a tile in the file
+		std::streamoff offset(size_t, size_t) const noexcept;
+		// Throws std::out_of_range if the tile does not exist
+		void check_tile(size_t, size_t) const;
+
+	public:
+		// Constructors
+
+		// Create a file for a rows x columns matrix of zeros with the given
+		// tile size, replacing an existing file. The file is extended without
+		// writing the zeros where the file system supports it.
+		// Throws std::logic_error for zero dimensions or tile size and
+		// std::runtime_error if the file can not be created
+		tiled_matrix(const std::string &, size_t, size_t, size_t = 1024);
+		// Open an existing file
+		// Throws std::runtime_error if the file does not hold a tiled matrix
+		// of T in the byte order of this machine
+		explicit tiled_matrix(const std::string &);
+
+		// Getter for the dimensions and the tiling
+		size_t rows() const noexcept;
+		size_t columns() const noexcept;
+		size_t tile_size() const noexcept;
+		size_t row_tiles() const noexcept;
+		size_t column_tiles() const noexcept;
+		// Dimensions of the tiles in a tile row or column
+		size_t tile_rows(size_t) const noexcept;
+		size_t tile_columns(size_t) const noexcept;
+
+		// Read or write the tile in the given tile row and column, from or to
+		// a row-major block with the given row stride
+		// Throw std::out_of_range if the tile does not exist and
+		// std::runtime_error if the file access fails
+		void read_tile(size_t, size_t, T *, size_t) const;
+		void write_tile(size_t, size_t, const T *, size_t);
+		matrix<T> read_tile(size_t, size_t) const;
+		void write_tile(size_t, size_t, const matrix<T> &);
+
+		// Write buffered tiles to the file, so other handles of it see them
+		// Throws std::runtime_error if writing fails
+		void flush();
+	};
+
+	// Multiply C = A * B tile by tile. Only two tiles of A and B and one tile
+	// of C are in memory at a time: the next pair of tiles is read on another
+	// thread while the current pair is multiplied on the thread pool. C has to
+	// be a different file than A and B and is flushed when done.
+	// Throws std::runtime_error if the dimensions do not match and
+	// std::invalid_argument if the matrices use different tile sizes
+	template<typename T>
+	void gemm_out_of_core(const tiled_matrix<T> &, const tiled_matrix<T> &, tiled_matrix<T> &);
+
+	// Factorize P * A = L * U in place, L and U are stored in the file like
+	// lu<T>::factors() and row i of them is row p[i] of the original matrix for
+	// the returned permutation p.
+	//
+	// The factorization is left-looking over tile columns: a column is read,
+	// updated with all factorized columns left of it and factorized with lu<T>,
+	// so the pivots are chosen from the whole column like in memory. While one
+	// column is applied, the next one is read on another thread. Three tile
+	// columns, rows x tile entries each, have to fit into memory. Until the
+	// factorization is complete, the file keeps the rows in their original order,
+	// a final pass brings them into the order of the permutation and flushes the
+	// file. If an exception is thrown the contents of the file are unspecified.
+	// Throws std::runtime_error if the file access fails
+	template<typename T>
+	std::vector<size_t> lu_out_of_core(tiled_matrix<T> &, pivoting = pivoting::largest);
+
+	namespace detail {
+		// Read or write all tiles of a tile column as one row-major block of
+		// rows x tile_columns(column) entries
+		template<typename T>
+		void read_tile_column(const tiled_matrix<T> &a, size_t column, T *dst) {
+			size_t width = a.tile_columns(column);
+			for (size_t bi = 0; bi < a.row_tiles(); bi++) {
+				a.read_tile(bi, column, dst + bi * a.tile_size() * width, width);
+			}
+		}
+
+		template<typename T>
+		void write_tile_column(tiled_matrix<T> &a, size_t column, const T *src) {
+			size_t width = a.tile_columns(column);
+			for (size_t bi = 0; bi < a.row_tiles(); bi++) {
+				a.write_tile(bi, column, src + bi * a.tile_size() * width, width);
+			}
+		}
+	}
+
+	// Write the header and extend the file to its full size
+	template<typename T>
+	tiled_matrix<T>::tiled_matrix(const std::string &path, size_t rows, size_t cols, size_t tile)
+		: m_mutex(std::make_unique<std::mutex>()), m_rows(rows), m_cols(cols), m_tile(tile) {
+		if (rows == 0 || cols == 0 || tile == 0) {
+			throw std::logic_error("Matrix does not allow zero dimensions.");
+		}
+
+		m_file = std::make_unique<std::fstream>(path,
+			std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!*m_file) {
+			throw std::runtime_error("Could not open file " + path + ".");
+		}
+
+		matrix_file_header header = detail::make_header<T>(rows, cols, tile);
+		m_dataOffset = header.dataOffset;
+		const char padding[64] = {};
+		m_file->write(reinterpret_cast<const char *>(&header), sizeof(header));
+		m_file->write(padding, std::streamsize(header.dataOffset - sizeof(header)));
+
+		// Writing the last byte lets the file system fill the rest with zeros
+		std::streamoff end = offset(row_tiles(), 0);
+		m_file->seekp(end - 1);
+		m_file->put(0);
+		m_file->flush();
+		if (!*m_file) {
+			throw std::runtime_error("Could not write file " + path + ".");
+		}
+	}
+
+	// Read and check the header
+	template<typename T>
+	tiled_matrix<T>::tiled_matrix(const std::string &path)
+		: m_mutex(std::make_unique<std::mutex>()) {
+		m_file = std::make_unique<std::fstream>(path, std::ios::in | std::ios::out | std::ios::binary);
+		if (!*m_file) {
+			throw std::runtime_error("Could not open file " + path + ".");
+		}
+
+		matrix_file_header header;
+		if (!m_file->read(reinterpret_cast<char *>(&header), sizeof(header))) {
+			throw std::runtime_error("File does not hold a matrix.");
+		}
+		if (detail::check_header<T>(header, true)) {
+			throw std::runtime_error("Tiled matrix file has to be in the byte order of this machine.");
+		}
+
+		m_rows = size_t(header.rows);
+		m_cols = size_t(header.columns);
+		m_tile = size_t(header.tileSize);
+		m_dataOffset = header.dataOffset;
+
+		m_file->seekg(0, std::ios::end);
+		if (m_file->tellg() < offset(row_tiles(), 0)) {
+			throw std::runtime_error("Matrix file is truncated.");
+		}
+	}
+
+	// Slots are ordered by tile rows, then tile columns
+	template<typename T>
+	std::streamoff tiled_matrix<T>::offset(size_t bi, size_t bj) const noexcept {
+		return std::streamoff(m_dataOffset + (uint64_t(bi) * column_tiles() + bj) * m_tile * m_tile * sizeof(T));
+	}
+
+	// Check the tile indices
+	template<typename T>
+	void tiled_matrix<T>::check_tile(size_t bi, size_t bj) const {
+		if (bi >= row_tiles() || bj >= column_tiles()) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+	}
+
+	// Getter for rows
+	template<typename T>
+	size_t tiled_matrix<T>::rows() const noexcept {
+		return m_rows;
+	}
+
+	// Getter for columns
+	template<typename T>
+	size_t tiled_matrix<T>::columns() const noexcept {
+		return m_cols;
+	}
+
+	// Getter for the side length of the tiles
+	template<typename T>
+	size_t tiled_matrix<T>::tile_size() const noexcept {
+		return m_tile;
+	}
+
+	// Getter for the number of tile rows
+	template<typename T>
+	size_t tiled_matrix<T>::row_tiles() const noexcept {
+		return (m_rows + m_tile - 1) / m_tile;
+	}
+
+	// Getter for the number of tile columns
+	template<typename T>
+	size_t tiled_matrix<T>::column_tiles() const noexcept {
+		return (m_cols + m_tile - 1) / m_tile;
+	}
+
+	// Rows of the tiles in a tile row, less at the bottom edge
+	template<typename T>
+	size_t tiled_matrix<T>::tile_rows(size_t bi) const noexcept {
+		return std::min(m_tile, m_rows - bi * m_tile);
+	}
+
+	// Columns of the tiles in a tile column, less at the right edge
+	template<typename T>
+	size_t tiled_matrix<T>::tile_columns(size_t bj) const noexcept {
+		return std::min(m_tile, m_cols - bj * m_tile);
+	}
+
+	// Read a tile with one access if the block is contiguous
+	template<typename T>
+	void tiled_matrix<T>::read_tile(size_t bi, size_t bj, T *dst, size_t ld) const {
+		check_tile(bi, bj);
+		size_t rows = tile_rows(bi);
+		size_t cols = tile_columns(bj);
+
+		std::lock_guard<std::mutex> lock(*m_mutex);
+		m_file->seekg(offset(bi, bj));
+		if (ld == cols) {
+			m_file->read(reinterpret_cast<char *>(dst), std::streamsize(rows * cols * sizeof(T)));
+		}
+		else {
+			for (size_t i = 0; i < rows; i++) {
+				m_file->read(reinterpret_cast<char *>(dst + i * ld), std::streamsize(cols * sizeof(T)));
+			}
+		}
+		if (!*m_file) {
+			m_file->clear();
+			throw std::runtime_error("Could not read tile.");
+		}
+	}
+
+	// Write a tile with one access if the block is contiguous
+	template<typename T>
+	void tiled_matrix<T>::write_tile(size_t bi, size_t bj, const T *src, size_t ld) {
+		check_tile(bi, bj);
+		size_t rows = tile_rows(bi);
+		size_t cols = tile_columns(bj);
+
+		std::lock_guard<std::mutex> lock(*m_mutex);
+		m_file->seekp(offset(bi, bj));
+		if (ld == cols) {
+			m_file->write(reinterpret_cast<const char *>(src), std::streamsize(rows * cols * sizeof(T)));
+		}
+		else {
+			for (size_t i = 0; i < rows; i++) {
+				m_file->write(reinterpret_cast<const char *>(src + i * ld), std::streamsize(cols * sizeof(T)));
+			}
+		}
+		if (!*m_file) {
+			m_file->clear();
+			throw std::runtime_error("Could not write tile.");
+		}
+	}
+
+	// Read a tile into a new matrix
+	template<typename T>
+	matrix<T> tiled_matrix<T>::read_tile(size_t bi, size_t bj) const {
+		check_tile(bi, bj);
+		matrix<T> tile(tile_rows(bi), tile_columns(bj));
+		read_tile(bi, bj, tile.data(), tile.columns());
+		return tile;
+	}
+
+	// Write a matrix of the dimensions of the tile
+	template<typename T>
+	void tiled_matrix<T>::write_tile(size_t bi, size_t bj, const matrix<T> &tile) {
+		check_tile(bi, bj);
+		if (tile.rows() != tile_rows(bi) || tile.columns() != tile_columns(bj)) {
+			throw std::runtime_error("Dimensions of matrices can not differ from each other.");
+		}
+		write_tile(bi, bj, tile.data(), tile.columns());
+	}
+
+	// Flush the file stream
+	template<typename T>
+	void tiled_matrix<T>::flush() {
+		std::lock_guard<std::mutex> lock(*m_mutex);
+		if (!m_file->flush()) {
+			m_file->clear();
+			throw std::runtime_error("Could not write tile.");
+		}
+	}
+
+	// Walk over the tiles of C row by row and sum up the products along the
+	// inner dimension. The tile of C accumulates -C, so the subtracting kernel
+	// of the eliminations can be reused and zero sums stay +0.
+	template<typename T>
+	void gemm_out_of_core(const tiled_matrix<T> &a, const tiled_matrix<T> &b, tiled_matrix<T> &c) {
+		// Check for valid arguments
+		if (a.columns() != b.rows()) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not \
+									  match the columns of the first matrix.");
+		}
+		if (c.rows() != a.rows() || c.columns() != b.columns()) {
+			throw std::runtime_error("Size of the result matrix has to match the product.");
+		}
+		if (a.tile_size() != b.tile_size() || a.tile_size() != c.tile_size()) {
+			throw std::invalid_argument("Matrices have to use the same tile size.");
+		}
+
+		using buffer = std::vector<T, matrix_allocator_t<T>>;
+		size_t tile = a.tile_size();
+		size_t depthTiles = a.column_tiles();
+		size_t steps = a.row_tiles() * b.column_tiles() * depthTiles;
+
+		// Every step multiplies the tiles A(i, k) and B(k, j), k changes fastest
+		struct operands {
+			buffer a, b;
+		};
+		operands pairs[2] = { { buffer(tile * tile), buffer(tile * tile) },
+			{ buffer(tile * tile), buffer(tile * tile) } };
+		auto load = [&a, &b, depthTiles](size_t step, operands *pair) {
+			size_t bi = step / depthTiles / b.column_tiles();
+			size_t bj = step / depthTiles % b.column_tiles();
+			size_t bk = step % depthTiles;
+			a.read_tile(bi, bk, pair->a.data(), a.tile_columns(bk));
+			b.read_tile(bk, bj, pair->b.data(), b.tile_columns(bj));
+		};
+
+		buffer sum(tile * tile);
+		load(0, &pairs[0]);
+		for (size_t step = 0; step < steps; step++) {
+			std::future<void> next;
+			if (step + 1 < steps) {
+				next = std::async(std::launch::async, load, step + 1, &pairs[(step + 1) % 2]);
+			}
+
+			size_t bi = step / depthTiles / b.column_tiles();
+			size_t bj = step / depthTiles % b.column_tiles();
+			size_t bk = step % depthTiles;
+			size_t rows = a.tile_rows(bi);
+			size_t cols = b.tile_columns(bj);
+			size_t depth = a.tile_columns(bk);
+			const operands &pair = pairs[step % 2];
+
+			if (bk == 0) { std::fill(sum.begin(), sum.end(), T(0)); }
+			gemm_subtract_parallel(rows, cols, depth, pair.a.data(), depth, 1,
+				pair.b.data(), cols, 1, sum.data(), cols, 1);
+
+			if (bk + 1 == depthTiles) {
+				for (size_t i = 0; i < rows * cols; i++) {
+					sum[i] = T(0) - sum[i];
+				}
+				c.write_tile(bi, bj, sum.data(), cols);
+			}
+
+			if (next.valid()) { next.get(); }
+		}
+		c.flush();
+	}
+
+	// Left-looking factorization over tile columns. The columns are stored in
+	// the original row order, so a column read from the file is brought into
+	// the current order by gathering its rows with the permutation so far.
+	template<typename T>
+	std::vector<size_t> lu_out_of_core(tiled_matrix<T> &a, pivoting rule) {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		using buffer = std::vector<T, matrix_allocator_t<T>>;
+		size_t m = a.rows();
+		size_t tile = a.tile_size();
+		size_t columnTiles = a.column_tiles();
+		size_t steps = std::min(m, a.columns());
+		// Tile columns containing pivots
+		size_t factorized = (steps + tile - 1) / tile;
+
+		std::vector<size_t> perm(m);
+		std::iota(perm.begin(), perm.end(), size_t(0));
+
+		// Columns as read from the file, being updated and the factorized
+		// column applied to it
+		buffer raw(m * tile), panel(m * tile), left(m * tile);
+		auto read = [&a](size_t column, buffer *dst) {
+			detail::read_tile_column(a, column, dst->data());
+		};
+		auto gather = [&perm, m](const buffer &src, buffer &dst, size_t width) {
+			thread_pool::instance().parallel_for(0, m, std::max<size_t>(minEntriesPerTask / width, 1),
+				[&](size_t first, size_t last) {
+				for (size_t i = first; i < last; i++) {
+					std::copy(src.data() + perm[i] * width, src.data() + (perm[i] + 1) * width,
+						dst.data() + i * width);
+				}
+			});
+		};
+
+		std::future<void> pending = std::async(std::launch::async, read, 0, &raw);
+		for (size_t column = 0; column < columnTiles; column++) {
+			size_t j0 = column * tile;
+			size_t width = a.tile_columns(column);
+			pending.get();
+			gather(raw, panel, width);
+
+			// The raw buffer is free again, read the next column the panel
+			// needs or the next panel itself
+			size_t applied = std::min(column, factorized);
+			auto prefetch = [&](size_t next) {
+				if (next < applied) {
+					pending = std::async(std::launch::async, read, next, &raw);
+				}
+				else if (column + 1 < columnTiles) {
+					pending = std::async(std::launch::async, read, column + 1, &raw);
+				}
+			};
+			prefetch(0);
+
+			for (size_t k = 0; k < applied; k++) {
+				pending.get();
+				gather(raw, left, tile);
+				prefetch(k + 1);
+
+				size_t k0 = k * tile;
+				size_t kb = std::min(tile, m - k0);
+				const T *l = left.data();
+				T *u = panel.data() + k0 * width;
+
+				// U(k, column) = L(k, k)^-1 * A(k, column), the columns are
+				// independent of each other
+				thread_pool::instance().parallel_for(0, width, std::max<size_t>(minEntriesPerTask / kb, 1),
+					[=](size_t first, size_t last) {
+					for (size_t j = 0; j < kb; j++) {
+						for (size_t i = j + 1; i < kb; i++) {
+							T l_ij = l[(k0 + i) * tile + j];
+							if (l_ij == T(0)) { continue; }
+							for (size_t c = first; c < last; c++) {
+								u[i * width + c] -= l_ij * u[j * width + c];
+							}
+						}
+					}
+				});
+
+				// A(below, column) -= L(below, k) * U(k, column)
+				gemm_subtract_parallel(m - k0 - kb, width, kb, l + (k0 + kb) * tile, tile, 1,
+					u, width, 1, u + kb * width, width, 1);
+			}
+
+			// Factorize the part of the column from the diagonal down where it
+			// is, a copy would be a fourth column in memory
+			if (j0 < steps) {
+				size_t height = m - j0;
+				std::vector<size_t> order = lu<T>::factorize_in_place(panel.data() + j0 * width,
+					height, width, rule);
+
+				std::vector<size_t> rowOrder(perm.begin() + j0, perm.end());
+				for (size_t i = 0; i < height; i++) {
+					perm[j0 + i] = rowOrder[order[i]];
+				}
+			}
+
+			// Store the column in the original row order
+			for (size_t i = 0; i < m; i++) {
+				std::copy(panel.data() + i * width, panel.data() + (i + 1) * width,
+					left.data() + perm[i] * width);
+			}
+			detail::write_tile_column(a, column, left.data());
+		}
+
+		// Bring every column into the final row order, reading the next one
+		// while the current one is written
+		pending = std::async(std::launch::async, read, 0, &raw);
+		for (size_t column = 0; column < columnTiles; column++) {
+			pending.get();
+			size_t width = a.tile_columns(column);
+			gather(raw, panel, width);
+			if (column + 1 < columnTiles) {
+				pending = std::async(std::launch::async, read, column + 1, &raw);
+			}
+			detail::write_tile_column(a, column, panel.data());
+		}
+		a.flush();
+
+		return perm;
+	}
+}
\ No newline at end of file
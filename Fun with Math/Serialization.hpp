@@ -0,0 +1,358 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "Allocator.hpp"
+#include "Complex.hpp"
+#include "MappedFile.hpp"
+#include "Matrix.hpp"
+
+namespace la {
+	// Binary matrix files. A 64 byte header is followed by the entries in
+	// row-major order, stored exactly as they lie in memory. The entries start
+	// at an offset aligned to storage_alignment, so a mapped file can be used
+	// as the storage of a matrix without copying.
+
+	// Entry types of matrix files
+	enum class storage_type : uint32_t {
+		int8 = 1, uint8, int16, uint16, int32, uint32, int64, uint64,
+		float32, float64, complex128
+	};
+
+	// Header at the start of every matrix file
+	struct matrix_file_header {
+		char magic[8];
+		uint32_t version;
+		// byte_order_mark as written by the saving machine, the entries have
+		// the same byte order
+		uint32_t byteOrder;
+		storage_type type;
+		uint32_t entrySize;
+		uint64_t rows;
+		uint64_t columns;
+		// Distance of the first entry from the start of the file
+		uint64_t dataOffset;
+		// Side length of the tiles of out-of-core matrices, 0 for row-major
+		// files
+		uint64_t tileSize;
+		char reserved[8];
+	};
+	static_assert(sizeof(matrix_file_header) == 64, "Header has to fill a cache line.");
+
+	constexpr char matrix_file_magic[8] = { 'L', 'A', 'M', 'A', 'T', 'R', 'I', 'X' };
+	constexpr uint32_t matrix_file_version = 1;
+	constexpr uint32_t byte_order_mark = 0x01020304;
+
+	// Entry type of matrix files holding T, only defined for types without
+	// indirection
+	template<typename T>
+	constexpr storage_type storage_type_of() noexcept;
+
+	// Write a matrix to a binary stream
+	// Throws std::runtime_error if writing fails
+	template<typename T>
+	void save(std::ostream &, const matrix<T> &);
+	// Write a matrix to a binary file, replacing it
+	// Throws std::runtime_error if the file can not be written
+	template<typename T>
+	void save(const std::string &, const matrix<T> &);
+
+	// Read a matrix into memory, entries saved with the other byte order are
+	// swapped
+	// Throws std::runtime_error if the stream does not hold a matrix of T
+	template<typename T>
+	matrix<T> load(std::istream &);
+	template<typename T>
+	matrix<T> load(const std::string &);
+
+	// Writes a matrix file while the entries are produced, so matrices larger
+	// than the memory can be saved. Entries are appended in row-major order.
+	template<typename T>
+	class matrix_writer {
+	private:
+		std::ostream &m_stream;
+		size_t m_entries = 0;
+		size_t m_written = 0;
+
+	public:
+		// Write the header of a rows x columns matrix
+		// Throws std::logic_error for zero dimensions and std::runtime_error
+		// if writing fails
+		matrix_writer(std::ostream &, size_t, size_t);
+
+		// Append entries
+		// Throws std::out_of_range if they exceed the matrix and
+		// std::runtime_error if writing fails
+		void write(const T *, size_t);
+		void write(const matrix<T> &);
+
+		// Whether all entries are written
+		bool complete() const noexcept;
+	};
+
+	// Matrix file mapped into memory. The matrix borrows the mapped entries,
+	// so opening takes constant time and only the pages in use are read from
+	// disk. The mapping is private: changed entries are copied on write and
+	// never reach the file.
+	template<typename T>
+	class mapped_matrix {
+	private:
+		mapped_file m_file;
+		matrix<T> m_matrix;
+
+	public:
+		// Map a matrix file
+		// Throws std::runtime_error if the file does not hold a matrix of T
+		// in the byte order of this machine
+		explicit mapped_matrix(const std::string &);
+
+		// The mapped matrix, valid as long as the mapping
+		matrix<T>& get() noexcept;
+		const matrix<T>& get() const noexcept;
+		matrix_view<const T> view() const noexcept;
+	};
+
+	namespace detail {
+		// Header for a matrix of T with the given dimensions
+		template<typename T>
+		matrix_file_header make_header(size_t rows, size_t cols, size_t tile = 0) {
+			matrix_file_header header{};
+			std::memcpy(header.magic, matrix_file_magic, sizeof(header.magic));
+			header.version = matrix_file_version;
+			header.byteOrder = byte_order_mark;
+			header.type = storage_type_of<T>();
+			header.entrySize = sizeof(T);
+			header.rows = rows;
+			header.columns = cols;
+			header.dataOffset = std::max(sizeof(matrix_file_header), storage_alignment);
+			header.tileSize = tile;
+			return header;
+		}
+
+		inline uint32_t swap_bytes(uint32_t value) noexcept {
+			return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+		}
+
+		inline uint64_t swap_bytes(uint64_t value) noexcept {
+			return (uint64_t(swap_bytes(uint32_t(value))) << 32) | swap_bytes(uint32_t(value >> 32));
+		}
+
+		// Validate a header read from a file and bring it into the byte
+		// order of this machine, returns whether the entries have to be swapped
+		template<typename T>
+		bool check_header(matrix_file_header &header, bool tiled = false) {
+			if (std::memcmp(header.magic, matrix_file_magic, sizeof(header.magic)) != 0) {
+				throw std::runtime_error("File does not hold a matrix.");
+			}
+
+			bool swapped = header.byteOrder != byte_order_mark;
+			if (swapped) {
+				if (swap_bytes(header.byteOrder) != byte_order_mark) {
+					throw std::runtime_error("Matrix file has an unknown byte order.");
+				}
+				header.version = swap_bytes(header.version);
+				header.type = storage_type(swap_bytes(uint32_t(header.type)));
+				header.entrySize = swap_bytes(header.entrySize);
+				header.rows = swap_bytes(header.rows);
+				header.columns = swap_bytes(header.columns);
+				header.dataOffset = swap_bytes(header.dataOffset);
+				header.tileSize = swap_bytes(header.tileSize);
+			}
+
+			if (header.version != matrix_file_version) {
+				throw std::runtime_error("Matrix file has an unsupported version.");
+			}
+			if (header.type != storage_type_of<T>() || header.entrySize != sizeof(T)) {
+				throw std::runtime_error("Matrix file holds entries of another type.");
+			}
+			if (header.rows == 0 || header.columns == 0 ||
+				header.columns > std::numeric_limits<size_t>::max() / sizeof(T) / header.rows) {
+				throw std::runtime_error("Matrix file has invalid dimensions.");
+			}
+			if (header.dataOffset < sizeof(matrix_file_header)) {
+				throw std::runtime_error("Matrix file has an invalid data offset.");
+			}
+			if ((header.tileSize != 0) != tiled) {
+				throw std::runtime_error(tiled ? "Matrix file is not tiled." : "Matrix file is tiled.");
+			}
+			return swapped;
+		}
+
+		// Reverse the bytes of every scalar in a block of entries, complex
+		// numbers consist of two scalars
+		template<typename T>
+		void swap_entries(T *entries, size_t count) noexcept {
+			const size_t scalar = std::is_same_v<T, complex> ? sizeof(double) : sizeof(T);
+			char *bytes = reinterpret_cast<char *>(entries);
+			for (size_t k = 0; k < count * sizeof(T); k += scalar) {
+				std::reverse(bytes + k, bytes + k + scalar);
+			}
+		}
+	}
+
+	// Tags of the supported entry types
+	template<typename T>
+	constexpr storage_type storage_type_of() noexcept {
+		if constexpr (std::is_same_v<T, complex>) {
+			static_assert(sizeof(complex) == 2 * sizeof(double), "Complex numbers have to be two doubles.");
+			return storage_type::complex128;
+		}
+		else if constexpr (std::is_floating_point_v<T>) {
+			static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Only float and double can be stored.");
+			return sizeof(T) == 4 ? storage_type::float32 : storage_type::float64;
+		}
+		else {
+			static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+				"Only arithmetic types and la::complex can be stored.");
+			switch (sizeof(T)) {
+			case 1: return std::is_signed_v<T> ? storage_type::int8 : storage_type::uint8;
+			case 2: return std::is_signed_v<T> ? storage_type::int16 : storage_type::uint16;
+			case 4: return std::is_signed_v<T> ? storage_type::int32 : storage_type::uint32;
+			default: return std::is_signed_v<T> ? storage_type::int64 : storage_type::uint64;
+			}
+		}
+	}
+
+	// Save header and entries in one go
+	template<typename T>
+	void save(std::ostream &os, const matrix<T> &m) {
+		matrix_writer<T> writer(os, m.rows(), m.columns());
+		writer.write(m);
+	}
+
+	// Save to a file
+	template<typename T>
+	void save(const std::string &path, const matrix<T> &m) {
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			throw std::runtime_error("Could not open file " + path + ".");
+		}
+		save(file, m);
+		file.close();
+		if (!file) {
+			throw std::runtime_error("Could not write file " + path + ".");
+		}
+	}
+
+	// Read the entries directly into the storage of the matrix
+	template<typename T>
+	matrix<T> load(std::istream &is) {
+		matrix_file_header header;
+		if (!is.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+			throw std::runtime_error("File does not hold a matrix.");
+		}
+		bool swapped = detail::check_header<T>(header);
+		is.ignore(std::streamsize(header.dataOffset - sizeof(header)));
+
+		matrix<T> m(size_t(header.rows), size_t(header.columns));
+		size_t entries = m.rows() * m.columns();
+		if (!is.read(reinterpret_cast<char *>(m.data()), std::streamsize(entries * sizeof(T)))) {
+			throw std::runtime_error("Matrix file is truncated.");
+		}
+		if (swapped) { detail::swap_entries(m.data(), entries); }
+		return m;
+	}
+
+	// Load from a file
+	template<typename T>
+	matrix<T> load(const std::string &path) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			throw std::runtime_error("Could not open file " + path + ".");
+		}
+		return load<T>(file);
+	}
+
+	// Start a matrix file with its header and the padding up to the entries
+	template<typename T>
+	matrix_writer<T>::matrix_writer(std::ostream &os, size_t rows, size_t cols)
+		: m_stream(os), m_entries(rows * cols) {
+		if (rows == 0 || cols == 0) {
+			throw std::logic_error("Matrix does not allow zero dimensions.");
+		}
+
+		matrix_file_header header = detail::make_header<T>(rows, cols);
+		const char padding[64] = {};
+		m_stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		m_stream.write(padding, std::streamsize(header.dataOffset - sizeof(header)));
+		if (!m_stream) {
+			throw std::runtime_error("Could not write matrix header.");
+		}
+	}
+
+	// Append entries as they lie in memory
+	template<typename T>
+	void matrix_writer<T>::write(const T *entries, size_t count) {
+		if (count > m_entries - m_written) {
+			throw std::out_of_range("Entries exceed the dimensions of the matrix.");
+		}
+
+		m_stream.write(reinterpret_cast<const char *>(entries), std::streamsize(count * sizeof(T)));
+		if (!m_stream) {
+			throw std::runtime_error("Could not write matrix entries.");
+		}
+		m_written += count;
+	}
+
+	// Append all entries of a matrix, for example a band of rows
+	template<typename T>
+	void matrix_writer<T>::write(const matrix<T> &m) {
+		write(m.data(), m.rows() * m.columns());
+	}
+
+	// Check whether the file is finished
+	template<typename T>
+	bool matrix_writer<T>::complete() const noexcept {
+		return m_written == m_entries;
+	}
+
+	// Map the file and let the matrix borrow its entries
+	template<typename T>
+	mapped_matrix<T>::mapped_matrix(const std::string &path)
+		: m_file(path) {
+		matrix_file_header header;
+		if (m_file.size() < sizeof(header)) {
+			throw std::runtime_error("File does not hold a matrix.");
+		}
+		std::memcpy(&header, m_file.data(), sizeof(header));
+		if (detail::check_header<T>(header)) {
+			throw std::runtime_error("Matrix file has to be loaded to swap its byte order.");
+		}
+		if (header.dataOffset % alignof(T) != 0) {
+			throw std::runtime_error("Matrix file has an invalid data offset.");
+		}
+		size_t bytes = size_t(header.rows * header.columns) * sizeof(T);
+		if (m_file.size() < header.dataOffset || m_file.size() - header.dataOffset < bytes) {
+			throw std::runtime_error("Matrix file is truncated.");
+		}
+
+		m_matrix = matrix<T>(reinterpret_cast<T *>(m_file.data() + header.dataOffset),
+			size_t(header.rows), size_t(header.columns), buffer::borrow);
+	}
+
+	// Getter for the mapped matrix
+	template<typename T>
+	matrix<T>& mapped_matrix<T>::get() noexcept {
+		return m_matrix;
+	}
+
+	// Getter for the mapped matrix
+	template<typename T>
+	const matrix<T>& mapped_matrix<T>::get() const noexcept {
+		return m_matrix;
+	}
+
+	// Read-only view of the mapped entries
+	template<typename T>
+	matrix_view<const T> mapped_matrix<T>::view() const noexcept {
+		return m_matrix.view();
+	}
+}
\ No newline at end of file
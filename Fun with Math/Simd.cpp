@@ -0,0 +1,806 @@
+#include "stdafx.h"
+#include "Simd.hpp"
+#include "Batch.hpp"
+#include "Gemm.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define LA_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC allows intrinsics of every instruction set in every function
+#define LA_TARGET_AVX2
+#define LA_TARGET_AVX512
+#define LA_FLATTEN
+#else
+// GCC and Clang need the instruction set enabled per function so the rest of
+// the program still runs on CPUs without it
+#define LA_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define LA_TARGET_AVX512 __attribute__((target("avx512f,avx512dq")))
+// Inline all calls, so portable code is compiled for the instruction set of
+// the function it is called from
+#define LA_FLATTEN __attribute__((flatten))
+#endif
+#endif
+
+namespace la {
+	namespace {
+		// Portable kernels, also used for the remainder of the vectorized loops
+		namespace scalar {
+			template<typename T>
+			void add(const T *a, const T *b, T *dst, size_t n) noexcept {
+				for (size_t i = 0; i < n; i++) { dst[i] = a[i] + b[i]; }
+			}
+
+			template<typename T>
+			void sub(const T *a, const T *b, T *dst, size_t n) noexcept {
+				for (size_t i = 0; i < n; i++) { dst[i] = a[i] - b[i]; }
+			}
+
+			template<typename T>
+			void scale(const T *a, T s, T *dst, size_t n) noexcept {
+				for (size_t i = 0; i < n; i++) { dst[i] = a[i] * s; }
+			}
+
+			template<typename T>
+			void divide(const T *a, T s, T *dst, size_t n) noexcept {
+				for (size_t i = 0; i < n; i++) { dst[i] = a[i] / s; }
+			}
+
+			template<typename T>
+			void axpy(const T *a, T s, T *dst, size_t n) noexcept {
+				for (size_t i = 0; i < n; i++) { dst[i] += a[i] * s; }
+			}
+
+			template<typename T>
+			T dot(const T *a, const T *b, size_t n) noexcept {
+				T sum(0);
+				for (size_t i = 0; i < n; i++) { sum += a[i] * b[i]; }
+				return sum;
+			}
+
+			template<typename T>
+			bool equal(const T *a, const T *b, size_t n) noexcept {
+				for (size_t i = 0; i < n; i++) {
+					if (a[i] != b[i]) { return false; }
+				}
+				return true;
+			}
+		}
+
+#ifdef LA_SIMD_X86
+		// 256 bit registers. Every type provides the same set of operations so
+		// the kernels below are written once for all of them.
+		namespace avx2 {
+			template<typename T>
+			struct ops;
+
+			template<>
+			struct ops<double> {
+				using reg = __m256d;
+				static constexpr size_t width = 4;
+				LA_TARGET_AVX2 static reg load(const double *p) { return _mm256_loadu_pd(p); }
+				LA_TARGET_AVX2 static void store(double *p, reg a) { _mm256_storeu_pd(p, a); }
+				LA_TARGET_AVX2 static reg set(double s) { return _mm256_set1_pd(s); }
+				LA_TARGET_AVX2 static reg zero() { return _mm256_setzero_pd(); }
+				LA_TARGET_AVX2 static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+				LA_TARGET_AVX2 static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+				LA_TARGET_AVX2 static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+				LA_TARGET_AVX2 static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+				LA_TARGET_AVX2 static reg madd(reg acc, reg a, reg b) { return _mm256_fmadd_pd(a, b, acc); }
+				LA_TARGET_AVX2 static bool differ(reg a, reg b) {
+					return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_NEQ_UQ)) != 0;
+				}
+				LA_TARGET_AVX2 static double sum(reg a) {
+					__m128d s = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+					return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+				}
+			};
+
+			template<>
+			struct ops<float> {
+				using reg = __m256;
+				static constexpr size_t width = 8;
+				LA_TARGET_AVX2 static reg load(const float *p) { return _mm256_loadu_ps(p); }
+				LA_TARGET_AVX2 static void store(float *p, reg a) { _mm256_storeu_ps(p, a); }
+				LA_TARGET_AVX2 static reg set(float s) { return _mm256_set1_ps(s); }
+				LA_TARGET_AVX2 static reg zero() { return _mm256_setzero_ps(); }
+				LA_TARGET_AVX2 static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+				LA_TARGET_AVX2 static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+				LA_TARGET_AVX2 static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+				LA_TARGET_AVX2 static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+				LA_TARGET_AVX2 static reg madd(reg acc, reg a, reg b) { return _mm256_fmadd_ps(a, b, acc); }
+				LA_TARGET_AVX2 static bool differ(reg a, reg b) {
+					return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_NEQ_UQ)) != 0;
+				}
+				LA_TARGET_AVX2 static float sum(reg a) {
+					__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+					s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+					return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+				}
+			};
+
+			template<>
+			struct ops<std::int32_t> {
+				using reg = __m256i;
+				static constexpr size_t width = 8;
+				LA_TARGET_AVX2 static reg load(const std::int32_t *p) {
+					return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+				}
+				LA_TARGET_AVX2 static void store(std::int32_t *p, reg a) {
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(p), a);
+				}
+				LA_TARGET_AVX2 static reg set(std::int32_t s) { return _mm256_set1_epi32(s); }
+				LA_TARGET_AVX2 static reg zero() { return _mm256_setzero_si256(); }
+				LA_TARGET_AVX2 static reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+				LA_TARGET_AVX2 static reg sub(reg a, reg b) { return _mm256_sub_epi32(a, b); }
+				LA_TARGET_AVX2 static reg mul(reg a, reg b) { return _mm256_mullo_epi32(a, b); }
+				LA_TARGET_AVX2 static reg madd(reg acc, reg a, reg b) { return add(acc, mul(a, b)); }
+				LA_TARGET_AVX2 static bool differ(reg a, reg b) {
+					return _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)) != -1;
+				}
+				LA_TARGET_AVX2 static std::int32_t sum(reg a) {
+					__m128i s = _mm_add_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+					s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+					s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+					return _mm_cvtsi128_si32(s);
+				}
+			};
+
+			template<>
+			struct ops<std::int64_t> {
+				using reg = __m256i;
+				static constexpr size_t width = 4;
+				LA_TARGET_AVX2 static reg load(const std::int64_t *p) {
+					return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+				}
+				LA_TARGET_AVX2 static void store(std::int64_t *p, reg a) {
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(p), a);
+				}
+				LA_TARGET_AVX2 static reg set(std::int64_t s) { return _mm256_set1_epi64x(s); }
+				LA_TARGET_AVX2 static reg zero() { return _mm256_setzero_si256(); }
+				LA_TARGET_AVX2 static reg add(reg a, reg b) { return _mm256_add_epi64(a, b); }
+				LA_TARGET_AVX2 static reg sub(reg a, reg b) { return _mm256_sub_epi64(a, b); }
+				// There is no 64 bit multiplication before AVX-512, so it is put
+				// together from 32 bit halves: lo * lo + ((hi * lo + lo * hi) << 32)
+				LA_TARGET_AVX2 static reg mul(reg a, reg b) {
+					reg cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+						_mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+					return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+				}
+				LA_TARGET_AVX2 static reg madd(reg acc, reg a, reg b) { return add(acc, mul(a, b)); }
+				LA_TARGET_AVX2 static bool differ(reg a, reg b) {
+					return _mm256_movemask_epi8(_mm256_cmpeq_epi64(a, b)) != -1;
+				}
+				LA_TARGET_AVX2 static std::int64_t sum(reg a) {
+					__m128i s = _mm_add_epi64(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+					s = _mm_add_epi64(s, _mm_unpackhi_epi64(s, s));
+					std::int64_t result;
+					_mm_storel_epi64(reinterpret_cast<__m128i *>(&result), s);
+					return result;
+				}
+			};
+
+			template<typename T>
+			LA_TARGET_AVX2 void add(const T *a, const T *b, T *dst, size_t n) noexcept {
+				using op = ops<T>;
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					op::store(dst + i, op::add(op::load(a + i), op::load(b + i)));
+				}
+				scalar::add(a + i, b + i, dst + i, n - i);
+			}
+
+			template<typename T>
+			LA_TARGET_AVX2 void sub(const T *a, const T *b, T *dst, size_t n) noexcept {
+				using op = ops<T>;
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					op::store(dst + i, op::sub(op::load(a + i), op::load(b + i)));
+				}
+				scalar::sub(a + i, b + i, dst + i, n - i);
+			}
+
+			template<typename T>
+			LA_TARGET_AVX2 void scale(const T *a, T s, T *dst, size_t n) noexcept {
+				using op = ops<T>;
+				typename op::reg factor = op::set(s);
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					op::store(dst + i, op::mul(op::load(a + i), factor));
+				}
+				scalar::scale(a + i, s, dst + i, n - i);
+			}
+
+			template<typename T>
+			LA_TARGET_AVX2 void divide(const T *a, T s, T *dst, size_t n) noexcept {
+				using op = ops<T>;
+				typename op::reg divisor = op::set(s);
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					op::store(dst + i, op::div(op::load(a + i), divisor));
+				}
+				scalar::divide(a + i, s, dst + i, n - i);
+			}
+
+			template<typename T>
+			LA_TARGET_AVX2 void axpy(const T *a, T s, T *dst, size_t n) noexcept {
+				using op = ops<T>;
+				typename op::reg factor = op::set(s);
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					op::store(dst + i, op::madd(op::load(dst + i), op::load(a + i), factor));
+				}
+				scalar::axpy(a + i, s, dst + i, n - i);
+			}
+
+			// Four independent accumulators hide the latency of the additions
+			template<typename T>
+			LA_TARGET_AVX2 T dot(const T *a, const T *b, size_t n) noexcept {
+				using op = ops<T>;
+				typename op::reg acc0 = op::zero(), acc1 = op::zero(), acc2 = op::zero(), acc3 = op::zero();
+				size_t i = 0;
+				for (; i + 4 * op::width <= n; i += 4 * op::width) {
+					acc0 = op::madd(acc0, op::load(a + i), op::load(b + i));
+					acc1 = op::madd(acc1, op::load(a + i + op::width), op::load(b + i + op::width));
+					acc2 = op::madd(acc2, op::load(a + i + 2 * op::width), op::load(b + i + 2 * op::width));
+					acc3 = op::madd(acc3, op::load(a + i + 3 * op::width), op::load(b + i + 3 * op::width));
+				}
+				for (; i + op::width <= n; i += op::width) {
+					acc0 = op::madd(acc0, op::load(a + i), op::load(b + i));
+				}
+				acc0 = op::add(op::add(acc0, acc1), op::add(acc2, acc3));
+				return op::sum(acc0) + scalar::dot(a + i, b + i, n - i);
+			}
+
+			template<typename T>
+			LA_TARGET_AVX2 bool equal(const T *a, const T *b, size_t n) noexcept {
+				using op = ops<T>;
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					if (op::differ(op::load(a + i), op::load(b + i))) { return false; }
+				}
+				return scalar::equal(a + i, b + i, n - i);
+			}
+
+			// The portable batch kernels compiled for 256 bit registers
+			template<typename T, size_t N>
+			LA_TARGET_AVX2 LA_FLATTEN void batch_determinant(const T *a, T *det, size_t blocks) noexcept {
+				detail::determinant_blocks<T, N>(a, det, blocks);
+			}
+
+			template<typename T, size_t N>
+			LA_TARGET_AVX2 LA_FLATTEN void batch_invert(const T *a, T *inv, T *det, size_t blocks) noexcept {
+				detail::invert_blocks<T, N>(a, inv, det, blocks);
+			}
+
+			template<typename T, size_t N>
+			LA_TARGET_AVX2 LA_FLATTEN void batch_multiply(const T *a, const T *b, T *c, size_t blocks) noexcept {
+				detail::multiply_blocks<T, N, N, N>(a, b, c, blocks);
+			}
+
+			// Micro kernel of gemm: every row of the tile is two registers, the
+			// twelve accumulators hide the latency of the fused multiply-adds
+			template<typename T>
+			LA_TARGET_AVX2 void gemm_kernel(size_t kc, const T *a, const T *b, T *acc) noexcept {
+				using op = ops<T>;
+				using reg = typename op::reg;
+				constexpr size_t w = op::width;
+				static_assert(gemm_blocking<T>::mr == 6 && gemm_blocking<T>::nr == 2 * w,
+					"Kernel does not match the blocking of gemm.");
+
+				reg c00 = op::zero(), c01 = op::zero(), c10 = op::zero(), c11 = op::zero();
+				reg c20 = op::zero(), c21 = op::zero(), c30 = op::zero(), c31 = op::zero();
+				reg c40 = op::zero(), c41 = op::zero(), c50 = op::zero(), c51 = op::zero();
+				for (size_t p = 0; p < kc; p++) {
+					reg b0 = op::load(b), b1 = op::load(b + w);
+					reg ai = op::set(a[0]);
+					c00 = op::madd(c00, ai, b0);
+					c01 = op::madd(c01, ai, b1);
+					ai = op::set(a[1]);
+					c10 = op::madd(c10, ai, b0);
+					c11 = op::madd(c11, ai, b1);
+					ai = op::set(a[2]);
+					c20 = op::madd(c20, ai, b0);
+					c21 = op::madd(c21, ai, b1);
+					ai = op::set(a[3]);
+					c30 = op::madd(c30, ai, b0);
+					c31 = op::madd(c31, ai, b1);
+					ai = op::set(a[4]);
+					c40 = op::madd(c40, ai, b0);
+					c41 = op::madd(c41, ai, b1);
+					ai = op::set(a[5]);
+					c50 = op::madd(c50, ai, b0);
+					c51 = op::madd(c51, ai, b1);
+					a += 6;
+					b += 2 * w;
+				}
+
+				op::store(acc, c00);
+				op::store(acc + w, c01);
+				op::store(acc + 2 * w, c10);
+				op::store(acc + 3 * w, c11);
+				op::store(acc + 4 * w, c20);
+				op::store(acc + 5 * w, c21);
+				op::store(acc + 6 * w, c30);
+				op::store(acc + 7 * w, c31);
+				op::store(acc + 8 * w, c40);
+				op::store(acc + 9 * w, c41);
+				op::store(acc + 10 * w, c50);
+				op::store(acc + 11 * w, c51);
+			}
+		}
+
+		// 512 bit registers, same operations as above
+		namespace avx512 {
+			template<typename T>
+			struct ops;
+
+			template<>
+			struct ops<double> {
+				using reg = __m512d;
+				static constexpr size_t width = 8;
+				LA_TARGET_AVX512 static reg load(const double *p) { return _mm512_loadu_pd(p); }
+				LA_TARGET_AVX512 static void store(double *p, reg a) { _mm512_storeu_pd(p, a); }
+				LA_TARGET_AVX512 static reg set(double s) { return _mm512_set1_pd(s); }
+				LA_TARGET_AVX512 static reg zero() { return _mm512_setzero_pd(); }
+				LA_TARGET_AVX512 static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+				LA_TARGET_AVX512 static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+				LA_TARGET_AVX512 static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+				LA_TARGET_AVX512 static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+				LA_TARGET_AVX512 static reg madd(reg acc, reg a, reg b) { return _mm512_fmadd_pd(a, b, acc); }
+				LA_TARGET_AVX512 static bool differ(reg a, reg b) {
+					return _mm512_cmp_pd_mask(a, b, _CMP_NEQ_UQ) != 0;
+				}
+				LA_TARGET_AVX512 static double sum(reg a) { return _mm512_reduce_add_pd(a); }
+			};
+
+			template<>
+			struct ops<float> {
+				using reg = __m512;
+				static constexpr size_t width = 16;
+				LA_TARGET_AVX512 static reg load(const float *p) { return _mm512_loadu_ps(p); }
+				LA_TARGET_AVX512 static void store(float *p, reg a) { _mm512_storeu_ps(p, a); }
+				LA_TARGET_AVX512 static reg set(float s) { return _mm512_set1_ps(s); }
+				LA_TARGET_AVX512 static reg zero() { return _mm512_setzero_ps(); }
+				LA_TARGET_AVX512 static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+				LA_TARGET_AVX512 static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+				LA_TARGET_AVX512 static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+				LA_TARGET_AVX512 static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+				LA_TARGET_AVX512 static reg madd(reg acc, reg a, reg b) { return _mm512_fmadd_ps(a, b, acc); }
+				LA_TARGET_AVX512 static bool differ(reg a, reg b) {
+					return _mm512_cmp_ps_mask(a, b, _CMP_NEQ_UQ) != 0;
+				}
+				LA_TARGET_AVX512 static float sum(reg a) { return _mm512_reduce_add_ps(a); }
+			};
+
+			template<>
+			struct ops<std::int32_t> {
+				using reg = __m512i;
+				static constexpr size_t width = 16;
+				LA_TARGET_AVX512 static reg load(const std::int32_t *p) { return _mm512_loadu_si512(p); }
+				LA_TARGET_AVX512 static void store(std::int32_t *p, reg a) { _mm512_storeu_si512(p, a); }
+				LA_TARGET_AVX512 static reg set(std::int32_t s) { return _mm512_set1_epi32(s); }
+				LA_TARGET_AVX512 static reg zero() { return _mm512_setzero_si512(); }
+				LA_TARGET_AVX512 static reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+				LA_TARGET_AVX512 static reg sub(reg a, reg b) { return _mm512_sub_epi32(a, b); }
+				LA_TARGET_AVX512 static reg mul(reg a, reg b) { return _mm512_mullo_epi32(a, b); }
+				LA_TARGET_AVX512 static reg madd(reg acc, reg a, reg b) { return add(acc, mul(a, b)); }
+				LA_TARGET_AVX512 static bool differ(reg a, reg b) { return _mm512_cmpneq_epi32_mask(a, b) != 0; }
+				LA_TARGET_AVX512 static std::int32_t sum(reg a) { return _mm512_reduce_add_epi32(a); }
+			};
+
+			template<>
+			struct ops<std::int64_t> {
+				using reg = __m512i;
+				static constexpr size_t width = 8;
+				LA_TARGET_AVX512 static reg load(const std::int64_t *p) { return _mm512_loadu_si512(p); }
+				LA_TARGET_AVX512 static void store(std::int64_t *p, reg a) { _mm512_storeu_si512(p, a); }
+				LA_TARGET_AVX512 static reg set(std::int64_t s) { return _mm512_set1_epi64(s); }
+				LA_TARGET_AVX512 static reg zero() { return _mm512_setzero_si512(); }
+				LA_TARGET_AVX512 static reg add(reg a, reg b) { return _mm512_add_epi64(a, b); }
+				LA_TARGET_AVX512 static reg sub(reg a, reg b) { return _mm512_sub_epi64(a, b); }
+				LA_TARGET_AVX512 static reg mul(reg a, reg b) { return _mm512_mullo_epi64(a, b); }
+				LA_TARGET_AVX512 static reg madd(reg acc, reg a, reg b) { return add(acc, mul(a, b)); }
+				LA_TARGET_AVX512 static bool differ(reg a, reg b) { return _mm512_cmpneq_epi64_mask(a, b) != 0; }
+				LA_TARGET_AVX512 static std::int64_t sum(reg a) { return _mm512_reduce_add_epi64(a); }
+			};
+
+			template<typename T>
+			LA_TARGET_AVX512 void add(const T *a, const T *b, T *dst, size_t n) noexcept {
+				using op = ops<T>;
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					op::store(dst + i, op::add(op::load(a + i), op::load(b + i)));
+				}
+				scalar::add(a + i, b + i, dst + i, n - i);
+			}
+
+			template<typename T>
+			LA_TARGET_AVX512 void sub(const T *a, const T *b, T *dst, size_t n) noexcept {
+				using op = ops<T>;
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					op::store(dst + i, op::sub(op::load(a + i), op::load(b + i)));
+				}
+				scalar::sub(a + i, b + i, dst + i, n - i);
+			}
+
+			template<typename T>
+			LA_TARGET_AVX512 void scale(const T *a, T s, T *dst, size_t n) noexcept {
+				using op = ops<T>;
+				typename op::reg factor = op::set(s);
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					op::store(dst + i, op::mul(op::load(a + i), factor));
+				}
+				scalar::scale(a + i, s, dst + i, n - i);
+			}
+
+			template<typename T>
+			LA_TARGET_AVX512 void divide(const T *a, T s, T *dst, size_t n) noexcept {
+				using op = ops<T>;
+				typename op::reg divisor = op::set(s);
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					op::store(dst + i, op::div(op::load(a + i), divisor));
+				}
+				scalar::divide(a + i, s, dst + i, n - i);
+			}
+
+			template<typename T>
+			LA_TARGET_AVX512 void axpy(const T *a, T s, T *dst, size_t n) noexcept {
+				using op = ops<T>;
+				typename op::reg factor = op::set(s);
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					op::store(dst + i, op::madd(op::load(dst + i), op::load(a + i), factor));
+				}
+				scalar::axpy(a + i, s, dst + i, n - i);
+			}
+
+			template<typename T>
+			LA_TARGET_AVX512 T dot(const T *a, const T *b, size_t n) noexcept {
+				using op = ops<T>;
+				typename op::reg acc0 = op::zero(), acc1 = op::zero(), acc2 = op::zero(), acc3 = op::zero();
+				size_t i = 0;
+				for (; i + 4 * op::width <= n; i += 4 * op::width) {
+					acc0 = op::madd(acc0, op::load(a + i), op::load(b + i));
+					acc1 = op::madd(acc1, op::load(a + i + op::width), op::load(b + i + op::width));
+					acc2 = op::madd(acc2, op::load(a + i + 2 * op::width), op::load(b + i + 2 * op::width));
+					acc3 = op::madd(acc3, op::load(a + i + 3 * op::width), op::load(b + i + 3 * op::width));
+				}
+				for (; i + op::width <= n; i += op::width) {
+					acc0 = op::madd(acc0, op::load(a + i), op::load(b + i));
+				}
+				acc0 = op::add(op::add(acc0, acc1), op::add(acc2, acc3));
+				return op::sum(acc0) + scalar::dot(a + i, b + i, n - i);
+			}
+
+			template<typename T>
+			LA_TARGET_AVX512 bool equal(const T *a, const T *b, size_t n) noexcept {
+				using op = ops<T>;
+				size_t i = 0;
+				for (; i + op::width <= n; i += op::width) {
+					if (op::differ(op::load(a + i), op::load(b + i))) { return false; }
+				}
+				return scalar::equal(a + i, b + i, n - i);
+			}
+
+			// The portable batch kernels compiled for 512 bit registers
+			template<typename T, size_t N>
+			LA_TARGET_AVX512 LA_FLATTEN void batch_determinant(const T *a, T *det, size_t blocks) noexcept {
+				detail::determinant_blocks<T, N>(a, det, blocks);
+			}
+
+			template<typename T, size_t N>
+			LA_TARGET_AVX512 LA_FLATTEN void batch_invert(const T *a, T *inv, T *det, size_t blocks) noexcept {
+				detail::invert_blocks<T, N>(a, inv, det, blocks);
+			}
+
+			template<typename T, size_t N>
+			LA_TARGET_AVX512 LA_FLATTEN void batch_multiply(const T *a, const T *b, T *c, size_t blocks) noexcept {
+				detail::multiply_blocks<T, N, N, N>(a, b, c, blocks);
+			}
+
+			// Micro kernel of gemm: every row of the tile is one register. Even and
+			// odd steps of the inner dimension go to separate accumulators, twelve
+			// of them like the 256 bit kernel, and are added at the end.
+			template<typename T>
+			LA_TARGET_AVX512 void gemm_kernel(size_t kc, const T *a, const T *b, T *acc) noexcept {
+				using op = ops<T>;
+				using reg = typename op::reg;
+				constexpr size_t w = op::width;
+				static_assert(gemm_blocking<T>::mr == 6 && gemm_blocking<T>::nr == w,
+					"Kernel does not match the blocking of gemm.");
+
+				reg c0 = op::zero(), c1 = op::zero(), c2 = op::zero(), c3 = op::zero(), c4 = op::zero(), c5 = op::zero();
+				reg d0 = op::zero(), d1 = op::zero(), d2 = op::zero(), d3 = op::zero(), d4 = op::zero(), d5 = op::zero();
+				size_t p = 0;
+				for (; p + 2 <= kc; p += 2) {
+					reg b0 = op::load(b), b1 = op::load(b + w);
+					c0 = op::madd(c0, op::set(a[0]), b0);
+					c1 = op::madd(c1, op::set(a[1]), b0);
+					c2 = op::madd(c2, op::set(a[2]), b0);
+					c3 = op::madd(c3, op::set(a[3]), b0);
+					c4 = op::madd(c4, op::set(a[4]), b0);
+					c5 = op::madd(c5, op::set(a[5]), b0);
+					d0 = op::madd(d0, op::set(a[6]), b1);
+					d1 = op::madd(d1, op::set(a[7]), b1);
+					d2 = op::madd(d2, op::set(a[8]), b1);
+					d3 = op::madd(d3, op::set(a[9]), b1);
+					d4 = op::madd(d4, op::set(a[10]), b1);
+					d5 = op::madd(d5, op::set(a[11]), b1);
+					a += 12;
+					b += 2 * w;
+				}
+				if (p < kc) {
+					reg b0 = op::load(b);
+					c0 = op::madd(c0, op::set(a[0]), b0);
+					c1 = op::madd(c1, op::set(a[1]), b0);
+					c2 = op::madd(c2, op::set(a[2]), b0);
+					c3 = op::madd(c3, op::set(a[3]), b0);
+					c4 = op::madd(c4, op::set(a[4]), b0);
+					c5 = op::madd(c5, op::set(a[5]), b0);
+				}
+
+				op::store(acc, op::add(c0, d0));
+				op::store(acc + w, op::add(c1, d1));
+				op::store(acc + 2 * w, op::add(c2, d2));
+				op::store(acc + 3 * w, op::add(c3, d3));
+				op::store(acc + 4 * w, op::add(c4, d4));
+				op::store(acc + 5 * w, op::add(c5, d5));
+			}
+		}
+#endif
+
+		// Query CPUID and the operating system for the widest usable instruction set
+		simd_level detect() noexcept {
+#ifdef LA_SIMD_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7) { return simd_level::scalar; }
+
+			__cpuid(info, 1);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool fma = (info[2] & (1 << 12)) != 0;
+			if (!osxsave) { return simd_level::scalar; }
+
+			// The operating system has to save the YMM and ZMM registers
+			unsigned long long xcr0 = _xgetbv(0);
+			bool ymm = (xcr0 & 0x6) == 0x6;
+			bool zmm = (xcr0 & 0xE6) == 0xE6;
+
+			__cpuidex(info, 7, 0);
+			bool avx2 = (info[1] & (1 << 5)) != 0;
+			bool avx512 = (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 17)) != 0;
+
+			if (zmm && avx512) { return simd_level::avx512; }
+			if (ymm && avx2 && fma) { return simd_level::avx2; }
+#else
+			// Also checks that the operating system saves the wide registers
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+				return simd_level::avx512;
+			}
+			if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+				return simd_level::avx2;
+			}
+#endif
+#endif
+			return simd_level::scalar;
+		}
+
+		const simd_level g_detected = detect();
+		std::atomic<simd_level> g_level{ g_detected };
+
+		// Select the kernel of the current instruction set
+#ifdef LA_SIMD_X86
+#define LA_SIMD_DISPATCH(kernel, ...) \
+		switch (simd_support()) { \
+		case simd_level::avx512: return avx512::kernel(__VA_ARGS__); \
+		case simd_level::avx2: return avx2::kernel(__VA_ARGS__); \
+		default: return scalar::kernel(__VA_ARGS__); \
+		}
+#else
+#define LA_SIMD_DISPATCH(kernel, ...) return scalar::kernel(__VA_ARGS__);
+#endif
+	}
+
+	simd_level simd_support() noexcept {
+		return g_level.load(std::memory_order_relaxed);
+	}
+
+	void simd_restrict(simd_level level) noexcept {
+		g_level = std::min(level, g_detected);
+	}
+
+	const char* simd_name(simd_level level) noexcept {
+		switch (level) {
+		case simd_level::avx512: return "AVX-512";
+		case simd_level::avx2: return "AVX2";
+		default: return "scalar";
+		}
+	}
+
+	void simd_add(const float *a, const float *b, float *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(add, a, b, dst, n)
+	}
+
+	void simd_add(const double *a, const double *b, double *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(add, a, b, dst, n)
+	}
+
+	void simd_add(const std::int32_t *a, const std::int32_t *b, std::int32_t *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(add, a, b, dst, n)
+	}
+
+	void simd_add(const std::int64_t *a, const std::int64_t *b, std::int64_t *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(add, a, b, dst, n)
+	}
+
+	void simd_sub(const float *a, const float *b, float *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(sub, a, b, dst, n)
+	}
+
+	void simd_sub(const double *a, const double *b, double *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(sub, a, b, dst, n)
+	}
+
+	void simd_sub(const std::int32_t *a, const std::int32_t *b, std::int32_t *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(sub, a, b, dst, n)
+	}
+
+	void simd_sub(const std::int64_t *a, const std::int64_t *b, std::int64_t *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(sub, a, b, dst, n)
+	}
+
+	void simd_scale(const float *a, float s, float *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(scale, a, s, dst, n)
+	}
+
+	void simd_scale(const double *a, double s, double *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(scale, a, s, dst, n)
+	}
+
+	void simd_scale(const std::int32_t *a, std::int32_t s, std::int32_t *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(scale, a, s, dst, n)
+	}
+
+	void simd_scale(const std::int64_t *a, std::int64_t s, std::int64_t *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(scale, a, s, dst, n)
+	}
+
+	void simd_divide(const float *a, float s, float *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(divide, a, s, dst, n)
+	}
+
+	void simd_divide(const double *a, double s, double *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(divide, a, s, dst, n)
+	}
+
+	void simd_axpy(const float *a, float s, float *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(axpy, a, s, dst, n)
+	}
+
+	void simd_axpy(const double *a, double s, double *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(axpy, a, s, dst, n)
+	}
+
+	void simd_axpy(const std::int32_t *a, std::int32_t s, std::int32_t *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(axpy, a, s, dst, n)
+	}
+
+	void simd_axpy(const std::int64_t *a, std::int64_t s, std::int64_t *dst, size_t n) noexcept {
+		LA_SIMD_DISPATCH(axpy, a, s, dst, n)
+	}
+
+	float simd_dot(const float *a, const float *b, size_t n) noexcept {
+		LA_SIMD_DISPATCH(dot, a, b, n)
+	}
+
+	double simd_dot(const double *a, const double *b, size_t n) noexcept {
+		LA_SIMD_DISPATCH(dot, a, b, n)
+	}
+
+	std::int32_t simd_dot(const std::int32_t *a, const std::int32_t *b, size_t n) noexcept {
+		LA_SIMD_DISPATCH(dot, a, b, n)
+	}
+
+	std::int64_t simd_dot(const std::int64_t *a, const std::int64_t *b, size_t n) noexcept {
+		LA_SIMD_DISPATCH(dot, a, b, n)
+	}
+
+	bool simd_equal(const float *a, const float *b, size_t n) noexcept {
+		LA_SIMD_DISPATCH(equal, a, b, n)
+	}
+
+	bool simd_equal(const double *a, const double *b, size_t n) noexcept {
+		LA_SIMD_DISPATCH(equal, a, b, n)
+	}
+
+	bool simd_equal(const std::int32_t *a, const std::int32_t *b, size_t n) noexcept {
+		LA_SIMD_DISPATCH(equal, a, b, n)
+	}
+
+	bool simd_equal(const std::int64_t *a, const std::int64_t *b, size_t n) noexcept {
+		LA_SIMD_DISPATCH(equal, a, b, n)
+	}
+
+	void simd_gemm_kernel(size_t kc, const float *a, const float *b, float *acc) noexcept {
+#ifdef LA_SIMD_X86
+		switch (simd_support()) {
+		case simd_level::avx512: return avx512::gemm_kernel(kc, a, b, acc);
+		case simd_level::avx2: return avx2::gemm_kernel(kc, a, b, acc);
+		default: break;
+		}
+#endif
+		gemm_micro_kernel(kc, a, b, acc);
+	}
+
+	void simd_gemm_kernel(size_t kc, const double *a, const double *b, double *acc) noexcept {
+#ifdef LA_SIMD_X86
+		switch (simd_support()) {
+		case simd_level::avx512: return avx512::gemm_kernel(kc, a, b, acc);
+		case simd_level::avx2: return avx2::gemm_kernel(kc, a, b, acc);
+		default: break;
+		}
+#endif
+		gemm_micro_kernel(kc, a, b, acc);
+	}
+
+	template<typename T, size_t N>
+	void simd_batch_determinant(const T *a, T *det, size_t blocks) noexcept {
+#ifdef LA_SIMD_X86
+		switch (simd_support()) {
+		case simd_level::avx512: return avx512::batch_determinant<T, N>(a, det, blocks);
+		case simd_level::avx2: return avx2::batch_determinant<T, N>(a, det, blocks);
+		default: break;
+		}
+#endif
+		detail::determinant_blocks<T, N>(a, det, blocks);
+	}
+
+	template<typename T, size_t N>
+	void simd_batch_invert(const T *a, T *inv, T *det, size_t blocks) noexcept {
+#ifdef LA_SIMD_X86
+		switch (simd_support()) {
+		case simd_level::avx512: return avx512::batch_invert<T, N>(a, inv, det, blocks);
+		case simd_level::avx2: return avx2::batch_invert<T, N>(a, inv, det, blocks);
+		default: break;
+		}
+#endif
+		detail::invert_blocks<T, N>(a, inv, det, blocks);
+	}
+
+	template<typename T, size_t N>
+	void simd_batch_multiply(const T *a, const T *b, T *c, size_t blocks) noexcept {
+#ifdef LA_SIMD_X86
+		switch (simd_support()) {
+		case simd_level::avx512: return avx512::batch_multiply<T, N>(a, b, c, blocks);
+		case simd_level::avx2: return avx2::batch_multiply<T, N>(a, b, c, blocks);
+		default: break;
+		}
+#endif
+		detail::multiply_blocks<T, N, N, N>(a, b, c, blocks);
+	}
+
+	// Batch kernels for all sizes with closed-form formulas
+#define LA_SIMD_BATCH_KERNELS(T, N) \
+	template void simd_batch_determinant<T, N>(const T *, T *, size_t) noexcept; \
+	template void simd_batch_invert<T, N>(const T *, T *, T *, size_t) noexcept; \
+	template void simd_batch_multiply<T, N>(const T *, const T *, T *, size_t) noexcept;
+
+	LA_SIMD_BATCH_KERNELS(float, 1)
+	LA_SIMD_BATCH_KERNELS(float, 2)
+	LA_SIMD_BATCH_KERNELS(float, 3)
+	LA_SIMD_BATCH_KERNELS(float, 4)
+	LA_SIMD_BATCH_KERNELS(double, 1)
+	LA_SIMD_BATCH_KERNELS(double, 2)
+	LA_SIMD_BATCH_KERNELS(double, 3)
+	LA_SIMD_BATCH_KERNELS(double, 4)
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace la {
+	// Instruction sets used by the SIMD kernels, ordered by width
+	enum class simd_level {
+		scalar,
+		avx2,
+		avx512
+	};
+
+	// Instruction set the kernels currently use. It is detected once by CPUID so
+	// a single binary runs at full width on every x86 host, other platforms
+	// always use the scalar kernels.
+	simd_level simd_support() noexcept;
+	// Use at most the given instruction set, e.g. to compare against the scalar
+	// kernels. Levels the CPU does not support are ignored.
+	void simd_restrict(simd_level) noexcept;
+	// Name of an instruction set for reports
+	const char* simd_name(simd_level) noexcept;
+
+	// Elementwise kernels over n entries, dst may be the same as an input
+	// dst[i] = a[i] + b[i]
+	void simd_add(const float *, const float *, float *, size_t) noexcept;
+	void simd_add(const double *, const double *, double *, size_t) noexcept;
+	void simd_add(const std::int32_t *, const std::int32_t *, std::int32_t *, size_t) noexcept;
+	void simd_add(const std::int64_t *, const std::int64_t *, std::int64_t *, size_t) noexcept;
+	// dst[i] = a[i] - b[i]
+	void simd_sub(const float *, const float *, float *, size_t) noexcept;
+	void simd_sub(const double *, const double *, double *, size_t) noexcept;
+	void simd_sub(const std::int32_t *, const std::int32_t *, std::int32_t *, size_t) noexcept;
+	void simd_sub(const std::int64_t *, const std::int64_t *, std::int64_t *, size_t) noexcept;
+	// dst[i] = a[i] * s
+	void simd_scale(const float *, float, float *, size_t) noexcept;
+	void simd_scale(const double *, double, double *, size_t) noexcept;
+	void simd_scale(const std::int32_t *, std::int32_t, std::int32_t *, size_t) noexcept;
+	void simd_scale(const std::int64_t *, std::int64_t, std::int64_t *, size_t) noexcept;
+	// dst[i] = a[i] / s, integer division has no SIMD instructions
+	void simd_divide(const float *, float, float *, size_t) noexcept;
+	void simd_divide(const double *, double, double *, size_t) noexcept;
+	// dst[i] += a[i] * s
+	void simd_axpy(const float *, float, float *, size_t) noexcept;
+	void simd_axpy(const double *, double, double *, size_t) noexcept;
+	void simd_axpy(const std::int32_t *, std::int32_t, std::int32_t *, size_t) noexcept;
+	void simd_axpy(const std::int64_t *, std::int64_t, std::int64_t *, size_t) noexcept;
+
+	// Reductions over n entries
+	// Sum of a[i] * b[i], summed in a different order than a scalar loop
+	float simd_dot(const float *, const float *, size_t) noexcept;
+	double simd_dot(const double *, const double *, size_t) noexcept;
+	std::int32_t simd_dot(const std::int32_t *, const std::int32_t *, size_t) noexcept;
+	std::int64_t simd_dot(const std::int64_t *, const std::int64_t *, size_t) noexcept;
+	// Check if a[i] == b[i] for all i
+	bool simd_equal(const float *, const float *, size_t) noexcept;
+	bool simd_equal(const double *, const double *, size_t) noexcept;
+	bool simd_equal(const std::int32_t *, const std::int32_t *, size_t) noexcept;
+	bool simd_equal(const std::int64_t *, const std::int64_t *, size_t) noexcept;
+
+	// Kernels of la::matrix_batch on consecutive blocks of interleaved N x N
+	// matrices, N <= 4, for float and double
+	// det[k] = determinant of matrix k
+	template<typename T, size_t N>
+	void simd_batch_determinant(const T *, T *, size_t) noexcept;
+	// Inverses and determinants, singular matrices are not scaled at all
+	template<typename T, size_t N>
+	void simd_batch_invert(const T *, T *, T *, size_t) noexcept;
+	// Pairwise products
+	template<typename T, size_t N>
+	void simd_batch_multiply(const T *, const T *, T *, size_t) noexcept;
+
+	// Micro kernel of la::gemm for float and double, the product of a packed
+	// mr x kc sliver of A and a packed kc x nr sliver of B, see
+	// gemm_micro_kernel
+	void simd_gemm_kernel(size_t, const float *, const float *, float *) noexcept;
+	void simd_gemm_kernel(size_t, const double *, const double *, double *) noexcept;
+
+	// Check if there are gemm kernels for T
+	template<typename T>
+	constexpr bool simd_gemm_supported_v = std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+	// Check if there are batch kernels for T
+	template<typename T>
+	constexpr bool simd_batch_supported_v = std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+	// Integral types of 32 or 64 bit use the kernels of the signed type of that
+	// width, wrap-around addition and multiplication are the same for both
+	template<typename T, typename = void>
+	struct simd_kernel {
+		using type = void;
+	};
+
+	template<typename T>
+	struct simd_kernel<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+		using type = std::conditional_t<std::is_same_v<T, float> || std::is_same_v<T, double>, T, void>;
+	};
+
+	template<typename T>
+	struct simd_kernel<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+		using type = std::conditional_t<std::is_same_v<std::make_signed_t<T>, std::int32_t>
+			|| std::is_same_v<std::make_signed_t<T>, std::int64_t>, std::make_signed_t<T>, void>;
+	};
+
+	template<typename T>
+	using simd_kernel_t = typename simd_kernel<T>::type;
+
+	// Check if there are SIMD kernels for T
+	template<typename T>
+	constexpr bool simd_supported_v = !std::is_void_v<simd_kernel_t<T>>;
+
+	// Forward unsigned types to the kernels of the signed type
+	template<typename T, typename K = simd_kernel_t<T>>
+	void simd_add(const T *a, const T *b, T *dst, size_t n) noexcept {
+		simd_add(reinterpret_cast<const K *>(a), reinterpret_cast<const K *>(b),
+			reinterpret_cast<K *>(dst), n);
+	}
+
+	template<typename T, typename K = simd_kernel_t<T>>
+	void simd_sub(const T *a, const T *b, T *dst, size_t n) noexcept {
+		simd_sub(reinterpret_cast<const K *>(a), reinterpret_cast<const K *>(b),
+			reinterpret_cast<K *>(dst), n);
+	}
+
+	template<typename T, typename K = simd_kernel_t<T>>
+	void simd_scale(const T *a, T s, T *dst, size_t n) noexcept {
+		simd_scale(reinterpret_cast<const K *>(a), static_cast<K>(s), reinterpret_cast<K *>(dst), n);
+	}
+
+	template<typename T, typename K = simd_kernel_t<T>>
+	void simd_axpy(const T *a, T s, T *dst, size_t n) noexcept {
+		simd_axpy(reinterpret_cast<const K *>(a), static_cast<K>(s), reinterpret_cast<K *>(dst), n);
+	}
+
+	template<typename T, typename K = simd_kernel_t<T>>
+	T simd_dot(const T *a, const T *b, size_t n) noexcept {
+		return static_cast<T>(simd_dot(reinterpret_cast<const K *>(a), reinterpret_cast<const K *>(b), n));
+	}
+
+	template<typename T, typename K = simd_kernel_t<T>>
+	bool simd_equal(const T *a, const T *b, size_t n) noexcept {
+		return simd_equal(reinterpret_cast<const K *>(a), reinterpret_cast<const K *>(b), n);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,409 @@
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Matrix.hpp"
+#include "ThreadPool.hpp"
+#include "Vector.hpp"
+
+namespace la {
+	// Sparse matrix in compressed sparse row (CSR) form. Only the nonzero entries
+	// are stored: the entries of row i are m_values[m_rowStart[i], m_rowStart[i + 1])
+	// and lie in the columns m_columnIndex[...] of the same range, sorted
+	// ascending. Memory is proportional to the amount of nonzero entries so
+	// operators with hundreds of thousands of rows fit easily.
+	template<typename T = double>
+	class sparse_matrix {
+	public:
+		// Single entry used to build a matrix
+		struct triplet {
+			size_t row;
+			size_t column;
+			T value;
+		};
+
+		// Compressed sparse column (CSC) form of the same matrix. The entries of
+		// column j are values[columnStart[j], columnStart[j + 1]) and lie in the
+		// rows rowIndex[...] of the same range, sorted ascending.
+		struct compressed_columns {
+			std::vector<size_t> columnStart;
+			std::vector<size_t> rowIndex;
+			std::vector<T> values;
+		};
+
+	private:
+		// Dimensions for the matrix
+		size_t m_rows = 0, m_cols = 0;
+
+		// CSR storage, m_rowStart has m_rows + 1 entries
+		std::vector<size_t> m_rowStart;
+		std::vector<size_t> m_columnIndex;
+		std::vector<T> m_values;
+
+		// Rows per task so every task gets about the same amount of nonzeros
+		size_t rows_per_task() const noexcept;
+
+	public:
+		// Constructors
+
+		// Default constructor
+		sparse_matrix() = default;
+		// Construct matrix of given dimensions without any nonzero entries
+		// Throws std::logic_error for zero dimensions
+		sparse_matrix(size_t, size_t);
+		// Construct matrix of given dimensions from entries in any order,
+		// entries at the same position are summed up
+		// Throws std::out_of_range if an entry lies outside the dimensions
+		sparse_matrix(size_t, size_t, const std::vector<triplet> &);
+		// Convert dense matrix, entries equal to 0 are dropped
+		explicit sparse_matrix(const matrix<T> &);
+
+		// Getter for the dimensions
+		size_t rows() const noexcept;
+		size_t columns() const noexcept;
+		size_t nonzeros() const noexcept;
+		// Raw CSR storage for kernels
+		const std::vector<size_t>& row_start() const noexcept;
+		const std::vector<size_t>& column_index() const noexcept;
+		const std::vector<T>& values() const noexcept;
+
+		// Conversions
+		matrix<T> dense() const;
+		compressed_columns csc() const;
+		sparse_matrix transpose() const;
+
+		// Overloaded operators
+
+		// Access operator, returns 0 for entries that are not stored
+		// Throws std::out_of_range for invalid indices
+		T operator()(size_t, size_t) const;
+
+		// Arithmetic operators (may be multithreaded)
+		// Throw std::runtime_error if the dimensions do not match
+		vector<T> operator*(const vector<T> &) const;
+		matrix<T> operator*(const matrix<T> &) const;
+		sparse_matrix operator*(const sparse_matrix &) const;
+
+		// Comparison operators
+		bool operator==(const sparse_matrix &) const noexcept;
+		bool operator!=(const sparse_matrix &) const noexcept;
+	};
+
+	// Create empty matrix of given dimensions
+	template<typename T>
+	sparse_matrix<T>::sparse_matrix(size_t rows, size_t cols)
+		: m_rows(rows), m_cols(cols), m_rowStart(rows + 1, 0) {
+		if (m_cols == 0 || m_rows == 0) {
+			throw std::logic_error("Matrix does not allow zero dimensions.");
+		}
+	}
+
+	// Create matrix from triplets: bucket them by row, then sort every row by
+	// column and merge duplicates
+	template<typename T>
+	sparse_matrix<T>::sparse_matrix(size_t rows, size_t cols, const std::vector<triplet> &entries)
+		: sparse_matrix(rows, cols) {
+		for (const auto &t : entries) {
+			if (t.row >= m_rows || t.column >= m_cols) {
+				throw std::out_of_range("Exceeded matrix range.");
+			}
+			m_rowStart[t.row + 1]++;
+		}
+		std::partial_sum(m_rowStart.begin(), m_rowStart.end(), m_rowStart.begin());
+
+		std::vector<std::pair<size_t, T>> bucket(entries.size());
+		std::vector<size_t> next(m_rowStart.begin(), m_rowStart.end() - 1);
+		for (const auto &t : entries) {
+			bucket[next[t.row]++] = { t.column, t.value };
+		}
+
+		m_columnIndex.reserve(entries.size());
+		m_values.reserve(entries.size());
+		size_t begin = 0;
+		for (size_t i = 0; i < m_rows; i++) {
+			size_t end = m_rowStart[i + 1];
+			std::sort(bucket.begin() + begin, bucket.begin() + end,
+				[](const auto &a, const auto &b) { return a.first < b.first; });
+
+			m_rowStart[i] = m_values.size();
+			for (size_t p = begin; p < end; p++) {
+				if (p != begin && bucket[p].first == m_columnIndex.back()) {
+					m_values.back() += bucket[p].second;
+				}
+				else {
+					m_columnIndex.push_back(bucket[p].first);
+					m_values.push_back(bucket[p].second);
+				}
+			}
+			begin = end;
+		}
+		m_rowStart[m_rows] = m_values.size();
+	}
+
+	// Create matrix from the nonzero entries of a dense matrix
+	template<typename T>
+	sparse_matrix<T>::sparse_matrix(const matrix<T> &m)
+		: sparse_matrix(m.rows(), m.columns()) {
+		const T *a = m.data();
+		for (size_t i = 0; i < m_rows; i++) {
+			for (size_t j = 0; j < m_cols; j++) {
+				if (a[i * m_cols + j] != T(0)) {
+					m_columnIndex.push_back(j);
+					m_values.push_back(a[i * m_cols + j]);
+				}
+			}
+			m_rowStart[i + 1] = m_values.size();
+		}
+	}
+
+	// Split rows so that a task handles about minEntriesPerTask nonzeros
+	template<typename T>
+	size_t sparse_matrix<T>::rows_per_task() const noexcept {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		return std::max<size_t>(minEntriesPerTask * m_rows / std::max<size_t>(nonzeros(), 1), 1);
+	}
+
+	// Getter for rows
+	template<typename T>
+	size_t sparse_matrix<T>::rows() const noexcept {
+		return m_rows;
+	}
+
+	// Getter for columns
+	template<typename T>
+	size_t sparse_matrix<T>::columns() const noexcept {
+		return m_cols;
+	}
+
+	// Getter for the amount of stored entries
+	template<typename T>
+	size_t sparse_matrix<T>::nonzeros() const noexcept {
+		return m_values.size();
+	}
+
+	// Getter for the row offsets
+	template<typename T>
+	const std::vector<size_t>& sparse_matrix<T>::row_start() const noexcept {
+		return m_rowStart;
+	}
+
+	// Getter for the column indices
+	template<typename T>
+	const std::vector<size_t>& sparse_matrix<T>::column_index() const noexcept {
+		return m_columnIndex;
+	}
+
+	// Getter for the stored values
+	template<typename T>
+	const std::vector<T>& sparse_matrix<T>::values() const noexcept {
+		return m_values;
+	}
+
+	// Expand into a dense matrix
+	template<typename T>
+	matrix<T> sparse_matrix<T>::dense() const {
+		matrix<T> m(m_rows, m_cols);
+		T *a = m.data();
+		for (size_t i = 0; i < m_rows; i++) {
+			for (size_t p = m_rowStart[i]; p < m_rowStart[i + 1]; p++) {
+				a[i * m_cols + m_columnIndex[p]] = m_values[p];
+			}
+		}
+		return m;
+	}
+
+	// Convert to CSC by counting the entries per column and scattering the rows
+	// in order, which leaves every column sorted by row
+	template<typename T>
+	typename sparse_matrix<T>::compressed_columns sparse_matrix<T>::csc() const {
+		compressed_columns c;
+		c.columnStart.assign(m_cols + 1, 0);
+		c.rowIndex.resize(nonzeros());
+		c.values.resize(nonzeros());
+
+		for (size_t j : m_columnIndex) {
+			c.columnStart[j + 1]++;
+		}
+		std::partial_sum(c.columnStart.begin(), c.columnStart.end(), c.columnStart.begin());
+
+		std::vector<size_t> next(c.columnStart.begin(), c.columnStart.end() - 1);
+		for (size_t i = 0; i < m_rows; i++) {
+			for (size_t p = m_rowStart[i]; p < m_rowStart[i + 1]; p++) {
+				size_t q = next[m_columnIndex[p]]++;
+				c.rowIndex[q] = i;
+				c.values[q] = m_values[p];
+			}
+		}
+		return c;
+	}
+
+	// The CSC form of a matrix is the CSR form of its transpose
+	template<typename T>
+	sparse_matrix<T> sparse_matrix<T>::transpose() const {
+		compressed_columns c = csc();
+
+		sparse_matrix<T> m;
+		m.m_rows = m_cols;
+		m.m_cols = m_rows;
+		m.m_rowStart = std::move(c.columnStart);
+		m.m_columnIndex = std::move(c.rowIndex);
+		m.m_values = std::move(c.values);
+		return m;
+	}
+
+	// Find entry by binary search in its row
+	template<typename T>
+	T sparse_matrix<T>::operator()(size_t i, size_t j) const {
+		// Check for valid argument
+		if (i >= m_rows || j >= m_cols) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+
+		auto first = m_columnIndex.begin() + m_rowStart[i];
+		auto last = m_columnIndex.begin() + m_rowStart[i + 1];
+		auto it = std::lower_bound(first, last, j);
+		if (it == last || *it != j) { return T(0); }
+		return m_values[it - m_columnIndex.begin()];
+	}
+
+	// Multiply matrix by vector, every row is an independent dot product
+	template<typename T>
+	vector<T> sparse_matrix<T>::operator*(const vector<T> &other) const {
+		// Check for valid argument
+		if (m_cols != other.size()) {
+			throw std::runtime_error("Can not multiply by a vector which dimension does not match the columns of the matrix.");
+		}
+
+		vector<T> v(m_rows);
+		T *y = &v[0];
+		thread_pool::instance().parallel_for(0, m_rows, rows_per_task(),
+			[this, &other, y](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				T sum(0);
+				for (size_t p = m_rowStart[i]; p < m_rowStart[i + 1]; p++) {
+					sum += m_values[p] * other.eval(m_columnIndex[p]);
+				}
+				y[i] = sum;
+			}
+		});
+		return v;
+	}
+
+	// Multiply matrix by dense matrix, every row of the result is a linear
+	// combination of rows of the dense matrix
+	template<typename T>
+	matrix<T> sparse_matrix<T>::operator*(const matrix<T> &other) const {
+		// Check for valid argument
+		if (m_cols != other.rows()) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not match the columns of the original matrix.");
+		}
+
+		size_t cols = other.columns();
+		matrix<T> m(m_rows, cols);
+		const T *b = other.data();
+		T *c = m.data();
+		thread_pool::instance().parallel_for(0, m_rows, std::max<size_t>(rows_per_task() / cols, 1),
+			[this, b, c, cols](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				T *row = c + i * cols;
+				for (size_t p = m_rowStart[i]; p < m_rowStart[i + 1]; p++) {
+					const T a_ik = m_values[p];
+					const T *b_k = b + m_columnIndex[p] * cols;
+					for (size_t j = 0; j < cols; j++) {
+						row[j] += a_ik * b_k[j];
+					}
+				}
+			}
+		});
+		return m;
+	}
+
+	// Multiply two sparse matrices with Gustavson's algorithm. A first pass
+	// counts the nonzeros of every result row so the second pass can fill all
+	// rows in parallel directly into the final storage.
+	template<typename T>
+	sparse_matrix<T> sparse_matrix<T>::operator*(const sparse_matrix<T> &other) const {
+		// Check for valid argument
+		if (m_cols != other.m_rows) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not match the columns of the original matrix.");
+		}
+
+		const size_t unused = static_cast<size_t>(-1);
+		size_t cols = other.m_cols;
+		size_t rowsPerTask = rows_per_task();
+
+		sparse_matrix<T> m(m_rows, cols);
+		thread_pool::instance().parallel_for(0, m_rows, rowsPerTask,
+			[this, &other, &m, cols, unused](size_t first, size_t last) {
+			// marker[j] is the last row that touched column j
+			std::vector<size_t> marker(cols, unused);
+			for (size_t i = first; i < last; i++) {
+				size_t count = 0;
+				for (size_t p = m_rowStart[i]; p < m_rowStart[i + 1]; p++) {
+					size_t k = m_columnIndex[p];
+					for (size_t q = other.m_rowStart[k]; q < other.m_rowStart[k + 1]; q++) {
+						size_t j = other.m_columnIndex[q];
+						if (marker[j] != i) {
+							marker[j] = i;
+							count++;
+						}
+					}
+				}
+				m.m_rowStart[i + 1] = count;
+			}
+		});
+		std::partial_sum(m.m_rowStart.begin(), m.m_rowStart.end(), m.m_rowStart.begin());
+
+		m.m_columnIndex.resize(m.m_rowStart[m_rows]);
+		m.m_values.resize(m.m_rowStart[m_rows]);
+		thread_pool::instance().parallel_for(0, m_rows, rowsPerTask,
+			[this, &other, &m, cols, unused](size_t first, size_t last) {
+			// Dense accumulator for the current row
+			std::vector<size_t> marker(cols, unused);
+			std::vector<T> sum(cols);
+			for (size_t i = first; i < last; i++) {
+				size_t begin = m.m_rowStart[i];
+				size_t end = begin;
+				for (size_t p = m_rowStart[i]; p < m_rowStart[i + 1]; p++) {
+					const T a_ik = m_values[p];
+					size_t k = m_columnIndex[p];
+					for (size_t q = other.m_rowStart[k]; q < other.m_rowStart[k + 1]; q++) {
+						size_t j = other.m_columnIndex[q];
+						if (marker[j] != i) {
+							marker[j] = i;
+							m.m_columnIndex[end++] = j;
+							sum[j] = a_ik * other.m_values[q];
+						}
+						else {
+							sum[j] += a_ik * other.m_values[q];
+						}
+					}
+				}
+
+				std::sort(m.m_columnIndex.begin() + begin, m.m_columnIndex.begin() + end);
+				for (size_t p = begin; p < end; p++) {
+					m.m_values[p] = sum[m.m_columnIndex[p]];
+				}
+			}
+		});
+		return m;
+	}
+
+	// Check two matrices for equal structure and values
+	template<typename T>
+	bool sparse_matrix<T>::operator==(const sparse_matrix<T> &other) const noexcept {
+		return m_rows == other.m_rows && m_cols == other.m_cols && m_rowStart == other.m_rowStart
+			&& m_columnIndex == other.m_columnIndex && m_values == other.m_values;
+	}
+
+	// Check two matrices for inequality
+	template<typename T>
+	bool sparse_matrix<T>::operator!=(const sparse_matrix<T> &other) const noexcept {
+		return !(*this == other);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "Gemm.hpp"
+#include "Matrix.hpp"
+#include "ThreadPool.hpp"
+
+namespace la {
+	// Dimension up to which the Strassen-Winograd recursion hands sub-products to
+	// the classical kernel. Below roughly this size the saved multiplication does
+	// not pay for the 15 additions of a level.
+	constexpr size_t strassen_crossover = 256;
+
+	// The recursion works on n x n blocks addressed by a pointer and a row stride.
+	// Every level splits them into quadrants X11, X12, X21 and X22 and computes
+	//   S1 = A21 + A22, S2 = S1 - A11, S3 = A11 - A21, S4 = A12 - S2
+	//   T1 = B12 - B11, T2 = B22 - T1, T3 = B22 - B12, T4 = T2 - B21
+	//   P1 = A11 * B11, P2 = A12 * B21, P3 = S4 * B22, P4 = A22 * T4
+	//   P5 = S1 * T1, P6 = S2 * T2, P7 = S3 * T3
+	//   C11 = P1 + P2, C12 = P1 + P6 + P5 + P3
+	//   C21 = P1 + P6 + P7 - P4, C22 = P1 + P6 + P7 + P5
+
+	// Elementwise c = op(a, b) of n x n blocks, on the thread pool if requested
+	template<typename T, typename Op>
+	void strassen_combine(size_t n, const T *a, size_t lda, const T *b, size_t ldb,
+		T *c, size_t ldc, bool parallel, Op op) {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		auto rows = [=](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				for (size_t j = 0; j < n; j++) {
+					c[i * ldc + j] = op(a[i * lda + j], b[i * ldb + j]);
+				}
+			}
+		};
+
+		if (parallel) {
+			thread_pool::instance().parallel_for(0, n, std::max<size_t>(minEntriesPerTask / n, 1), rows);
+		}
+		else {
+			rows(0, n);
+		}
+	}
+
+	// Amount of entries of T the recursion for an n x n product needs. Serial
+	// levels keep two quadrant sized temporaries and reuse the rest for every
+	// sub-product, parallel levels need eleven because all seven sub-products
+	// exist at the same time, each with its own workspace below.
+	inline size_t strassen_workspace(size_t n, size_t crossover, size_t parallelLevels) {
+		if (n <= crossover) { return 0; }
+
+		size_t h = n / 2;
+		if (parallelLevels == 0) {
+			return 2 * h * h + strassen_workspace(h, crossover, 0);
+		}
+		return 11 * h * h + 7 * strassen_workspace(h, crossover, parallelLevels - 1);
+	}
+
+	// Serial recursion C = A * B for n x n blocks, n is even on every level above
+	// the crossover. Uses the schedule of Douglas et al. which keeps the products
+	// in the quadrants of C and needs only two temporaries X and Y.
+	template<typename T>
+	void strassen_serial(size_t n, const T *a, size_t lda, const T *b, size_t ldb,
+		T *c, size_t ldc, size_t crossover, T *work) {
+		if (n <= crossover) {
+			gemm_kernel(n, n, n, a, lda, 1, b, ldb, 1, c, ldc, 1);
+			return;
+		}
+
+		size_t h = n / 2;
+		const T *a11 = a, *a12 = a + h, *a21 = a + h * lda, *a22 = a + h * lda + h;
+		const T *b11 = b, *b12 = b + h, *b21 = b + h * ldb, *b22 = b + h * ldb + h;
+		T *c11 = c, *c12 = c + h, *c21 = c + h * ldc, *c22 = c + h * ldc + h;
+		T *x = work, *y = work + h * h, *rest = work + 2 * h * h;
+		std::plus<T> add;
+		std::minus<T> sub;
+
+		strassen_combine(h, a11, lda, a21, lda, x, h, false, sub);              // S3
+		strassen_combine(h, b22, ldb, b12, ldb, y, h, false, sub);              // T3
+		strassen_serial(h, x, h, y, h, c21, ldc, crossover, rest);              // P7
+		strassen_combine(h, a21, lda, a22, lda, x, h, false, add);              // S1
+		strassen_combine(h, b12, ldb, b11, ldb, y, h, false, sub);              // T1
+		strassen_serial(h, x, h, y, h, c22, ldc, crossover, rest);              // P5
+		strassen_combine(h, x, h, a11, lda, x, h, false, sub);                  // S2
+		strassen_combine(h, b22, ldb, y, h, y, h, false, sub);                  // T2
+		strassen_serial(h, x, h, y, h, c12, ldc, crossover, rest);              // P6
+		strassen_combine(h, a12, lda, x, h, x, h, false, sub);                  // S4
+		strassen_serial(h, x, h, b22, ldb, c11, ldc, crossover, rest);          // P3
+		strassen_serial(h, a11, lda, b11, ldb, x, h, crossover, rest);          // P1
+		strassen_combine(h, x, h, c12, ldc, c12, ldc, false, add);              // P1 + P6
+		strassen_combine(h, c12, ldc, c21, ldc, c21, ldc, false, add);          // + P7
+		strassen_combine(h, c12, ldc, c22, ldc, c12, ldc, false, add);          // P1 + P6 + P5
+		strassen_combine(h, c21, ldc, c22, ldc, c22, ldc, false, add);          // C22
+		strassen_combine(h, c12, ldc, c11, ldc, c12, ldc, false, add);          // C12
+		strassen_combine(h, y, h, b21, ldb, y, h, false, sub);                  // T4
+		strassen_serial(h, a22, lda, y, h, c11, ldc, crossover, rest);          // P4
+		strassen_combine(h, c21, ldc, c11, ldc, c21, ldc, false, sub);          // C21
+		strassen_serial(h, a12, lda, b21, ldb, c11, ldc, crossover, rest);      // P2
+		strassen_combine(h, x, h, c11, ldc, c11, ldc, false, add);              // C11
+	}
+
+	// Recursion C = A * B whose first parallelLevels levels compute their seven
+	// sub-products as tasks on the thread pool
+	template<typename T>
+	void strassen_parallel(size_t n, const T *a, size_t lda, const T *b, size_t ldb,
+		T *c, size_t ldc, size_t crossover, size_t parallelLevels, T *work) {
+		if (parallelLevels == 0 || n <= crossover) {
+			strassen_serial(n, a, lda, b, ldb, c, ldc, crossover, work);
+			return;
+		}
+
+		size_t h = n / 2, hh = h * h;
+		const T *a11 = a, *a12 = a + h, *a21 = a + h * lda, *a22 = a + h * lda + h;
+		const T *b11 = b, *b12 = b + h, *b21 = b + h * ldb, *b22 = b + h * ldb + h;
+		T *c11 = c, *c12 = c + h, *c21 = c + h * ldc, *c22 = c + h * ldc + h;
+		T *s1 = work, *s2 = s1 + hh, *s3 = s2 + hh, *s4 = s3 + hh;
+		T *t1 = s4 + hh, *t2 = t1 + hh, *t3 = t2 + hh, *t4 = t3 + hh;
+		T *p1 = t4 + hh, *p6 = p1 + hh, *p7 = p6 + hh, *rest = p7 + hh;
+		size_t perProduct = strassen_workspace(h, crossover, parallelLevels - 1);
+		std::plus<T> add;
+		std::minus<T> sub;
+
+		strassen_combine(h, a21, lda, a22, lda, s1, h, true, add);
+		strassen_combine(h, s1, h, a11, lda, s2, h, true, sub);
+		strassen_combine(h, a11, lda, a21, lda, s3, h, true, sub);
+		strassen_combine(h, a12, lda, s2, h, s4, h, true, sub);
+		strassen_combine(h, b12, ldb, b11, ldb, t1, h, true, sub);
+		strassen_combine(h, b22, ldb, t1, h, t2, h, true, sub);
+		strassen_combine(h, b22, ldb, b12, ldb, t3, h, true, sub);
+		strassen_combine(h, t2, h, b21, ldb, t4, h, true, sub);
+
+		// P2 to P5 are written into the quadrants of C, the others into buffers
+		struct product {
+			const T *a;
+			size_t lda;
+			const T *b;
+			size_t ldb;
+			T *c;
+			size_t ldc;
+		};
+		const product products[7] = {
+			{ a11, lda, b11, ldb, p1, h },
+			{ a12, lda, b21, ldb, c11, ldc },
+			{ s4, h, b22, ldb, c12, ldc },
+			{ a22, lda, t4, h, c21, ldc },
+			{ s1, h, t1, h, c22, ldc },
+			{ s2, h, t2, h, p6, h },
+			{ s3, h, t3, h, p7, h }
+		};
+
+		thread_pool::instance().parallel_for(0, 7, 1, [&](size_t first, size_t last) {
+			for (size_t t = first; t < last; t++) {
+				const product &p = products[t];
+				strassen_parallel(h, p.a, p.lda, p.b, p.ldb, p.c, p.ldc, crossover,
+					parallelLevels - 1, rest + t * perProduct);
+			}
+		});
+
+		strassen_combine(h, c11, ldc, p1, h, c11, ldc, true, add);              // C11
+		strassen_combine(h, p1, h, p6, h, p6, h, true, add);                    // P1 + P6
+		strassen_combine(h, p6, h, p7, h, p7, h, true, add);                    // + P7
+		strassen_combine(h, c12, ldc, p6, h, c12, ldc, true, add);              // P3 + P1 + P6
+		strassen_combine(h, c12, ldc, c22, ldc, c12, ldc, true, add);           // C12
+		strassen_combine(h, p7, h, c21, ldc, c21, ldc, true, sub);              // C21
+		strassen_combine(h, p7, h, c22, ldc, c22, ldc, true, add);              // C22
+	}
+
+	// Multiply two quadratic matrices with the Strassen-Winograd algorithm, which
+	// needs O(n^2.81) operations instead of O(n^3). Halves the matrices until they
+	// are at most crossover large, padding them with zeros to a size that stays
+	// even on every level. Enough levels run their sub-products in parallel to
+	// occupy the thread pool. All temporaries are taken from workspace, which
+	// only grows if it is too small, so repeated products do not allocate.
+	// The error bound grows faster with n than for the classical product.
+	// Throws std::invalid_argument if a matrix is not quadratic and
+	// std::runtime_error if the dimensions do not match
+	template<typename T>
+	matrix<T> strassen(const matrix<T> &a, const matrix<T> &b, std::vector<T> &workspace,
+		size_t crossover = strassen_crossover) {
+		// Check for valid argument
+		if (a.rows() != a.columns() || b.rows() != b.columns()) {
+			throw std::invalid_argument("Matrix has to be quadratic.");
+		}
+		if (a.columns() != b.rows()) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not \
+				                      match the columns of the original matrix.");
+		}
+
+		size_t n = a.rows();
+		crossover = std::max<size_t>(crossover, 1);
+
+		// Count the levels and the size the leaves have
+		size_t levels = 0, leaf = n;
+		while (leaf > crossover) {
+			leaf = (leaf + 1) / 2;
+			levels++;
+		}
+		if (levels == 0) { return a * b; }
+
+		size_t padded = leaf << levels;
+		thread_pool &pool = thread_pool::instance();
+		size_t parallelLevels = 0;
+		for (size_t tasks = 1; tasks < pool.size() && parallelLevels < levels; tasks *= 7) {
+			parallelLevels++;
+		}
+
+		size_t recursion = strassen_workspace(padded, crossover, parallelLevels);
+		size_t copies = padded == n ? 0 : 3 * padded * padded;
+		if (workspace.size() < recursion + copies) { workspace.resize(recursion + copies); }
+
+		matrix<T> c(n, n);
+		if (copies == 0) {
+			strassen_parallel(n, a.data(), n, b.data(), n, c.data(), n, crossover,
+				parallelLevels, workspace.data());
+			return c;
+		}
+
+		// Embed the operands into zero padded copies
+		T *pa = workspace.data() + recursion;
+		T *pb = pa + padded * padded;
+		T *pc = pb + padded * padded;
+		std::fill(pa, pc, T(0));
+		for (size_t i = 0; i < n; i++) {
+			std::copy(a.data() + i * n, a.data() + (i + 1) * n, pa + i * padded);
+			std::copy(b.data() + i * n, b.data() + (i + 1) * n, pb + i * padded);
+		}
+
+		strassen_parallel(padded, pa, padded, pb, padded, pc, padded, crossover,
+			parallelLevels, workspace.data());
+
+		for (size_t i = 0; i < n; i++) {
+			std::copy(pc + i * padded, pc + i * padded + n, c.data() + i * n);
+		}
+		return c;
+	}
+
+	// Multiply with the Strassen-Winograd algorithm using a temporary workspace
+	template<typename T>
+	matrix<T> strassen(const matrix<T> &a, const matrix<T> &b,
+		size_t crossover = strassen_crossover) {
+		std::vector<T> workspace;
+		return strassen(a, b, workspace, crossover);
+	}
+}
\ No newline at end of file
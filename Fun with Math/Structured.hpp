@@ -0,0 +1,836 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Matrix.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include "Vector.hpp"
+
+namespace la {
+	// Quadratic matrices with a known structure store only the entries that can
+	// be unequal to 0, so memory and the work of products and solves shrink from
+	// n^2 and n^3 to the size of the structure.
+
+	// Which half of a triangular matrix holds the entries
+	enum class triangle {
+		lower,
+		upper
+	};
+
+	// Band matrix with kl diagonals below and ku diagonals above the main
+	// diagonal, kl = ku = 0 is a diagonal and kl = ku = 1 a tridiagonal matrix.
+	// Every row stores kl + ku + 1 entries, entry (i, j) at m_band[i * width +
+	// j - i + kl]. Positions of the first and last rows outside the matrix are
+	// kept at 0.
+	template<typename T = double>
+	class band_matrix {
+	private:
+		size_t m_size = 0;
+		size_t m_lower = 0, m_upper = 0;
+		std::vector<T> m_band;
+
+		// Factorize with partial pivoting into a copy widened by kl diagonals
+		// for the fill-in of the row swaps and solve for cols right hand sides
+		// stored row-major in x
+		void solve_in_place(T *, size_t) const;
+
+	public:
+		// Constructors
+
+		// Default constructor
+		band_matrix() = default;
+		// Construct n x n matrix of zeros with kl lower and ku upper diagonals
+		// Throws std::logic_error for zero dimensions
+		band_matrix(size_t, size_t, size_t);
+		// Construct diagonal matrix
+		explicit band_matrix(const vector<T> &);
+		// Take the band of a dense matrix, entries outside of it are dropped
+		// Throws std::invalid_argument if the matrix is not quadratic
+		band_matrix(const matrix<T> &, size_t, size_t);
+
+		// Getter for the dimensions
+		size_t size() const noexcept;
+		size_t rows() const noexcept;
+		size_t columns() const noexcept;
+		size_t lower_bandwidth() const noexcept;
+		size_t upper_bandwidth() const noexcept;
+		// Raw band storage for kernels
+		T* data() noexcept;
+		const T* data() const noexcept;
+
+		// Conversions
+		matrix<T> dense() const;
+
+		// Solve A * x = b by banded gaussian elimination with partial
+		// pivoting in O(n * kl * (kl + ku)), b may have several columns
+		// Throws std::runtime_error if the dimensions do not match and
+		// std::invalid_argument if the matrix is singular
+		vector<T> solve(const vector<T> &) const;
+		matrix<T> solve(const matrix<T> &) const;
+
+		// Overloaded operators
+
+		// Access operators
+		// Throw std::out_of_range for invalid indices, the non-const version
+		// also for entries outside the band
+		T& operator()(size_t, size_t);
+		T operator()(size_t, size_t) const;
+
+		// Arithmetic operators (may be multithreaded), O(n * (kl + ku)) per
+		// column of the other operand
+		// Throw std::runtime_error if the dimensions do not match
+		vector<T> operator*(const vector<T> &) const;
+		matrix<T> operator*(const matrix<T> &) const;
+		band_matrix operator*(const band_matrix &) const;
+
+		// Comparison operators
+		bool operator==(const band_matrix &) const noexcept;
+		bool operator!=(const band_matrix &) const noexcept;
+	};
+
+	// Triangular matrix stored packed row by row, n * (n + 1) / 2 entries. Row i
+	// of an upper triangular matrix holds the columns [i, n), of a lower one the
+	// columns [0, i].
+	template<typename T = double>
+	class triangular_matrix {
+	private:
+		size_t m_size = 0;
+		triangle m_triangle = triangle::upper;
+		std::vector<T> m_entries;
+
+		// Position of row i in m_entries and the columns [first, last) it holds
+		size_t row_offset(size_t) const noexcept;
+		size_t first_column(size_t) const noexcept;
+		size_t last_column(size_t) const noexcept;
+
+		// Substitute for cols right hand sides stored row-major in x
+		void solve_in_place(T *, size_t) const;
+
+	public:
+		// Constructors
+
+		// Default constructor
+		triangular_matrix() = default;
+		// Construct n x n triangular matrix of zeros
+		// Throws std::logic_error for zero dimensions
+		triangular_matrix(size_t, triangle);
+		// Take a triangle of a dense matrix, the other entries are dropped,
+		// like the zeros below the diagonal of gauss()
+		// Throws std::invalid_argument if the matrix is not quadratic
+		triangular_matrix(const matrix<T> &, triangle);
+
+		// Getter for the dimensions
+		size_t size() const noexcept;
+		size_t rows() const noexcept;
+		size_t columns() const noexcept;
+		triangle shape() const noexcept;
+		// Raw packed storage for kernels
+		T* data() noexcept;
+		const T* data() const noexcept;
+
+		// Conversions
+		matrix<T> dense() const;
+		triangular_matrix transpose() const;
+
+		// Product of the diagonal
+		T determinant() const noexcept;
+		// Solve A * x = b by forward or back substitution in O(n^2) per
+		// column of b
+		// Throws std::runtime_error if the dimensions do not match and
+		// std::invalid_argument if the matrix is singular
+		vector<T> solve(const vector<T> &) const;
+		matrix<T> solve(const matrix<T> &) const;
+
+		// Overloaded operators
+
+		// Access operators
+		// Throw std::out_of_range for invalid indices, the non-const version
+		// also for entries outside the triangle
+		T& operator()(size_t, size_t);
+		T operator()(size_t, size_t) const;
+
+		// Arithmetic operators (may be multithreaded), half the work of the
+		// dense product
+		// Throw std::runtime_error if the dimensions do not match
+		vector<T> operator*(const vector<T> &) const;
+		matrix<T> operator*(const matrix<T> &) const;
+
+		// Comparison operators
+		bool operator==(const triangular_matrix &) const noexcept;
+		bool operator!=(const triangular_matrix &) const noexcept;
+	};
+
+	// Multiply dense matrices by structured ones from the right (may be
+	// multithreaded)
+	// Throw std::runtime_error if the dimensions do not match
+	template<typename T>
+	matrix<T> operator*(const matrix<T> &, const band_matrix<T> &);
+	template<typename T>
+	matrix<T> operator*(const matrix<T> &, const triangular_matrix<T> &);
+
+	namespace detail {
+		// dst[0, n) += s * src[0, n)
+		template<typename T>
+		void structured_axpy(const T *src, T s, T *dst, size_t n) {
+			if constexpr (simd_supported_v<T>) {
+				simd_axpy(src, s, dst, n);
+			}
+			else {
+				for (size_t j = 0; j < n; j++) { dst[j] += s * src[j]; }
+			}
+		}
+
+		// Run f(first, last) on bands of the columns of cols right hand sides
+		// of n rows, so substitutions with many columns use all threads
+		template<typename F>
+		void for_each_column_band(size_t n, size_t cols, F f) {
+			const size_t minEntriesPerTask = 1 << 14;
+
+			thread_pool::instance().parallel_for(0, cols,
+				std::max<size_t>(minEntriesPerTask / std::max<size_t>(n, 1), 1), f);
+		}
+	}
+
+	// Create band matrix of zeros
+	template<typename T>
+	band_matrix<T>::band_matrix(size_t n, size_t kl, size_t ku)
+		: m_size(n), m_lower(std::min(kl, n - 1)), m_upper(std::min(ku, n - 1)) {
+		if (n == 0) {
+			throw std::logic_error("Matrix does not allow zero dimensions.");
+		}
+		m_band.assign(n * (m_lower + m_upper + 1), T(0));
+	}
+
+	// Create diagonal matrix from the entries of a vector
+	template<typename T>
+	band_matrix<T>::band_matrix(const vector<T> &diagonal)
+		: band_matrix(diagonal.size(), 0, 0) {
+		std::copy(diagonal.data(), diagonal.data() + m_size, m_band.begin());
+	}
+
+	// Copy the band of a dense matrix
+	template<typename T>
+	band_matrix<T>::band_matrix(const matrix<T> &m, size_t kl, size_t ku)
+		: band_matrix(m.rows(), kl, ku) {
+		if (m.rows() != m.columns()) {
+			throw std::invalid_argument("Matrix has to be quadratic.");
+		}
+
+		size_t width = m_lower + m_upper + 1;
+		const T *a = m.data();
+		for (size_t i = 0; i < m_size; i++) {
+			size_t first = i > m_lower ? i - m_lower : 0;
+			size_t last = std::min(m_size, i + m_upper + 1);
+			std::copy(a + i * m_size + first, a + i * m_size + last,
+				m_band.begin() + i * width + first + m_lower - i);
+		}
+	}
+
+	// Getter for the dimension
+	template<typename T>
+	size_t band_matrix<T>::size() const noexcept {
+		return m_size;
+	}
+
+	// Getter for rows
+	template<typename T>
+	size_t band_matrix<T>::rows() const noexcept {
+		return m_size;
+	}
+
+	// Getter for columns
+	template<typename T>
+	size_t band_matrix<T>::columns() const noexcept {
+		return m_size;
+	}
+
+	// Getter for the diagonals below the main diagonal
+	template<typename T>
+	size_t band_matrix<T>::lower_bandwidth() const noexcept {
+		return m_lower;
+	}
+
+	// Getter for the diagonals above the main diagonal
+	template<typename T>
+	size_t band_matrix<T>::upper_bandwidth() const noexcept {
+		return m_upper;
+	}
+
+	// Getter for the band storage
+	template<typename T>
+	T* band_matrix<T>::data() noexcept {
+		return m_band.data();
+	}
+
+	// Getter for the band storage
+	template<typename T>
+	const T* band_matrix<T>::data() const noexcept {
+		return m_band.data();
+	}
+
+	// Expand into a dense matrix
+	template<typename T>
+	matrix<T> band_matrix<T>::dense() const {
+		matrix<T> m(m_size, m_size);
+		size_t width = m_lower + m_upper + 1;
+		T *a = m.data();
+		for (size_t i = 0; i < m_size; i++) {
+			size_t first = i > m_lower ? i - m_lower : 0;
+			size_t last = std::min(m_size, i + m_upper + 1);
+			std::copy(m_band.begin() + i * width + first + m_lower - i,
+				m_band.begin() + i * width + last + m_lower - i, a + i * m_size + first);
+		}
+		return m;
+	}
+
+	// Banded LU like LAPACK's gbtf2: swapping row k with a row up to kl below
+	// moves entries of that row up to kl columns beyond the upper band, so the
+	// working copy has kl + ku upper diagonals. The multipliers are applied to
+	// the right hand sides right away, the back substitution runs on the
+	// widened upper triangle afterwards.
+	template<typename T>
+	void band_matrix<T>::solve_in_place(T *x, size_t cols) const {
+		size_t n = m_size;
+		size_t kl = m_lower;
+		size_t ku = m_upper + m_lower;
+		size_t width = kl + ku + 1;
+
+		std::vector<T> w(n * width, T(0));
+		for (size_t i = 0; i < n; i++) {
+			std::copy(m_band.begin() + i * (m_lower + m_upper + 1),
+				m_band.begin() + (i + 1) * (m_lower + m_upper + 1), w.begin() + i * width);
+		}
+		auto at = [&w, width, kl](size_t i, size_t j) -> T& { return w[i * width + j + kl - i]; };
+
+		for (size_t k = 0; k < n; k++) {
+			size_t below = std::min(n - 1, k + kl);
+			size_t right = std::min(n - 1, k + ku);
+
+			// Arithmetic types use the largest entry as pivot, all others the
+			// first entry unequal to 0
+			size_t p = k;
+			if constexpr (std::is_arithmetic_v<T>) {
+				for (size_t i = k + 1; i <= below; i++) {
+					if (std::abs(at(i, k)) > std::abs(at(p, k))) { p = i; }
+				}
+			}
+			else {
+				while (p < below && at(p, k) == T(0)) { p++; }
+			}
+			if (at(p, k) == T(0)) {
+				throw std::invalid_argument("Matrix is not invertible.");
+			}
+
+			if (p != k) {
+				for (size_t j = k; j <= right; j++) { std::swap(at(k, j), at(p, j)); }
+				std::swap_ranges(x + k * cols, x + (k + 1) * cols, x + p * cols);
+			}
+
+			T pivot = at(k, k);
+			for (size_t i = k + 1; i <= below; i++) {
+				T l_ik = at(i, k) / pivot;
+				if (l_ik == T(0)) { continue; }
+				for (size_t j = k + 1; j <= right; j++) { at(i, j) -= l_ik * at(k, j); }
+				detail::structured_axpy(x + k * cols, T(0) - l_ik, x + i * cols, cols);
+			}
+		}
+
+		// Back substitution with the upper band, the columns of x are
+		// independent of each other
+		detail::for_each_column_band(n, cols, [&](size_t first, size_t last) {
+			for (size_t i = n; i-- > 0;) {
+				T *row = x + i * cols;
+				for (size_t j = i + 1; j <= std::min(n - 1, i + ku); j++) {
+					T u_ij = at(i, j);
+					if (u_ij == T(0)) { continue; }
+					for (size_t c = first; c < last; c++) { row[c] -= u_ij * x[j * cols + c]; }
+				}
+				T u_ii = at(i, i);
+				for (size_t c = first; c < last; c++) { row[c] = row[c] / u_ii; }
+			}
+		});
+	}
+
+	// Solve for a single right hand side
+	template<typename T>
+	vector<T> band_matrix<T>::solve(const vector<T> &b) const {
+		// Check for valid argument
+		if (b.size() != m_size) {
+			throw std::runtime_error("Size of vector has to match rows of the matrix.");
+		}
+
+		vector<T> x(b);
+		solve_in_place(x.data(), 1);
+		return x;
+	}
+
+	// Solve for all columns of b at once
+	template<typename T>
+	matrix<T> band_matrix<T>::solve(const matrix<T> &b) const {
+		// Check for valid argument
+		if (b.rows() != m_size) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not match the columns of the original matrix.");
+		}
+
+		matrix<T> x(b);
+		solve_in_place(x.data(), x.columns());
+		return x;
+	}
+
+	// Access entries of the band
+	template<typename T>
+	T& band_matrix<T>::operator()(size_t i, size_t j) {
+		// Check for valid argument
+		if (i >= m_size || j >= m_size || j + m_lower < i || j > i + m_upper) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+		return m_band[i * (m_lower + m_upper + 1) + j + m_lower - i];
+	}
+
+	// Read any entry, 0 outside of the band
+	template<typename T>
+	T band_matrix<T>::operator()(size_t i, size_t j) const {
+		// Check for valid argument
+		if (i >= m_size || j >= m_size) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+		if (j + m_lower < i || j > i + m_upper) { return T(0); }
+		return m_band[i * (m_lower + m_upper + 1) + j + m_lower - i];
+	}
+
+	// Multiply by vector, every row is a dot product over the band
+	template<typename T>
+	vector<T> band_matrix<T>::operator*(const vector<T> &other) const {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		// Check for valid argument
+		if (other.size() != m_size) {
+			throw std::runtime_error("Can not multiply by a vector which dimension does not match the columns of the matrix.");
+		}
+
+		vector<T> v(m_size);
+		size_t width = m_lower + m_upper + 1;
+		const T *x = other.data();
+		T *y = v.data();
+		thread_pool::instance().parallel_for(0, m_size, std::max<size_t>(minEntriesPerTask / width, 1),
+			[this, x, y, width](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				size_t begin = i > m_lower ? i - m_lower : 0;
+				size_t end = std::min(m_size, i + m_upper + 1);
+				const T *row = m_band.data() + i * width + m_lower - i;
+				T dot(0);
+				for (size_t j = begin; j < end; j++) { dot += row[j] * x[j]; }
+				y[i] = dot;
+			}
+		});
+		return v;
+	}
+
+	// Multiply by dense matrix, every row of the result combines the rows of
+	// the other matrix inside the band
+	template<typename T>
+	matrix<T> band_matrix<T>::operator*(const matrix<T> &other) const {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		// Check for valid argument
+		if (other.rows() != m_size) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not match the columns of the original matrix.");
+		}
+
+		size_t cols = other.columns();
+		size_t width = m_lower + m_upper + 1;
+		matrix<T> m(m_size, cols);
+		const T *b = other.data();
+		T *c = m.data();
+		thread_pool::instance().parallel_for(0, m_size, std::max<size_t>(minEntriesPerTask / (width * cols), 1),
+			[this, b, c, cols, width](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				size_t begin = i > m_lower ? i - m_lower : 0;
+				size_t end = std::min(m_size, i + m_upper + 1);
+				const T *row = m_band.data() + i * width + m_lower - i;
+				for (size_t j = begin; j < end; j++) {
+					if (row[j] == T(0)) { continue; }
+					detail::structured_axpy(b + j * cols, row[j], c + i * cols, cols);
+				}
+			}
+		});
+		return m;
+	}
+
+	// Multiply two band matrices, the bandwidths add up
+	template<typename T>
+	band_matrix<T> band_matrix<T>::operator*(const band_matrix<T> &other) const {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		// Check for valid argument
+		if (other.m_size != m_size) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not match the columns of the original matrix.");
+		}
+
+		band_matrix<T> m(m_size, m_lower + other.m_lower, m_upper + other.m_upper);
+		size_t width = m_lower + m_upper + 1;
+		size_t otherWidth = other.m_lower + other.m_upper + 1;
+		size_t resultWidth = m.m_lower + m.m_upper + 1;
+		thread_pool::instance().parallel_for(0, m_size, std::max<size_t>(minEntriesPerTask / (width * otherWidth), 1),
+			[&](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				size_t begin = i > m_lower ? i - m_lower : 0;
+				size_t end = std::min(m_size, i + m_upper + 1);
+				const T *row = m_band.data() + i * width + m_lower - i;
+				T *result = m.m_band.data() + i * resultWidth + m.m_lower - i;
+				for (size_t k = begin; k < end; k++) {
+					T a_ik = row[k];
+					if (a_ik == T(0)) { continue; }
+					size_t jBegin = k > other.m_lower ? k - other.m_lower : 0;
+					size_t jEnd = std::min(m_size, k + other.m_upper + 1);
+					const T *otherRow = other.m_band.data() + k * otherWidth + other.m_lower - k;
+					for (size_t j = jBegin; j < jEnd; j++) { result[j] += a_ik * otherRow[j]; }
+				}
+			}
+		});
+		return m;
+	}
+
+	// Check two matrices for equal bandwidths and entries
+	template<typename T>
+	bool band_matrix<T>::operator==(const band_matrix<T> &other) const noexcept {
+		return m_size == other.m_size && m_lower == other.m_lower && m_upper == other.m_upper &&
+			m_band == other.m_band;
+	}
+
+	// Check two matrices for inequality
+	template<typename T>
+	bool band_matrix<T>::operator!=(const band_matrix<T> &other) const noexcept {
+		return !(*this == other);
+	}
+
+	// Create triangular matrix of zeros
+	template<typename T>
+	triangular_matrix<T>::triangular_matrix(size_t n, triangle shape)
+		: m_size(n), m_triangle(shape) {
+		if (n == 0) {
+			throw std::logic_error("Matrix does not allow zero dimensions.");
+		}
+		m_entries.assign(n * (n + 1) / 2, T(0));
+	}
+
+	// Copy a triangle of a dense matrix
+	template<typename T>
+	triangular_matrix<T>::triangular_matrix(const matrix<T> &m, triangle shape)
+		: triangular_matrix(m.rows(), shape) {
+		if (m.rows() != m.columns()) {
+			throw std::invalid_argument("Matrix has to be quadratic.");
+		}
+
+		const T *a = m.data();
+		for (size_t i = 0; i < m_size; i++) {
+			std::copy(a + i * m_size + first_column(i), a + i * m_size + last_column(i),
+				m_entries.begin() + row_offset(i));
+		}
+	}
+
+	// Rows above row i hold n + (n - 1) + ... entries in the upper and
+	// 1 + 2 + ... + i in the lower triangle
+	template<typename T>
+	size_t triangular_matrix<T>::row_offset(size_t i) const noexcept {
+		return m_triangle == triangle::upper ? i * m_size - i * (i - 1) / 2 : i * (i + 1) / 2;
+	}
+
+	// First column stored in row i
+	template<typename T>
+	size_t triangular_matrix<T>::first_column(size_t i) const noexcept {
+		return m_triangle == triangle::upper ? i : 0;
+	}
+
+	// Column after the last one stored in row i
+	template<typename T>
+	size_t triangular_matrix<T>::last_column(size_t i) const noexcept {
+		return m_triangle == triangle::upper ? m_size : i + 1;
+	}
+
+	// Getter for the dimension
+	template<typename T>
+	size_t triangular_matrix<T>::size() const noexcept {
+		return m_size;
+	}
+
+	// Getter for rows
+	template<typename T>
+	size_t triangular_matrix<T>::rows() const noexcept {
+		return m_size;
+	}
+
+	// Getter for columns
+	template<typename T>
+	size_t triangular_matrix<T>::columns() const noexcept {
+		return m_size;
+	}
+
+	// Getter for the stored triangle
+	template<typename T>
+	triangle triangular_matrix<T>::shape() const noexcept {
+		return m_triangle;
+	}
+
+	// Getter for the packed storage
+	template<typename T>
+	T* triangular_matrix<T>::data() noexcept {
+		return m_entries.data();
+	}
+
+	// Getter for the packed storage
+	template<typename T>
+	const T* triangular_matrix<T>::data() const noexcept {
+		return m_entries.data();
+	}
+
+	// Expand into a dense matrix
+	template<typename T>
+	matrix<T> triangular_matrix<T>::dense() const {
+		matrix<T> m(m_size, m_size);
+		T *a = m.data();
+		for (size_t i = 0; i < m_size; i++) {
+			std::copy(m_entries.begin() + row_offset(i),
+				m_entries.begin() + row_offset(i) + last_column(i) - first_column(i),
+				a + i * m_size + first_column(i));
+		}
+		return m;
+	}
+
+	// Mirror at the diagonal, which turns an upper into a lower triangle
+	template<typename T>
+	triangular_matrix<T> triangular_matrix<T>::transpose() const {
+		triangular_matrix<T> t(m_size, m_triangle == triangle::upper ? triangle::lower : triangle::upper);
+		for (size_t i = 0; i < m_size; i++) {
+			const T *row = m_entries.data() + row_offset(i) - first_column(i);
+			for (size_t j = first_column(i); j < last_column(i); j++) {
+				t.m_entries[t.row_offset(j) + i - t.first_column(j)] = row[j];
+			}
+		}
+		return t;
+	}
+
+	// Multiply the diagonal entries
+	template<typename T>
+	T triangular_matrix<T>::determinant() const noexcept {
+		T det(1);
+		for (size_t i = 0; i < m_size; i++) {
+			det *= m_entries[row_offset(i) + i - first_column(i)];
+		}
+		return det;
+	}
+
+	// Forward substitution for lower, back substitution for upper triangles.
+	// The columns of x are independent of each other.
+	template<typename T>
+	void triangular_matrix<T>::solve_in_place(T *x, size_t cols) const {
+		size_t n = m_size;
+		for (size_t i = 0; i < n; i++) {
+			if (m_entries[row_offset(i) + i - first_column(i)] == T(0)) {
+				throw std::invalid_argument("Matrix is not invertible.");
+			}
+		}
+
+		bool upper = m_triangle == triangle::upper;
+		detail::for_each_column_band(n, cols, [&](size_t first, size_t last) {
+			for (size_t step = 0; step < n; step++) {
+				size_t i = upper ? n - 1 - step : step;
+				const T *row = m_entries.data() + row_offset(i) - first_column(i);
+				T *x_i = x + i * cols;
+				for (size_t j = first_column(i); j < last_column(i); j++) {
+					T a_ij = row[j];
+					if (j == i || a_ij == T(0)) { continue; }
+					for (size_t c = first; c < last; c++) { x_i[c] -= a_ij * x[j * cols + c]; }
+				}
+				for (size_t c = first; c < last; c++) { x_i[c] = x_i[c] / row[i]; }
+			}
+		});
+	}
+
+	// Solve for a single right hand side
+	template<typename T>
+	vector<T> triangular_matrix<T>::solve(const vector<T> &b) const {
+		// Check for valid argument
+		if (b.size() != m_size) {
+			throw std::runtime_error("Size of vector has to match rows of the matrix.");
+		}
+
+		vector<T> x(b);
+		solve_in_place(x.data(), 1);
+		return x;
+	}
+
+	// Solve for all columns of b at once
+	template<typename T>
+	matrix<T> triangular_matrix<T>::solve(const matrix<T> &b) const {
+		// Check for valid argument
+		if (b.rows() != m_size) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not match the columns of the original matrix.");
+		}
+
+		matrix<T> x(b);
+		solve_in_place(x.data(), x.columns());
+		return x;
+	}
+
+	// Access entries of the triangle
+	template<typename T>
+	T& triangular_matrix<T>::operator()(size_t i, size_t j) {
+		// Check for valid argument
+		if (i >= m_size || j < first_column(i) || j >= last_column(i)) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+		return m_entries[row_offset(i) + j - first_column(i)];
+	}
+
+	// Read any entry, 0 outside of the triangle
+	template<typename T>
+	T triangular_matrix<T>::operator()(size_t i, size_t j) const {
+		// Check for valid argument
+		if (i >= m_size || j >= m_size) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+		if (j < first_column(i) || j >= last_column(i)) { return T(0); }
+		return m_entries[row_offset(i) + j - first_column(i)];
+	}
+
+	// Multiply by vector, every row is a dot product over its stored part
+	template<typename T>
+	vector<T> triangular_matrix<T>::operator*(const vector<T> &other) const {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		// Check for valid argument
+		if (other.size() != m_size) {
+			throw std::runtime_error("Can not multiply by a vector which dimension does not match the columns of the matrix.");
+		}
+
+		vector<T> v(m_size);
+		const T *x = other.data();
+		T *y = v.data();
+		thread_pool::instance().parallel_for(0, m_size, std::max<size_t>(2 * minEntriesPerTask / m_size, 1),
+			[this, x, y](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				const T *row = m_entries.data() + row_offset(i) - first_column(i);
+				T dot(0);
+				for (size_t j = first_column(i); j < last_column(i); j++) { dot += row[j] * x[j]; }
+				y[i] = dot;
+			}
+		});
+		return v;
+	}
+
+	// Multiply by dense matrix, every row of the result combines the rows of
+	// the other matrix inside the triangle
+	template<typename T>
+	matrix<T> triangular_matrix<T>::operator*(const matrix<T> &other) const {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		// Check for valid argument
+		if (other.rows() != m_size) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not match the columns of the original matrix.");
+		}
+
+		size_t cols = other.columns();
+		matrix<T> m(m_size, cols);
+		const T *b = other.data();
+		T *c = m.data();
+		thread_pool::instance().parallel_for(0, m_size, std::max<size_t>(2 * minEntriesPerTask / (m_size * cols), 1),
+			[this, b, c, cols](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				const T *row = m_entries.data() + row_offset(i) - first_column(i);
+				for (size_t j = first_column(i); j < last_column(i); j++) {
+					if (row[j] == T(0)) { continue; }
+					detail::structured_axpy(b + j * cols, row[j], c + i * cols, cols);
+				}
+			}
+		});
+		return m;
+	}
+
+	// Check two matrices for equal shape and entries
+	template<typename T>
+	bool triangular_matrix<T>::operator==(const triangular_matrix<T> &other) const noexcept {
+		return m_size == other.m_size && m_triangle == other.m_triangle && m_entries == other.m_entries;
+	}
+
+	// Check two matrices for inequality
+	template<typename T>
+	bool triangular_matrix<T>::operator!=(const triangular_matrix<T> &other) const noexcept {
+		return !(*this == other);
+	}
+
+	// Every row of the result adds up the rows of the band matrix weighted by
+	// the entries of the dense row, each band row covers kl + ku + 1 columns
+	template<typename T>
+	matrix<T> operator*(const matrix<T> &lhs, const band_matrix<T> &rhs) {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		// Check for valid argument
+		if (lhs.columns() != rhs.size()) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not match the columns of the original matrix.");
+		}
+
+		size_t n = rhs.size();
+		size_t kl = rhs.lower_bandwidth();
+		size_t ku = rhs.upper_bandwidth();
+		size_t width = kl + ku + 1;
+		matrix<T> m(lhs.rows(), n);
+		const T *a = lhs.data();
+		const T *band = rhs.data();
+		T *c = m.data();
+		thread_pool::instance().parallel_for(0, lhs.rows(), std::max<size_t>(minEntriesPerTask / (n * width), 1),
+			[=](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				for (size_t k = 0; k < n; k++) {
+					T a_ik = a[i * n + k];
+					if (a_ik == T(0)) { continue; }
+					size_t begin = k > kl ? k - kl : 0;
+					size_t end = std::min(n, k + ku + 1);
+					detail::structured_axpy(band + k * width + begin + kl - k, a_ik, c + i * n + begin, end - begin);
+				}
+			}
+		});
+		return m;
+	}
+
+	// Every row of the result adds up the rows of the triangular matrix
+	// weighted by the entries of the dense row
+	template<typename T>
+	matrix<T> operator*(const matrix<T> &lhs, const triangular_matrix<T> &rhs) {
+		const size_t minEntriesPerTask = 1 << 14;
+
+		// Check for valid argument
+		if (lhs.columns() != rhs.size()) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not match the columns of the original matrix.");
+		}
+
+		size_t n = rhs.size();
+		bool upper = rhs.shape() == triangle::upper;
+		matrix<T> m(lhs.rows(), n);
+		const T *a = lhs.data();
+		const T *packed = rhs.data();
+		T *c = m.data();
+		thread_pool::instance().parallel_for(0, lhs.rows(), std::max<size_t>(2 * minEntriesPerTask / (n * n), 1),
+			[=](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				const T *row = packed;
+				for (size_t k = 0; k < n; k++) {
+					size_t begin = upper ? k : 0;
+					size_t end = upper ? n : k + 1;
+					T a_ik = a[i * n + k];
+					if (a_ik != T(0)) {
+						detail::structured_axpy(row, a_ik, c + i * n + begin, end - begin);
+					}
+					row += end - begin;
+				}
+			}
+		});
+		return m;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "ThreadPool.hpp"
+
+namespace la {
+	namespace {
+		// Pool and queue index of the current thread if it is a worker
+		thread_local const thread_pool *t_pool = nullptr;
+		thread_local size_t t_queue = 0;
+	}
+
+	thread_pool::thread_pool(size_t threads) {
+		start(threads);
+	}
+
+	thread_pool::~thread_pool() {
+		stop();
+	}
+
+	thread_pool& thread_pool::instance() {
+		static thread_pool pool;
+		return pool;
+	}
+
+	size_t thread_pool::size() const noexcept {
+		return m_threads.size() + 1;
+	}
+
+	void thread_pool::resize(size_t threads) {
+		stop();
+		start(threads);
+	}
+
+	void thread_pool::start(size_t threads) {
+		if (threads == 0) {
+			threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		}
+
+		m_stop = false;
+		// The last queue is shared by all threads outside the pool
+		m_queues.clear();
+		for (size_t i = 0; i < threads; i++) {
+			m_queues.push_back(std::make_unique<task_queue>());
+		}
+		for (size_t i = 0; i + 1 < threads; i++) {
+			m_threads.emplace_back(&thread_pool::worker_loop, this, i);
+		}
+	}
+
+	void thread_pool::stop() {
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_stop = true;
+		}
+		m_wakeup.notify_all();
+		for (auto &thread : m_threads) {
+			thread.join();
+		}
+		m_threads.clear();
+	}
+
+	void thread_pool::worker_loop(size_t index) {
+		t_pool = this;
+		t_queue = index;
+
+		while (true) {
+			if (try_run_one(index)) { continue; }
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_wakeup.wait(lock, [this]() { return m_stop || m_queued > 0; });
+			if (m_stop && m_queued == 0) { return; }
+		}
+	}
+
+	size_t thread_pool::own_queue() const noexcept {
+		return t_pool == this ? t_queue : m_queues.size() - 1;
+	}
+
+	size_t thread_pool::push(task *tasks, size_t count) {
+		task_queue &queue = *m_queues[own_queue()];
+		size_t pushed = 0;
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			pushed = std::min(count, task_queue::capacity - queue.count);
+			for (size_t i = 0; i < pushed; i++) {
+				queue.tasks[(queue.head + queue.count) % task_queue::capacity] = tasks[i];
+				queue.count++;
+			}
+		}
+		if (pushed == 0) { return 0; }
+		{
+			// Taking the lock orders the counter update with sleeping workers
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_queued += pushed;
+		}
+		m_wakeup.notify_all();
+		return pushed;
+	}
+
+	bool thread_pool::try_run_one(size_t index) {
+		task t;
+		bool found = false;
+
+		// Newest task of the own queue first, it is most likely still in cache
+		{
+			task_queue &queue = *m_queues[index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.count > 0) {
+				queue.count--;
+				t = queue.tasks[(queue.head + queue.count) % task_queue::capacity];
+				found = true;
+			}
+		}
+
+		// Otherwise steal the oldest task of another queue, which usually is the
+		// biggest chunk of work left
+		for (size_t i = 1; !found && i < m_queues.size(); i++) {
+			task_queue &queue = *m_queues[(index + i) % m_queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.count > 0) {
+				t = queue.tasks[queue.head];
+				queue.head = (queue.head + 1) % task_queue::capacity;
+				queue.count--;
+				found = true;
+			}
+		}
+
+		if (!found) { return false; }
+
+		m_queued--;
+		run(t);
+		return true;
+	}
+
+	void thread_pool::run(const task &t) {
+		try {
+			t.invoke(t.context, t.begin, t.end);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(t.group->mutex);
+			if (!t.group->exception) { t.group->exception = std::current_exception(); }
+		}
+		t.group->pending--;
+	}
+
+	void thread_pool::wait(task_group &group) {
+		size_t index = own_queue();
+		// Help out instead of blocking, this also runs nested loops of the tasks
+		// we are waiting for
+		while (group.pending > 0) {
+			if (!try_run_one(index)) {
+				std::this_thread::yield();
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace la {
+	// Persistent pool of worker threads with one work-stealing queue per worker.
+	// Workers pop tasks from the back of their own queue and steal from the front
+	// of the others. Threads waiting for a parallel loop keep executing tasks, so
+	// nested parallel loops reuse the same workers instead of oversubscribing the
+	// machine. Scheduling does not allocate: tasks are plain descriptors pointing
+	// at the loop body on the stack of the waiting caller, and the queues are
+	// fixed ring buffers.
+	class thread_pool {
+	private:
+		// Bookkeeping for all tasks created by one parallel loop
+		struct task_group {
+			std::atomic<size_t> pending{ 0 };
+			std::mutex mutex;
+			std::exception_ptr exception;
+		};
+
+		// Chunk [begin, end) of a loop, invoke calls the body behind context
+		struct task {
+			void (*invoke)(void *, size_t, size_t) = nullptr;
+			void *context = nullptr;
+			size_t begin = 0, end = 0;
+			task_group *group = nullptr;
+		};
+
+		// Ring buffer of tasks, the oldest one at head
+		struct task_queue {
+			static constexpr size_t capacity = 1024;
+			std::mutex mutex;
+			task tasks[capacity];
+			size_t head = 0, count = 0;
+		};
+
+		// Most chunks a single loop is split into
+		static constexpr size_t maxChunks = 256;
+
+		// One queue per worker and a shared queue for threads outside the pool
+		std::vector<std::unique_ptr<task_queue>> m_queues;
+		std::vector<std::thread> m_threads;
+
+		// Idle workers sleep until tasks get queued
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wakeup;
+		std::atomic<size_t> m_queued{ 0 };
+		bool m_stop = false;
+
+		void start(size_t);
+		void stop();
+		void worker_loop(size_t);
+
+		// Index of the queue the calling thread pushes to and pops from
+		size_t own_queue() const noexcept;
+		// Queue as many of the tasks as fit, returns how many
+		size_t push(task *, size_t);
+		bool try_run_one(size_t);
+		void run(const task &);
+		void wait(task_group &);
+
+	public:
+		// Constructors
+
+		// Create pool with given amount of threads including the calling thread,
+		// 0 uses std::thread::hardware_concurrency
+		explicit thread_pool(size_t = 0);
+		thread_pool(const thread_pool &) = delete;
+
+		// Destructor
+		~thread_pool();
+
+		thread_pool& operator=(const thread_pool &) = delete;
+
+		// Library wide pool used by all la algorithms
+		static thread_pool& instance();
+
+		// Amount of threads working on a parallel loop including the caller
+		size_t size() const noexcept;
+		// Change the amount of threads, must not be called while work is pending
+		void resize(size_t = 0);
+
+		// Split [first, last) into chunks of at least grain iterations and call
+		// f(begin, end) for all of them in parallel. Returns after every chunk has
+		// finished and rethrows the first exception thrown by f.
+		template<typename F>
+		void parallel_for(size_t, size_t, size_t, F &&);
+
+	private:
+		template<typename F>
+		static void invoke(void *, size_t, size_t);
+	};
+
+	// Call the loop body of a task
+	template<typename F>
+	void thread_pool::invoke(void *context, size_t begin, size_t end) {
+		(*static_cast<F *>(context))(begin, end);
+	}
+
+	// Split range into chunks and distribute them over the pool
+	template<typename F>
+	void thread_pool::parallel_for(size_t first, size_t last, size_t grain, F &&f) {
+		if (first >= last) { return; }
+
+		grain = std::max<size_t>(grain, 1);
+		size_t range = last - first;
+		// A few chunks per thread balance the load without flooding the queues
+		size_t chunks = std::min({ (range + grain - 1) / grain, 4 * size(), maxChunks });
+
+		if (chunks <= 1 || size() == 1) {
+			f(first, last);
+			return;
+		}
+
+		size_t chunkSize = range / chunks;
+		size_t remainder = range % chunks;
+
+		task_group group;
+		group.pending = chunks - 1;
+
+		// f and the tasks outlive their execution because we wait for the group
+		// before returning
+		using function_type = std::remove_reference_t<F>;
+		void *context = const_cast<void *>(static_cast<const void *>(std::addressof(f)));
+		task tasks[maxChunks];
+		size_t begin = first;
+		for (size_t c = 0; c < chunks; c++) {
+			size_t end = begin + chunkSize + (c < remainder ? 1 : 0);
+			if (c != 0) {
+				tasks[c - 1] = { &invoke<function_type>, context, begin, end, &group };
+			}
+			else {
+				last = end;
+			}
+			begin = end;
+		}
+		size_t queued = push(tasks, chunks - 1);
+
+		// The caller takes the first chunk itself
+		try {
+			f(first, last);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(group.mutex);
+			if (!group.exception) { group.exception = std::current_exception(); }
+		}
+
+		// Chunks which did not fit into the queue are ours as well
+		for (size_t c = queued; c + 1 < chunks; c++) {
+			run(tasks[c]);
+		}
+
+		wait(group);
+		if (group.exception) {
+			std::rethrow_exception(group.exception);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+namespace la {
+	// Side length of the tiles the transpositions work on. A tile of the source
+	// and one of the destination fit into L1 together, so the strided side of the
+	// copy touches only a few pages at a time.
+	constexpr size_t transpose_tile = 32;
+
+	// Cache-oblivious transposition B = A^T of an m x n block addressed by a
+	// pointer and a row stride. The larger dimension is halved until the block is
+	// a tile, which keeps the working set of every level inside some cache
+	// without knowing its size.
+	template<typename T>
+	void transpose_recursive(size_t m, size_t n, const T *a, size_t lda, T *b, size_t ldb) {
+		if (m <= transpose_tile && n <= transpose_tile) {
+			for (size_t i = 0; i < m; i++) {
+				for (size_t j = 0; j < n; j++) {
+					b[j * ldb + i] = a[i * lda + j];
+				}
+			}
+			return;
+		}
+
+		if (m >= n) {
+			size_t h = m / 2;
+			transpose_recursive(h, n, a, lda, b, ldb);
+			transpose_recursive(m - h, n, a + h * lda, lda, b + h, ldb);
+		}
+		else {
+			size_t h = n / 2;
+			transpose_recursive(m, h, a, lda, b, ldb);
+			transpose_recursive(m, n - h, a + h, lda, b + h * ldb, ldb);
+		}
+	}
+
+	// Transpose B = A^T on the thread pool, every task writes a band of rows of B
+	template<typename T>
+	void transpose_parallel(size_t m, size_t n, const T *a, size_t lda, T *b, size_t ldb) {
+		const size_t minEntriesPerTask = 1 << 15;
+
+		if (m == 0 || n == 0) { return; }
+		thread_pool::instance().parallel_for(0, n,
+			std::max(minEntriesPerTask / m, transpose_tile), [=](size_t first, size_t last) {
+			transpose_recursive(m, last - first, a + first, lda, b + first * ldb, ldb);
+		});
+	}
+
+	// Transpose a quadratic n x n block in place (may be multithreaded). The task
+	// of a block row swaps its tiles right of the diagonal with their mirror
+	// images below it, so no two tasks touch the same entries.
+	template<typename T>
+	void transpose_square_in_place(size_t n, T *a, size_t lda) {
+		const size_t minEntriesPerTask = 1 << 15;
+
+		size_t blocks = (n + transpose_tile - 1) / transpose_tile;
+		size_t blocksPerTask = std::max<size_t>(minEntriesPerTask / std::max<size_t>(n * transpose_tile, 1), 1);
+
+		thread_pool::instance().parallel_for(0, blocks, blocksPerTask, [=](size_t first, size_t last) {
+			for (size_t bi = first; bi < last; bi++) {
+				size_t i0 = bi * transpose_tile;
+				size_t ib = std::min(transpose_tile, n - i0);
+
+				// The tile on the diagonal is mirrored onto itself
+				for (size_t i = 0; i < ib; i++) {
+					for (size_t j = i + 1; j < ib; j++) {
+						std::swap(a[(i0 + i) * lda + i0 + j], a[(i0 + j) * lda + i0 + i]);
+					}
+				}
+
+				for (size_t j0 = i0 + transpose_tile; j0 < n; j0 += transpose_tile) {
+					size_t jb = std::min(transpose_tile, n - j0);
+					for (size_t i = 0; i < ib; i++) {
+						for (size_t j = 0; j < jb; j++) {
+							std::swap(a[(i0 + i) * lda + j0 + j], a[(j0 + j) * lda + i0 + i]);
+						}
+					}
+				}
+			}
+		});
+	}
+
+	// Transpose a row-major m x n matrix in place into a row-major n x m one by
+	// following the cycles of the permutation: the entry at k = i * n + j moves to
+	// j * m + i. Every cycle is rotated once, a bit per entry remembers which
+	// entries are already in place.
+	template<typename T>
+	void transpose_cycles(size_t m, size_t n, T *a) {
+		// A single row or column has the same storage as its transpose
+		if (m <= 1 || n <= 1) { return; }
+
+		size_t entries = m * n;
+		std::vector<bool> moved(entries);
+
+		// The first and the last entry stay where they are
+		for (size_t start = 1; start + 1 < entries; start++) {
+			if (moved[start]) { continue; }
+
+			T value = std::move(a[start]);
+			size_t k = start;
+			do {
+				k = k % n * m + k / n;
+				std::swap(value, a[k]);
+				moved[k] = true;
+			} while (k != start);
+		}
+	}
+}
\ No newline at end of file
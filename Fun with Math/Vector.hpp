@@ -5,12 +5,12 @@
 #include <utility>
 #include <cmath>
 
+#include "Expression.hpp"
+#include "Gemv.hpp"
+
 namespace la {
 	template<typename T>
-	class matrix;
-
-	template<typename T = double>
-	class vector {
+	class vector<T, dynamic> : public matrix_expression<vector<T>> {
 	private:
 		size_t m_dimension;
 		matrix<T> m_matrix;
@@ -18,6 +18,11 @@ namespace la {
 		friend matrix<T>;
 
 	public:
+		// Expression traits
+		using value_type = T;
+		static constexpr bool is_vector = true;
+		static constexpr bool is_leaf = true;
+
 		// Constructors
 
 		// Default constructor
@@ -32,9 +37,24 @@ namespace la {
 			noexcept(std::is_nothrow_default_constructible_v<T>);
 		// Move constructor
 		vector(vector &&) noexcept;
+		// Evaluate elementwise expression
+		template<typename E>
+		vector(const matrix_expression<E> &);
+		// Use existing storage of given size without copying, see matrix
+		vector(T *, size_t, buffer) noexcept;
 
 		// Getter for dimensions
 		size_t size() const noexcept;
+		size_t rows() const noexcept;
+		size_t columns() const noexcept;
+		// Unchecked access by index used to evaluate expressions
+		T eval(size_t) const noexcept;
+		// Raw storage for kernels
+		T* data() noexcept;
+		const T* data() const noexcept;
+		// Views of the entries without copying
+		vector_view<T> view() noexcept;
+		vector_view<const T> view() const noexcept;
 		// Return vector norm
 		double norm() const;
 		// Return unit vector
@@ -53,40 +73,33 @@ namespace la {
 
 		// Arithmetic operators
 		// All arithmetic operations throw if the operations are mathematically
-		// not well-defined
+		// not well-defined. Elementwise operations (+, - and multiplication or
+		// division by a constant) are lazily evaluated expressions, see Expression.hpp
 		T operator*(const vector &) const;
-		vector operator*(const matrix<T> &);
-		vector operator*(const T &) const
-			noexcept(std::is_nothrow_constructible_v<vector<T>, size_t>);
-		vector operator/(const T &) const
-			noexcept(std::is_nothrow_constructible_v<vector<T>, size_t>);
-		vector operator+(const vector &) const;
-		vector operator-(const vector &) const;
+		vector operator*(const matrix<T> &) const;
 
 		// Assignment operators
-		vector& operator*=(const T &)
-			noexcept(std::is_nothrow_constructible_v<vector<T>, size_t>);
-		vector& operator/=(const T &)
-			noexcept(std::is_nothrow_constructible_v<vector<T>, size_t>);
-		vector& operator+=(const vector &);
-		vector& operator-=(const vector &);
+		vector& operator*=(const T &);
+		vector& operator/=(const T &);
+		template<typename E>
+		vector& operator+=(const matrix_expression<E> &);
+		template<typename E>
+		vector& operator-=(const matrix_expression<E> &);
 
 		// Copy assignment
 		vector& operator=(const vector &)
 			noexcept(std::is_nothrow_default_constructible_v<T>);
 		// Move assignment
 		vector& operator=(vector &&) noexcept;
+		// Assignment of elementwise expression
+		template<typename E>
+		vector& operator=(const matrix_expression<E> &);
 
 		// Comparison operators
 		bool operator==(const vector &) const noexcept;
 		bool operator!=(const vector &) const noexcept;
 	};
 
-	// Allow for both-sided multiplication by constant
-	template<typename U, typename T>
-	vector<T> operator*(const U &, const vector<T> &)
-		noexcept(std::is_nothrow_constructible_v<vector<T>, size_t>);
-
 	// Allow vector to be printed
 	template<typename T>
 	std::ostream& operator<<(std::ostream &, const vector<T> &);
@@ -120,12 +133,69 @@ namespace la {
 		: m_dimension(other.m_dimension), m_matrix(std::forward<matrix<T>>(other.m_matrix))
 	{}
 
+	// Evaluate an elementwise expression in a single pass
+	template<typename T>
+	template<typename E>
+	vector<T>::vector(const matrix_expression<E> &expr)
+		: m_dimension(expr.rows()), m_matrix(expr.rows(), 1) {
+		static_assert(E::is_vector, "Can not construct vector from matrix expression.");
+		assign(m_matrix.m_entries, expr);
+	}
+
+	// Adopt or borrow storage
+	template<typename T>
+	vector<T>::vector(T *entries, size_t size, buffer mode) noexcept
+		: m_dimension(size), m_matrix(entries, size, 1, mode)
+	{}
+
 	// Return size of vector
 	template<typename T>
 	size_t vector<T>::size() const noexcept {
 		return m_dimension;
 	}
 
+	// Vectors are treated as single column
+	template<typename T>
+	size_t vector<T>::rows() const noexcept {
+		return m_dimension;
+	}
+
+	// Vectors are treated as single column
+	template<typename T>
+	size_t vector<T>::columns() const noexcept {
+		return 1;
+	}
+
+	// Unchecked access by index
+	template<typename T>
+	T vector<T>::eval(size_t i) const noexcept {
+		return m_matrix.m_entries[i];
+	}
+
+	// Getter for the storage
+	template<typename T>
+	T* vector<T>::data() noexcept {
+		return m_matrix.m_entries;
+	}
+
+	// Getter for the storage
+	template<typename T>
+	const T* vector<T>::data() const noexcept {
+		return m_matrix.m_entries;
+	}
+
+	// View of the whole vector
+	template<typename T>
+	vector_view<T> vector<T>::view() noexcept {
+		return vector_view<T>(m_matrix.m_entries, m_dimension);
+	}
+
+	// Read-only view of the whole vector
+	template<typename T>
+	vector_view<const T> vector<T>::view() const noexcept {
+		return vector_view<const T>(m_matrix.m_entries, m_dimension);
+	}
+
 	// Calculate the norm of the vector
 	template<typename T>
 	double vector<T>::norm() const {
@@ -190,108 +260,72 @@ namespace la {
 			throw std::runtime_error("Vectors can not differ in dimension.");
 		}
 
-		T scalar(0);
-		for (size_t i = 0; i < m_dimension; i++) { scalar += m_matrix(i, 0) * other.m_matrix(i, 0); }
-		return scalar;
+		const T *a = m_matrix.m_entries;
+		const T *b = other.m_matrix.m_entries;
+		if constexpr (simd_supported_v<T>) {
+			return simd_dot(a, b, m_dimension);
+		}
+		else {
+			T scalar(0);
+			for (size_t i = 0; i < m_dimension; i++) { scalar += a[i] * b[i]; }
+			return scalar;
+		}
 	}
 
-	// Multiply vector by a matrix
+	// Multiply vector by a matrix (may be multithreaded)
 	template<typename T>
-	vector<T> vector<T>::operator*(const matrix<T> &other) {
+	vector<T> vector<T>::operator*(const matrix<T> &other) const {
 		// Check for valid argument
 		if (m_dimension != other.m_rows) {
 			throw std::runtime_error("Size of vector has to match rows \
 									  of the matrix.");
 		}
 
-		// Create result vector
-		vector<T> v;
-		v.m_dimension = other.m_cols;
-		// Internally we only use row vectors so we temporarily transform it into a column
-		// vector for the calculation
-		m_matrix.m_cols = m_matrix.m_rows;
-		m_matrix.m_rows = 1;
-		// Now we can multiply them and adjust the dimensions accordingly
-		v.m_matrix = m_matrix * other;
-		v.m_matrix.m_rows = v.m_matrix.m_cols;
-		v.m_matrix.m_cols = 1;
-		// And reverse the original values
-		m_matrix.m_rows = m_matrix.m_cols;
-		m_matrix.m_cols = 1;
+		vector<T> v(other.m_cols);
+		gevm(m_dimension, other.m_cols, T(1), data(), 1, other.m_entries, other.m_cols, 1,
+			T(0), v.data(), 1);
 		return v;
 	}
 
-	// Multiply vector by constant
+	// Multiply by constant in place
 	template<typename T>
-	vector<T> vector<T>::operator*(const T &other) const
-		noexcept(std::is_nothrow_constructible_v<vector<T>, size_t>) {
-		vector<T> v(m_dimension);
-		v.m_matrix = m_matrix * other;
-		return v;
+	vector<T>& vector<T>::operator*=(const T &other) {
+		m_matrix *= other;
+		return *this;
 	}
 
-	// Divide vector by constant
+	// Divide by constant in place
 	template<typename T>
-	vector<T> vector<T>::operator/(const T &other) const
-		noexcept(std::is_nothrow_constructible_v<vector<T>, size_t>) {
-		vector<T> v(m_dimension);
-		v.m_matrix = m_matrix / other;
-		return v;
+	vector<T>& vector<T>::operator/=(const T &other) {
+		m_matrix /= other;
+		return *this;
 	}
 
-	// Add two vectors
+	// Add vector expression in place
 	template<typename T>
-	vector<T> vector<T>::operator+(const vector<T> &other) const {
+	template<typename E>
+	vector<T>& vector<T>::operator+=(const matrix_expression<E> &other) {
+		static_assert(E::is_vector, "Can not add matrix expression to vector.");
 		// Check for valid argument
-		if (m_dimension != other.m_dimension) {
+		if (m_dimension != other.rows()) {
 			throw std::runtime_error("Vectors can not differ in dimension.");
 		}
 
-		vector<T> v(m_dimension);
-		v.m_matrix = m_matrix + other.m_matrix;
-		return v;
+		assign(m_matrix.m_entries, *this + other.self());
+		return *this;
 	}
 
-	// Subtract two vectors
+	// Subtract vector expression in place
 	template<typename T>
-	vector<T> vector<T>::operator-(const vector<T> &other) const {
+	template<typename E>
+	vector<T>& vector<T>::operator-=(const matrix_expression<E> &other) {
+		static_assert(E::is_vector, "Can not subtract matrix expression from vector.");
 		// Check for valid argument
-		if (m_dimension != other.m_dimension) {
+		if (m_dimension != other.rows()) {
 			throw std::runtime_error("Vectors can not differ in dimension.");
 		}
 
-		vector<T> v(m_dimension);
-		v.m_matrix = m_matrix - other.m_matrix;
-		return v;
-	}
-
-	// Multiply by constant and assign result to *this
-	template<typename T>
-	vector<T>& vector<T>::operator*=(const T &other)
-		noexcept(std::is_nothrow_constructible_v<vector<T>, size_t>) {
-		*this = *this * other;
-		return *this;
-	}
-
-	// Divide by constant and assign result to *this
-	template<typename T>
-	vector<T>& vector<T>::operator/=(const T &other)
-		noexcept(std::is_nothrow_constructible_v<vector<T>, size_t>) {
-		*this = *this * other;
-		return *this;
-	}
-
-	// Add two vectors and assign result to *this
-	template<typename T>
-	vector<T>& vector<T>::operator+=(const vector<T> &other) {
-		*this = *this + other;
-		return *this;
-	}
-
-	// Subtract two vectors and assign result to *this
-	template<typename T>
-	vector<T>& vector<T>::operator-=(const vector<T> &other) {
-		*this = *this - other;
+		assign(m_matrix.m_entries, *this - other.self());
 		return *this;
 	}
 
@@ -316,6 +350,19 @@ namespace la {
 		return *this;
 	}
 
+	// Assign elementwise expression
+	template<typename T>
+	template<typename E>
+	vector<T>& vector<T>::operator=(const matrix_expression<E> &expr) {
+		static_assert(E::is_vector, "Can not assign matrix expression to vector.");
+		if (m_dimension != expr.rows()) {
+			m_dimension = expr.rows();
+			m_matrix = matrix<T>(m_dimension, 1);
+		}
+		assign(m_matrix.m_entries, expr);
+		return *this;
+	}
+
 	// Test two vectors for equality
 	template<typename T>
 	bool vector<T>::operator==(const vector<T> &other) const noexcept {
@@ -331,13 +378,6 @@ namespace la {
 		return true;
 	}
 
-	// Allow left handed multiplication by constant
-	template<typename U, typename T>
-	vector<T> operator*(const U &lhs, const vector<T> &v)
-		noexcept(std::is_nothrow_constructible_v<vector<T>, size_t>) {
-		return v * lhs;
-	}
-
 	// Test wise implementation
 	template<typename T>
 	std::ostream& operator<<(std::ostream &os, const vector<T> &v) {
@@ -0,0 +1,567 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Expression.hpp"
+#include "Gemm.hpp"
+#include "Gemv.hpp"
+#include "ThreadPool.hpp"
+
+namespace la {
+	template<typename T>
+	class vector_view;
+
+	// Non-owning view of a matrix stored anywhere in memory. Entry (i, j) lies at
+	// data[i * rowStride + j * columnStride], so submatrices, single rows or
+	// columns and the transpose are views of the same storage without copying.
+	// Views of const T are read-only. The viewed memory has to outlive the view.
+	//
+	// Views are elementwise expressions, assigning one to a matrix copies the
+	// entries. Assigning to a view writes through to the viewed storage, which
+	// must not overlap the right hand side other than entry by entry.
+	//
+	// Column-major storage, like that of Fortran code, is viewed without
+	// copying by passing layout::column_major. Assignments between views and
+	// matrices visit the entries in the order that suits the layouts of both
+	// sides, and the kernels of products choose their loops by the strides.
+	template<typename T>
+	class matrix_view : public matrix_expression<matrix_view<T>> {
+	private:
+		T *m_data = nullptr;
+
+		// Dimensions for the view
+		size_t m_rows = 0, m_cols = 0;
+
+		// Distance between entries of neighbouring rows and columns
+		size_t m_rowStride = 0, m_colStride = 0;
+
+		// Write op(entry, e.eval(i)) for all entries (may be multithreaded)
+		template<typename E, typename Op>
+		void update(const matrix_expression<E> &, Op);
+
+	public:
+		// Expression traits
+		using value_type = std::remove_const_t<T>;
+		static constexpr bool is_vector = false;
+		static constexpr bool is_leaf = false;
+
+		// Constructors
+
+		// View rows x columns entries starting at data with the given row and
+		// column stride
+		matrix_view(T *, size_t, size_t, size_t, size_t = 1) noexcept;
+		// View rows x columns contiguous entries stored in the given layout
+		matrix_view(T *, size_t, size_t, layout) noexcept;
+		// Copy constructor, views the same entries
+		matrix_view(const matrix_view &) = default;
+		// Views of mutable entries can be used as read-only views
+		template<typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+		matrix_view(const matrix_view<U> &) noexcept;
+
+		// Getter for the dimensions and layout
+		size_t rows() const noexcept;
+		size_t columns() const noexcept;
+		size_t row_stride() const noexcept;
+		size_t column_stride() const noexcept;
+		// Column-major if the entries of a column are contiguous and those of
+		// a row are not, otherwise row-major
+		layout storage_layout() const noexcept;
+		T* data() const noexcept;
+		// Unchecked access by row-major index used to evaluate expressions
+		value_type eval(size_t) const noexcept;
+		// Unchecked access for kernels
+		T& unchecked(size_t, size_t) const noexcept;
+
+		// Views of parts of the view
+		// Throw std::out_of_range if the part exceeds the view
+		matrix_view submatrix(size_t, size_t, size_t, size_t) const;
+		vector_view<T> row(size_t) const;
+		vector_view<T> column(size_t) const;
+		matrix_view transpose() const noexcept;
+
+		// Matrix algorithms
+		// Elimination needs a contiguous copy to work on, so these copy the
+		// viewed entries once
+		value_type determinant() const;
+		matrix<value_type> gauss() const;
+		matrix<value_type> invert() const;
+
+		// Overloaded operators
+
+		// Access operator
+		// Throws std::out_of_range for invalid indices
+		T& operator()(size_t, size_t) const;
+
+		// Assignment operators, write through to the viewed entries
+		// Throw std::runtime_error if the dimensions differ
+		matrix_view& operator=(const matrix_view &);
+		template<typename E>
+		matrix_view& operator=(const matrix_expression<E> &);
+		template<typename E>
+		matrix_view& operator+=(const matrix_expression<E> &);
+		template<typename E>
+		matrix_view& operator-=(const matrix_expression<E> &);
+		matrix_view& operator*=(const value_type &);
+		matrix_view& operator/=(const value_type &);
+	};
+
+	// Non-owning view of a vector, entry i lies at data[i * stride]. Same rules
+	// as for matrix_view apply.
+	template<typename T>
+	class vector_view : public matrix_expression<vector_view<T>> {
+	private:
+		T *m_data = nullptr;
+		size_t m_size = 0;
+		size_t m_stride = 0;
+
+		// Write op(entry, e.eval(i)) for all entries (may be multithreaded)
+		template<typename E, typename Op>
+		void update(const matrix_expression<E> &, Op);
+
+	public:
+		// Expression traits
+		using value_type = std::remove_const_t<T>;
+		static constexpr bool is_vector = true;
+		static constexpr bool is_leaf = false;
+
+		// Constructors
+
+		// View size entries starting at data with the given stride
+		vector_view(T *, size_t, size_t = 1) noexcept;
+		// Copy constructor, views the same entries
+		vector_view(const vector_view &) = default;
+		// Views of mutable entries can be used as read-only views
+		template<typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+		vector_view(const vector_view<U> &) noexcept;
+
+		// Getter for dimensions and layout
+		size_t size() const noexcept;
+		size_t rows() const noexcept;
+		size_t columns() const noexcept;
+		size_t stride() const noexcept;
+		T* data() const noexcept;
+		// Unchecked access by index used to evaluate expressions
+		value_type eval(size_t) const noexcept;
+		// Unchecked access for kernels
+		T& unchecked(size_t) const noexcept;
+
+		// Overloaded operators
+
+		// Access operator
+		// Throws std::out_of_range for invalid indices
+		T& operator[](size_t) const;
+
+		// Assignment operators, write through to the viewed entries
+		// Throw std::runtime_error if the dimensions differ
+		vector_view& operator=(const vector_view &);
+		template<typename E>
+		vector_view& operator=(const matrix_expression<E> &);
+		template<typename E>
+		vector_view& operator+=(const matrix_expression<E> &);
+		template<typename E>
+		vector_view& operator-=(const matrix_expression<E> &);
+		vector_view& operator*=(const value_type &);
+		vector_view& operator/=(const value_type &);
+	};
+
+	// Products of views run the blocked kernel directly on the viewed storage
+	// without copying (may be multithreaded)
+	// Throw std::runtime_error if the dimensions do not match
+	template<typename A, typename B>
+	matrix<std::remove_const_t<A>> operator*(const matrix_view<A> &, const matrix_view<B> &);
+	template<typename A, typename B>
+	matrix<A> operator*(const matrix<A> &, const matrix_view<B> &);
+	template<typename A, typename B>
+	matrix<std::remove_const_t<A>> operator*(const matrix_view<A> &, const matrix<B> &);
+	template<typename A, typename B>
+	vector<std::remove_const_t<A>> operator*(const matrix_view<A> &, const vector_view<B> &);
+	template<typename A, typename B>
+	vector<A> operator*(const matrix<A> &, const vector_view<B> &);
+	template<typename A, typename B>
+	vector<std::remove_const_t<A>> operator*(const matrix_view<A> &, const vector<B> &);
+
+	// Create view of existing storage
+	template<typename T>
+	matrix_view<T>::matrix_view(T *data, size_t rows, size_t cols, size_t rowStride,
+		size_t colStride) noexcept
+		: m_data(data), m_rows(rows), m_cols(cols), m_rowStride(rowStride), m_colStride(colStride)
+	{}
+
+	// Create view of contiguous storage, the leading dimension is the length of
+	// a row or column
+	template<typename T>
+	matrix_view<T>::matrix_view(T *data, size_t rows, size_t cols, layout order) noexcept
+		: matrix_view(data, rows, cols, order == layout::row_major ? cols : 1,
+			order == layout::row_major ? 1 : rows)
+	{}
+
+	// Convert view of mutable entries to read-only view
+	template<typename T>
+	template<typename U, typename>
+	matrix_view<T>::matrix_view(const matrix_view<U> &other) noexcept
+		: matrix_view(other.data(), other.rows(), other.columns(), other.row_stride(),
+			other.column_stride())
+	{}
+
+	// Getter for rows
+	template<typename T>
+	size_t matrix_view<T>::rows() const noexcept {
+		return m_rows;
+	}
+
+	// Getter for columns
+	template<typename T>
+	size_t matrix_view<T>::columns() const noexcept {
+		return m_cols;
+	}
+
+	// Getter for the row stride
+	template<typename T>
+	size_t matrix_view<T>::row_stride() const noexcept {
+		return m_rowStride;
+	}
+
+	// Getter for the column stride
+	template<typename T>
+	size_t matrix_view<T>::column_stride() const noexcept {
+		return m_colStride;
+	}
+
+	// Layout the strides describe
+	template<typename T>
+	layout matrix_view<T>::storage_layout() const noexcept {
+		return m_rowStride == 1 && m_colStride != 1 ? layout::column_major : layout::row_major;
+	}
+
+	// Getter for the first entry
+	template<typename T>
+	T* matrix_view<T>::data() const noexcept {
+		return m_data;
+	}
+
+	// Unchecked access by row-major index
+	template<typename T>
+	typename matrix_view<T>::value_type matrix_view<T>::eval(size_t i) const noexcept {
+		return m_data[i / m_cols * m_rowStride + i % m_cols * m_colStride];
+	}
+
+	// Unchecked access by row and column
+	template<typename T>
+	T& matrix_view<T>::unchecked(size_t i, size_t j) const noexcept {
+		return m_data[i * m_rowStride + j * m_colStride];
+	}
+
+	// View of the block with upper left entry (row, col)
+	template<typename T>
+	matrix_view<T> matrix_view<T>::submatrix(size_t row, size_t col, size_t rows, size_t cols) const {
+		// Check for valid argument
+		if (row + rows > m_rows || col + cols > m_cols) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+		return matrix_view(&unchecked(row, col), rows, cols, m_rowStride, m_colStride);
+	}
+
+	// View of a single row
+	template<typename T>
+	vector_view<T> matrix_view<T>::row(size_t i) const {
+		// Check for valid argument
+		if (i >= m_rows) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+		return vector_view<T>(&unchecked(i, 0), m_cols, m_colStride);
+	}
+
+	// View of a single column
+	template<typename T>
+	vector_view<T> matrix_view<T>::column(size_t j) const {
+		// Check for valid argument
+		if (j >= m_cols) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+		return vector_view<T>(&unchecked(0, j), m_rows, m_rowStride);
+	}
+
+	// Transposing a view only swaps dimensions and strides
+	template<typename T>
+	matrix_view<T> matrix_view<T>::transpose() const noexcept {
+		return matrix_view(m_data, m_cols, m_rows, m_colStride, m_rowStride);
+	}
+
+	// Calculate determinant of the viewed entries
+	template<typename T>
+	typename matrix_view<T>::value_type matrix_view<T>::determinant() const {
+		return matrix<value_type>(*this).determinant();
+	}
+
+	// Calculate row echelon form of the viewed entries
+	template<typename T>
+	matrix<typename matrix_view<T>::value_type> matrix_view<T>::gauss() const {
+		return matrix<value_type>(*this).gauss();
+	}
+
+	// Calculate inverse of the viewed entries
+	template<typename T>
+	matrix<typename matrix_view<T>::value_type> matrix_view<T>::invert() const {
+		return matrix<value_type>(*this).invert();
+	}
+
+	// Access entries of the view
+	template<typename T>
+	T& matrix_view<T>::operator()(size_t i, size_t j) const {
+		// Check for valid argument
+		if (i >= m_rows || j >= m_cols) {
+			throw std::out_of_range("Exceeded matrix range.");
+		}
+		return unchecked(i, j);
+	}
+
+	// Apply op to every viewed entry and the corresponding expression entry
+	template<typename T>
+	template<typename E, typename Op>
+	void matrix_view<T>::update(const matrix_expression<E> &expr, Op op) {
+		static_assert(!E::is_vector, "Can not assign vector expression to matrix.");
+
+		// Check for valid argument
+		if (m_rows != expr.rows() || m_cols != expr.columns()) {
+			throw std::runtime_error("Dimensions of matrices can not differ from each other.");
+		}
+
+		const E &e = expr.self();
+		for_each_entry(m_rows, m_cols, storage_layout(), expression_layout(e),
+			[this, &e, &op](size_t i, size_t j) { op(unchecked(i, j), e.eval(i * m_cols + j)); });
+	}
+
+	// Copy entries of another view
+	template<typename T>
+	matrix_view<T>& matrix_view<T>::operator=(const matrix_view<T> &other) {
+		return *this = static_cast<const matrix_expression<matrix_view<T>> &>(other);
+	}
+
+	// Assign elementwise expression to the viewed entries
+	template<typename T>
+	template<typename E>
+	matrix_view<T>& matrix_view<T>::operator=(const matrix_expression<E> &expr) {
+		update(expr, [](T &dst, const value_type &val) { dst = val; });
+		return *this;
+	}
+
+	// Add elementwise expression to the viewed entries
+	template<typename T>
+	template<typename E>
+	matrix_view<T>& matrix_view<T>::operator+=(const matrix_expression<E> &expr) {
+		update(expr, [](T &dst, const value_type &val) { dst += val; });
+		return *this;
+	}
+
+	// Subtract elementwise expression from the viewed entries
+	template<typename T>
+	template<typename E>
+	matrix_view<T>& matrix_view<T>::operator-=(const matrix_expression<E> &expr) {
+		update(expr, [](T &dst, const value_type &val) { dst -= val; });
+		return *this;
+	}
+
+	// Multiply viewed entries by constant
+	template<typename T>
+	matrix_view<T>& matrix_view<T>::operator*=(const value_type &other) {
+		update(*this, [&other](T &dst, const value_type &) { dst *= other; });
+		return *this;
+	}
+
+	// Divide viewed entries by constant
+	template<typename T>
+	matrix_view<T>& matrix_view<T>::operator/=(const value_type &other) {
+		update(*this, [&other](T &dst, const value_type &) { dst = dst / other; });
+		return *this;
+	}
+
+	// Create view of existing storage
+	template<typename T>
+	vector_view<T>::vector_view(T *data, size_t size, size_t stride) noexcept
+		: m_data(data), m_size(size), m_stride(stride)
+	{}
+
+	// Convert view of mutable entries to read-only view
+	template<typename T>
+	template<typename U, typename>
+	vector_view<T>::vector_view(const vector_view<U> &other) noexcept
+		: vector_view(other.data(), other.size(), other.stride())
+	{}
+
+	// Return size of view
+	template<typename T>
+	size_t vector_view<T>::size() const noexcept {
+		return m_size;
+	}
+
+	// Vectors are treated as single column
+	template<typename T>
+	size_t vector_view<T>::rows() const noexcept {
+		return m_size;
+	}
+
+	// Vectors are treated as single column
+	template<typename T>
+	size_t vector_view<T>::columns() const noexcept {
+		return 1;
+	}
+
+	// Getter for the stride
+	template<typename T>
+	size_t vector_view<T>::stride() const noexcept {
+		return m_stride;
+	}
+
+	// Getter for the first entry
+	template<typename T>
+	T* vector_view<T>::data() const noexcept {
+		return m_data;
+	}
+
+	// Unchecked access by index
+	template<typename T>
+	typename vector_view<T>::value_type vector_view<T>::eval(size_t i) const noexcept {
+		return m_data[i * m_stride];
+	}
+
+	// Unchecked access by index
+	template<typename T>
+	T& vector_view<T>::unchecked(size_t i) const noexcept {
+		return m_data[i * m_stride];
+	}
+
+	// Access entries of the view
+	template<typename T>
+	T& vector_view<T>::operator[](size_t index) const {
+		// Check for valid argument
+		if (index >= m_size) {
+			throw std::out_of_range("Exceeded vector range.");
+		}
+		return unchecked(index);
+	}
+
+	// Apply op to every viewed entry and the corresponding expression entry
+	template<typename T>
+	template<typename E, typename Op>
+	void vector_view<T>::update(const matrix_expression<E> &expr, Op op) {
+		static_assert(E::is_vector, "Can not assign matrix expression to vector.");
+		const size_t minEntriesPerTask = 1 << 15;
+
+		// Check for valid argument
+		if (m_size != expr.rows()) {
+			throw std::runtime_error("Vectors can not differ in dimension.");
+		}
+
+		const E &e = expr.self();
+		thread_pool::instance().parallel_for(0, m_size, minEntriesPerTask,
+			[this, &e, &op](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				op(unchecked(i), e.eval(i));
+			}
+		});
+	}
+
+	// Copy entries of another view
+	template<typename T>
+	vector_view<T>& vector_view<T>::operator=(const vector_view<T> &other) {
+		return *this = static_cast<const matrix_expression<vector_view<T>> &>(other);
+	}
+
+	// Assign elementwise expression to the viewed entries
+	template<typename T>
+	template<typename E>
+	vector_view<T>& vector_view<T>::operator=(const matrix_expression<E> &expr) {
+		update(expr, [](T &dst, const value_type &val) { dst = val; });
+		return *this;
+	}
+
+	// Add elementwise expression to the viewed entries
+	template<typename T>
+	template<typename E>
+	vector_view<T>& vector_view<T>::operator+=(const matrix_expression<E> &expr) {
+		update(expr, [](T &dst, const value_type &val) { dst += val; });
+		return *this;
+	}
+
+	// Subtract elementwise expression from the viewed entries
+	template<typename T>
+	template<typename E>
+	vector_view<T>& vector_view<T>::operator-=(const matrix_expression<E> &expr) {
+		update(expr, [](T &dst, const value_type &val) { dst -= val; });
+		return *this;
+	}
+
+	// Multiply viewed entries by constant
+	template<typename T>
+	vector_view<T>& vector_view<T>::operator*=(const value_type &other) {
+		update(*this, [&other](T &dst, const value_type &) { dst *= other; });
+		return *this;
+	}
+
+	// Divide viewed entries by constant
+	template<typename T>
+	vector_view<T>& vector_view<T>::operator/=(const value_type &other) {
+		update(*this, [&other](T &dst, const value_type &) { dst = dst / other; });
+		return *this;
+	}
+
+	// Multiply two views
+	template<typename A, typename B>
+	matrix<std::remove_const_t<A>> operator*(const matrix_view<A> &lhs, const matrix_view<B> &rhs) {
+		static_assert(std::is_same_v<std::remove_const_t<A>, std::remove_const_t<B>>,
+			"Can not multiply matrices of different types.");
+		// Check for valid argument
+		if (lhs.columns() != rhs.rows()) {
+			throw std::runtime_error("Can not multiply by a matrix which rows does not match the columns of the original matrix.");
+		}
+
+		matrix<std::remove_const_t<A>> m(lhs.rows(), rhs.columns());
+		gemm_parallel(lhs.rows(), rhs.columns(), lhs.columns(),
+			lhs.data(), lhs.row_stride(), lhs.column_stride(),
+			rhs.data(), rhs.row_stride(), rhs.column_stride(), m.data(), m.columns(), 1);
+		return m;
+	}
+
+	// Multiply matrix by view
+	template<typename A, typename B>
+	matrix<A> operator*(const matrix<A> &lhs, const matrix_view<B> &rhs) {
+		return lhs.view() * rhs;
+	}
+
+	// Multiply view by matrix
+	template<typename A, typename B>
+	matrix<std::remove_const_t<A>> operator*(const matrix_view<A> &lhs, const matrix<B> &rhs) {
+		return lhs * rhs.view();
+	}
+
+	// Multiply view by vector view
+	template<typename A, typename B>
+	vector<std::remove_const_t<A>> operator*(const matrix_view<A> &lhs, const vector_view<B> &rhs) {
+		static_assert(std::is_same_v<std::remove_const_t<A>, std::remove_const_t<B>>,
+			"Can not multiply matrices of different types.");
+		// Check for valid argument
+		if (lhs.columns() != rhs.size()) {
+			throw std::runtime_error("Can not multiply by a vector which dimension does not match the columns of the matrix.");
+		}
+
+		vector<std::remove_const_t<A>> v(lhs.rows());
+		gemv(lhs.rows(), lhs.columns(), std::remove_const_t<A>(1), lhs.data(), lhs.row_stride(), lhs.column_stride(),
+			rhs.data(), rhs.stride(), std::remove_const_t<A>(0), v.data(), 1);
+		return v;
+	}
+
+	// Multiply matrix by vector view
+	template<typename A, typename B>
+	vector<A> operator*(const matrix<A> &lhs, const vector_view<B> &rhs) {
+		return lhs.view() * rhs;
+	}
+
+	// Multiply view by vector
+	template<typename A, typename B>
+	vector<std::remove_const_t<A>> operator*(const matrix_view<A> &lhs, const vector<B> &rhs) {
+		return lhs * rhs.view();
+	}
+}
\ No newline at end of file